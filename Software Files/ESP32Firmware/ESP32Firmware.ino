@@ -10,8 +10,44 @@
 #include <BLEUtils.h>
 #include <BLE2902.h>
 
+#include "at_parser.h"
+#include "frame.h"
+#include "telemetry_queue.h"
+
+#include <time.h>
+
 #define DEVICE_ID "Esp32Device"
-#define MESSAGE_MAX_LEN 256
+#define MESSAGE_MAX_LEN 1024
+
+// Readings are collected into one cloud message per sampling cycle. A batch
+// is published when it holds batchSize readings or when the oldest reading
+// is batchDeadlineMs old, whichever comes first. A window summary is five
+// readings per channel, so the summaries of four channels fit one batch.
+#define BATCH_MAX_READINGS 20
+#define BATCH_NAME_LEN 32
+#define BATCH_VALUE_LEN 16
+
+// Readings that cannot be published are queued and replayed once the cloud
+// is reachable again, at most REPLAY_MAX_READINGS per message and one
+// message per replayIntervalMs. The RTC tier survives deep sleep; AT+sleep
+// moves the queue there first.
+#define QUEUE_RAM_READINGS 128
+#define QUEUE_RTC_READINGS 64
+#define REPLAY_MAX_READINGS 8
+// time(NULL) past 2020-01-01 means the clock has been set over SNTP
+#define CLOCK_VALID 1577836800UL
+
+// Nothing in loop() waits: connects, BLE re-advertising and baud changes are
+// state machines checked on every pass, so the Serial FIFO keeps being read.
+#define WIFI_CONNECT_TIMEOUT_MS 10000
+#define WIFI_RETRY_MS 30000
+#define BLE_READVERTISE_MS 500
+// long enough for the reply to AT+baud to leave at the old rate
+#define BAUD_SETTLE_MS 50
+// Direct methods and start/stop arrive when the MQTT client is polled.
+// Publishing polls it too, but with deadbands a publish may be 15 minutes
+// away.
+#define MQTT_CHECK_MS 1000
 
 #define SERVICE_UUID           "6E400001-B5A3-F393-E0A9-E50E24DCCA9E" // UART service UUID
 #define CHARACTERISTIC_UUID_RX "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
@@ -29,26 +65,86 @@ BLEServer *pServer = NULL;
 BLECharacteristic * pTxCharacteristic;
 bool deviceConnected = false;
 bool oldDeviceConnected = false;
+static bool bleReadvertise = false;
+static unsigned long bleDisconnected_ms;
 RTC_DATA_ATTR bool wifiMode = false;
 //
 
-String inputString = "";
-bool commandReady = false;
+AtParser atParser;
+
+// binary frame being received from the MSP430
+uint8_t frameBuffer[FRAME_MAX_SIZE];
+size_t frameLength = 0;
+// The MSP430 sends a frame in one go. A frame that stops for this many
+// character times lost a byte, or the MSP430 was reset in the middle of
+// it; it is dropped so it does not swallow the next command.
+#define FRAME_TIMEOUT_CHARS 10
+static unsigned long frameByte_us;
+// SEQ of the frame being handled, -1 for an AT command. The MSP430 keeps
+// several frames in flight and matches "OK <seq>" / "ERR <seq>: <reason>"
+// to them; it sends a frame again if the answer says "Bad frame" or does
+// not come.
+static int answerSeq = -1;
+// Frames forwarded last, SEQ << 16 | CRC. One that comes again had its
+// answer lost and is answered without forwarding it twice. The MSP430
+// starts again at SEQ 0 after a reset, so setting the mode, the first
+// thing it does after a reset, clears the table.
+#define RECENT_FRAMES 16
+static uint32_t recentFrames[RECENT_FRAMES];
+static bool recentValid[RECENT_FRAMES];
+static int recentNext = 0;
 
 /*String containing Hostname, Device Id & Device Key in the format:                         */
 /*  "HostName=<host_name>;DeviceId=<device_id>;SharedAccessKey=<device_key>"                */
 /*  "HostName=<host_name>;DeviceId=<device_id>;SharedAccessSignature=<device_sas_token>"    */
 RTC_DATA_ATTR char connectionString[256] = "\0";
 
-const char *messageData = "{\"deviceId\":\"%s\", \"messageId\":%d, \"%s\":%s}";
+const char *messageData = "{\"deviceId\":\"%s\", \"messageId\":%d";
+const char *messageReading = ", \"%s\":%s";
+const char *messageReplay = ", \"replay\":[";
+const char *messageEncrypted = ", \"encrypted\":\"%s\"}";
+const char *replayReading = "%s{\"age\":%lu, \"%s\":%s}";
+const char *replayReadingTs = "%s{\"age\":%lu, \"ts\":%lu, \"%s\":%s}";
 
 int messageCount = 1;
 RTC_DATA_ATTR bool hasSSID = false;
 RTC_DATA_ATTR bool hasPass = false;
 RTC_DATA_ATTR bool hasConnectionString = false;
 static bool hasWifi = false;
+enum WifiState { WIFI_IDLE, WIFI_CONNECTING, WIFI_CONNECTED };
+static WifiState wifiState = WIFI_IDLE;
+static unsigned long wifiChanged_ms;
+// set from the WiFi event task, handled in loop()
+static volatile bool wifiGotIp = false;
+static volatile bool wifiLost = false;
+// connect Azure as soon as WiFi is up
+static bool azurePending = false;
+static bool baudPending = false;
+static unsigned long baudRequested_ms;
+// longest time between two loop() passes, for AT+latency
+static unsigned long loopLatencyMax_us = 0;
+static unsigned long loopStarted_us = 0;
 static bool messageSending = true;
 static uint64_t send_interval_ms;
+static unsigned long mqttChecked_ms;
+
+struct Reading {
+  char name[BATCH_NAME_LEN];
+  char value[BATCH_VALUE_LEN];
+};
+RTC_DATA_ATTR int batchSize = BATCH_MAX_READINGS;
+RTC_DATA_ATTR unsigned long batchDeadlineMs = 500;
+static Reading batch[BATCH_MAX_READINGS];
+static int batchCount = 0;
+static unsigned long batchStarted_ms;
+static uint32_t batchStarted_s;
+
+static QueuedReading queueRam[QUEUE_RAM_READINGS];
+RTC_DATA_ATTR QueuedReading queueRtc[QUEUE_RTC_READINGS];
+RTC_DATA_ATTR QueueTier queueOverflow;
+static TelemetryQueue telemetryQueue;
+RTC_DATA_ATTR unsigned long replayIntervalMs = 1000;
+static unsigned long replayed_ms;
 
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -81,24 +177,70 @@ class MyCallbacks: public BLECharacteristicCallbacks {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Utilities
+void initAzure();
+
+static void WiFiEvent(WiFiEvent_t event)
+{
+  switch (event) {
+    case SYSTEM_EVENT_STA_GOT_IP:
+      wifiGotIp = true;
+      break;
+    case SYSTEM_EVENT_STA_DISCONNECTED:
+      wifiLost = true;
+      break;
+    default:
+      break;
+  }
+}
+
+// Starts connecting and returns, serviceWifi() follows up from loop()
 static void InitWifi()
 {
   Serial.println("Connecting...");
+  hasWifi = false;
+  wifiGotIp = false;
+  wifiLost = false;
   WiFi.begin((const char*)ssid, (const char*)password);
-  int count = 0;
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
-    if (++count > 20) {
-      Serial.println("ERR: Could not connect");
+  wifiState = WIFI_CONNECTING;
+  wifiChanged_ms = millis();
+}
+
+static void serviceWifi()
+{
+  if (wifiGotIp) {
+    wifiGotIp = false;
+    if (wifiState != WIFI_CONNECTED) {
+      wifiState = WIFI_CONNECTED;
+      hasWifi = true;
+      Serial.println("WiFi connected");
+      Serial.println("IP address: ");
+      Serial.println(WiFi.localIP());
+      if (azurePending) {
+        azurePending = false;
+        initAzure();
+      }
+    }
+  }
+  if (wifiLost) {
+    wifiLost = false;
+    if (wifiState == WIFI_CONNECTED) {
+      // the station reconnects by itself, give it the usual timeout
+      Serial.println("WiFi lost");
       hasWifi = false;
-      return;
+      wifiState = WIFI_CONNECTING;
+      wifiChanged_ms = millis();
     }
   }
-  hasWifi = true;
-  Serial.println("WiFi connected");
-  Serial.println("IP address: ");
-  Serial.println(WiFi.localIP());
+  if (wifiState == WIFI_CONNECTING && millis() - wifiChanged_ms >= WIFI_CONNECT_TIMEOUT_MS) {
+    Serial.println("ERR: Could not connect");
+    WiFi.disconnect();
+    wifiState = WIFI_IDLE;
+    wifiChanged_ms = millis();
+  }
+  if (wifiState == WIFI_IDLE && wifiMode && hasSSID && hasPass &&
+      millis() - wifiChanged_ms >= WIFI_RETRY_MS) {
+    InitWifi();
+  }
 }
 
 static void SendConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_RESULT result)
@@ -129,6 +271,37 @@ static void DeviceTwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsig
   free(temp);
 }
 
+// The MSP430 filters readings with per channel deadbands and keeps the
+// thresholds in FRAM. The "deadband" method payload is a JSON string
+// "channel,absolute,relative,heartbeat", passed on as a CFG+deadband line;
+// the MSP430 checks the ranges and applies it before its next report.
+// Its line buffer holds 40 characters with the prefix and a NUL.
+#define DEADBAND_CONFIG_MAX 26
+
+static bool forwardDeadband(const unsigned char *payload, int size)
+{
+  if (size >= 2 && payload[0] == '"' && payload[size - 1] == '"')
+  {
+    payload++;
+    size -= 2;
+  }
+  if (size == 0 || size > DEADBAND_CONFIG_MAX)
+  {
+    return false;
+  }
+  for (int i = 0; i < size; i++)
+  {
+    if (!isdigit(payload[i]) && payload[i] != ',')
+    {
+      return false;
+    }
+  }
+  Serial.print("CFG+deadband=");
+  Serial.write((const char *)payload, size);
+  Serial.print("\r\n");
+  return true;
+}
+
 static int  DeviceMethodCallback(const char *methodName, const unsigned char *payload, int size, unsigned char **response, int *response_size)
 {
   LogInfo("Try to invoke method %s", methodName);
@@ -145,6 +318,14 @@ static int  DeviceMethodCallback(const char *methodName, const unsigned char *pa
     LogInfo("Stop sending temperature and humidity data");
     messageSending = false;
   }
+  else if (strcmp(methodName, "deadband") == 0)
+  {
+    if (!forwardDeadband(payload, size))
+    {
+      responseMessage = "\"Expected channel,absolute,relative,heartbeat\"";
+      result = 400;
+    }
+  }
   else
   {
     LogInfo("No method %s found", methodName);
@@ -172,6 +353,377 @@ void readToEndChar(char terminal, char* string) {
   }
 }
 
+static bool publishMessage(const char *messagePayload) {
+  Serial.println(messagePayload);
+  EVENT_INSTANCE* message = Esp32MQTTClient_Event_Generate(messagePayload, MESSAGE);
+  Esp32MQTTClient_Event_AddProp(message, "temperatureAlert", "true");
+  send_interval_ms = millis();
+  return Esp32MQTTClient_SendEventInstance(message);
+}
+
+// Publishes the pending batch as one JSON document. The MSP430 already got
+// its OK for these readings: if the batch does not fit one message or the
+// publish fails they are kept for replay, which sends as many per message
+// as fit.
+static void flushBatch() {
+  if (batchCount == 0) {
+    return;
+  }
+  char messagePayload[MESSAGE_MAX_LEN];
+  int length = snprintf(messagePayload, MESSAGE_MAX_LEN, messageData, DEVICE_ID, messageCount++);
+  for (int i = 0; i < batchCount && length < MESSAGE_MAX_LEN; i++) {
+    length += snprintf(messagePayload + length, MESSAGE_MAX_LEN - length, messageReading, batch[i].name, batch[i].value);
+  }
+  bool published = false;
+  if (length < MESSAGE_MAX_LEN - 1) {
+    messagePayload[length++] = '}';
+    messagePayload[length] = '\0';
+    published = publishMessage(messagePayload);
+  } else {
+    // not an answer to the MSP430, so no "ERR" in front
+    Serial.println("Batch too long, queued for replay");
+  }
+  if (!published) {
+    for (int i = 0; i < batchCount; i++) {
+      TelemetryQueue_push(&telemetryQueue, batchStarted_s, batch[i].name, batch[i].value);
+    }
+  }
+  batchCount = 0;
+}
+
+// Publishes the oldest queued readings as one message, each with its age in
+// seconds and, once the clock is set, its original timestamp. They are only
+// removed from the queue if the publish was accepted.
+static void replayQueue() {
+  uint16_t queued = TelemetryQueue_count(&telemetryQueue);
+  uint32_t now = time(NULL);
+  char messagePayload[MESSAGE_MAX_LEN];
+  char entry[BATCH_NAME_LEN + BATCH_VALUE_LEN + 48];
+  int length = snprintf(messagePayload, MESSAGE_MAX_LEN, messageData, DEVICE_ID, messageCount++);
+  length += snprintf(messagePayload + length, MESSAGE_MAX_LEN - length, "%s", messageReplay);
+  uint16_t n;
+  for (n = 0; n < queued && n < REPLAY_MAX_READINGS; n++) {
+    const QueuedReading *reading = TelemetryQueue_peek(&telemetryQueue, n);
+    unsigned long age = now - reading->timestamp;
+    int entryLength;
+    if (now >= CLOCK_VALID) {
+      entryLength = snprintf(entry, sizeof(entry), replayReadingTs, n ? ", " : "", age,
+                             (unsigned long)reading->timestamp, reading->name, reading->value);
+    } else {
+      entryLength = snprintf(entry, sizeof(entry), replayReading, n ? ", " : "", age,
+                             reading->name, reading->value);
+    }
+    // leave room for "]}"
+    if (length + entryLength + 3 > MESSAGE_MAX_LEN) {
+      break;
+    }
+    memcpy(messagePayload + length, entry, entryLength);
+    length += entryLength;
+  }
+  snprintf(messagePayload + length, MESSAGE_MAX_LEN - length, "]}");
+  if (publishMessage(messagePayload)) {
+    TelemetryQueue_pop(&telemetryQueue, n);
+  }
+  replayed_ms = millis();
+}
+
+// Identifies the frame in frameBuffer for recentFrames
+static uint32_t frameId() {
+  return (uint32_t)frameBuffer[3] << 16 | frameBuffer[frameLength - 1] << 8 | frameBuffer[frameLength - 2];
+}
+
+static void forgetFrames() {
+  for (int i = 0; i < RECENT_FRAMES; i++) {
+    recentValid[i] = false;
+  }
+}
+
+// Answers the MSP430, text is "OK" or "ERR: <reason>". For a frame the SEQ
+// goes in after OK / ERR.
+static void answer(const char *text) {
+  if (answerSeq < 0) {
+    Serial.println(text);
+    return;
+  }
+  if (!strcmp(text, "OK")) {
+    recentFrames[recentNext] = frameId();
+    recentValid[recentNext] = true;
+    recentNext = (recentNext + 1) % RECENT_FRAMES;
+    Serial.printf("OK %d\r\n", answerSeq);
+  } else {
+    Serial.printf("ERR %d%s\r\n", answerSeq, text + 3);
+  }
+}
+
+// true if the frame in frameBuffer was forwarded before
+static bool recentFrame() {
+  uint32_t id = frameId();
+  for (int i = 0; i < RECENT_FRAMES; i++) {
+    if (recentValid[i] && recentFrames[i] == id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool cloudConnected() {
+  return hasWifi && WiFi.status() == WL_CONNECTED;
+}
+
+// Adds a reading to the pending batch, a reading for a channel already in
+// the batch replaces the older value
+static void batchAdd(const char *telemetry, const char *value) {
+  int i;
+  for (i = 0; i < batchCount; i++) {
+    if (!strcmp(batch[i].name, telemetry)) {
+      break;
+    }
+  }
+  if (i == batchCount) {
+    if (batchCount == 0) {
+      batchStarted_ms = millis();
+      batchStarted_s = time(NULL);
+    }
+    batchCount++;
+  }
+  strncpy(batch[i].name, telemetry, BATCH_NAME_LEN - 1);
+  batch[i].name[BATCH_NAME_LEN - 1] = '\0';
+  strncpy(batch[i].value, value, BATCH_VALUE_LEN - 1);
+  batch[i].value[BATCH_VALUE_LEN - 1] = '\0';
+  if (batchCount >= batchSize) {
+    flushBatch();
+  }
+}
+
+// true if the cloud stopped sending: a frame is refused whole with
+// "ERR: Stopped", live or replayed, and the MSP430 keeps its readings.
+// Queuing them instead would only move them into the replay queue.
+static bool cloudStopped() {
+  if (!wifiMode || !cloudConnected() || messageSending) {
+    return false;
+  }
+  Esp32MQTTClient_Check();
+  return !messageSending;
+}
+
+// Queues one reading for WiFi or publishes it over BLE, and answers the
+// MSP430. age is non zero for readings replayed from the MSP430 log; those
+// and anything arriving while offline go to the replay queue. Returns false
+// if the reading was rejected.
+static bool queueTelemetry(const char *telemetry, const char *value, uint32_t age) {
+  if (wifiMode) {
+    if (cloudStopped()) {
+      answer("ERR: Stopped");
+      return false;
+    } else if (cloudConnected() && age == 0) {
+      batchAdd(telemetry, value);
+      return true;
+    } else if (TelemetryQueue_push(&telemetryQueue, time(NULL) - age, telemetry, value)) {
+      return true;
+    } else {
+      // queue full, the MSP430 keeps it in its own log
+      answer("ERR: No wifi");
+      return false;
+    }
+  }
+  else {
+    char ble_message[BATCH_NAME_LEN + BATCH_VALUE_LEN + 16];
+    if (age) {
+      snprintf(ble_message, sizeof(ble_message), "%s=%s;age=%lu", telemetry, value, (unsigned long)age);
+    } else {
+      snprintf(ble_message, sizeof(ble_message), "%s=%s", telemetry, value);
+    }
+    Serial.println(ble_message);
+    if (deviceConnected) {
+      pTxCharacteristic->setValue(ble_message);
+      pTxCharacteristic->notify();
+      return true;
+    } else {
+      answer("ERR: Device not connected");
+      return false;
+    }
+  }
+}
+
+// true if count more readings fit the replay queue, so that a summary or a
+// block is queued whole or not at all. Only WiFi mode queues.
+static bool queueHasRoom(uint16_t count) {
+  return !wifiMode || TelemetryQueue_space(&telemetryQueue) >= count;
+}
+
+static void sendTelemetry(const char *telemetry, const char *value, uint32_t age) {
+  if (queueTelemetry(telemetry, value, age)) {
+    answer("OK");
+  }
+}
+
+static bool queueSummaryField(const char *telemetry, const char *suffix, const char *value) {
+  char name[BATCH_NAME_LEN];
+  snprintf(name, sizeof(name), "%s_%s", telemetry, suffix);
+  return queueTelemetry(name, value, 0);
+}
+
+// A window summary from the MSP430 goes out as five readings: the mean
+// under the channel name, then <name>_min, _max, _var and _n. The MSP430
+// gets one answer for the whole summary. Offline the five go to the replay
+// queue; if they do not all fit none is queued, the MSP430 logs the
+// summary and sends it again.
+#define SUMMARY_FIELDS 5
+
+static void sendSummary(const char *telemetry, const TelemetryFrame *frame) {
+  char value[16];
+  if (cloudStopped()) {
+    answer("ERR: Stopped");
+    return;
+  }
+  if (!cloudConnected() && !queueHasRoom(SUMMARY_FIELDS)) {
+    answer("ERR: No wifi");
+    return;
+  }
+  Frame_formatValue(frame->channel, frame->value, value, sizeof(value));
+  if (!queueTelemetry(telemetry, value, 0)) {
+    return;
+  }
+  Frame_formatValue(frame->channel, frame->min, value, sizeof(value));
+  if (!queueSummaryField(telemetry, "min", value)) {
+    return;
+  }
+  Frame_formatValue(frame->channel, frame->max, value, sizeof(value));
+  if (!queueSummaryField(telemetry, "max", value)) {
+    return;
+  }
+  Frame_formatVariance(frame->channel, frame->variance, value, sizeof(value));
+  if (!queueSummaryField(telemetry, "var", value)) {
+    return;
+  }
+  snprintf(value, sizeof(value), "%u", frame->count);
+  if (!queueSummaryField(telemetry, "n", value)) {
+    return;
+  }
+  answer("OK");
+}
+
+// Replayed readings from the MSP430 log, packed in a block frame. The block
+// is checked as a whole first, then every reading is queued with its age.
+// The MSP430 gets one answer for the block, and replays all of it again
+// after an ERR: the block is only taken if the queue has room for every
+// reading in it.
+static void sendBlock(const TelemetryFrame *frame) {
+  FrameBlockReader reader;
+  uint8_t channel;
+  uint16_t raw;
+  uint32_t age;
+  char value[16];
+  uint16_t queued = 0;
+
+  Frame_blockBegin(&reader, frame);
+  while (Frame_blockNext(&reader, &channel, &raw, &age)) {
+    // see queueTelemetry
+    if (age != 0 || !cloudConnected()) {
+      queued++;
+    }
+  }
+  if (!Frame_blockDone(&reader)) {
+    answer("ERR: Bad frame");
+    return;
+  }
+  if (cloudStopped()) {
+    answer("ERR: Stopped");
+    return;
+  }
+  if (!queueHasRoom(queued)) {
+    answer("ERR: No wifi");
+    return;
+  }
+  Frame_blockBegin(&reader, frame);
+  while (Frame_blockNext(&reader, &channel, &raw, &age)) {
+    Frame_formatValue(channel, raw, value, sizeof(value));
+    if (!queueTelemetry(Frame_channelName(channel), value, age)) {
+      return;
+    }
+  }
+  answer("OK");
+}
+
+// A frame the MSP430 encrypted goes out as it came, base64 coded in a
+// message of its own: only the cloud has the key. It cannot be queued, so
+// without a cloud connection it is refused and the MSP430 keeps the
+// readings in its log. Over BLE it is notified as encrypted=<base64>.
+static void sendEncrypted(const TelemetryFrame *frame) {
+  char encoded[FRAME_BASE64_SIZE];
+  char messagePayload[MESSAGE_MAX_LEN];
+  if (!Frame_base64(frame->sealed, frame->sealedLength, encoded, sizeof(encoded))) {
+    answer("ERR: Bad frame");
+    return;
+  }
+  if (!wifiMode) {
+    snprintf(messagePayload, MESSAGE_MAX_LEN, "encrypted=%s", encoded);
+    if (!deviceConnected) {
+      answer("ERR: Device not connected");
+      return;
+    }
+    pTxCharacteristic->setValue(messagePayload);
+    pTxCharacteristic->notify();
+    answer("OK");
+    return;
+  }
+  if (!cloudConnected()) {
+    answer("ERR: No wifi");
+    return;
+  }
+  if (cloudStopped()) {
+    answer("ERR: Stopped");
+    return;
+  }
+  int length = snprintf(messagePayload, MESSAGE_MAX_LEN, messageData, DEVICE_ID, messageCount++);
+  snprintf(messagePayload + length, MESSAGE_MAX_LEN - length, messageEncrypted, encoded);
+  if (!publishMessage(messagePayload)) {
+    answer("ERR: No wifi");
+    return;
+  }
+  answer("OK");
+}
+
+// Forwards a decoded frame and answers it
+static void forwardFrame(const TelemetryFrame *frame) {
+  char value[16];
+  if (frame->encrypted) {
+    sendEncrypted(frame);
+    return;
+  }
+  if (frame->block) {
+    sendBlock(frame);
+    return;
+  }
+  const char *telemetry = Frame_channelName(frame->channel);
+  if (telemetry == NULL || !Frame_formatValue(frame->channel, frame->value, value, sizeof(value))) {
+    answer("ERR: Unknown channel");
+    return;
+  }
+  if (frame->summary) {
+    sendSummary(telemetry, frame);
+    return;
+  }
+  sendTelemetry(telemetry, value, frame->age);
+}
+
+// Handles one complete binary frame, decoded in place in frameBuffer. The
+// SEQ is read before the CRC is checked: the MSP430 ignores an answer that
+// matches none of its frames, and sends a frame again for nothing at worst.
+static void handleFrame() {
+  TelemetryFrame frame;
+  answerSeq = frameBuffer[3];
+  if (!Frame_decode(frameBuffer, frameLength, &frame)) {
+    answer("ERR: Bad frame");
+  } else if (recentFrame()) {
+    answer("OK");
+  } else {
+    forwardFrame(&frame);
+  }
+  answerSeq = -1;
+}
+
+// Blocks inside the Azure library while it opens the MQTT connection
 void initAzure() {
   Esp32MQTTClient_SetOption(OPTION_MINI_SOLUTION_NAME, "GetStarted");
   Esp32MQTTClient_Init((const uint8_t*)connectionString, true);
@@ -216,6 +768,282 @@ void initBLE() {
   Serial.println("Waiting a client connection to notify...");
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AT commands
+static void atOk(const AtRequest *request) {
+  Serial.println("OK");
+}
+
+static void atUnknown(const AtRequest *request) {
+  Serial.println("?");
+}
+
+static void atSsid(const AtRequest *request) {
+  if (!request->hasArgs) {
+    Serial.println(ssid);
+    Serial.println("OK");
+    return;
+  }
+  if (!At_copy(request->args, ssid, sizeof(ssid))) {
+    Serial.println("?");
+    return;
+  }
+  hasSSID = true;
+  Serial.println("OK");
+  if (hasSSID && hasPass) {
+    InitWifi();
+  }
+}
+
+static void atPass(const AtRequest *request) {
+  if (!request->hasArgs) {
+    Serial.println(password);
+    Serial.println("OK");
+    return;
+  }
+  if (!At_copy(request->args, password, sizeof(password))) {
+    Serial.println("?");
+    return;
+  }
+  hasPass = true;
+  Serial.println("OK");
+  if (hasSSID && hasPass) {
+    InitWifi();
+  }
+}
+
+static void atConnString(const AtRequest *request) {
+  if (!request->hasArgs) {
+    Serial.println(connectionString);
+    Serial.println("OK");
+    return;
+  }
+  if (!At_copy(request->args, connectionString, sizeof(connectionString))) {
+    Serial.println("?");
+    return;
+  }
+  if (hasWifi) {
+    initAzure();
+  } else {
+    azurePending = true;
+  }
+  Serial.println("OK");
+}
+
+// Splits "<name>,<value>" and queues it, false if rejected
+static bool atQueueReading(AtSlice reading) {
+  char telemetry[BATCH_NAME_LEN];
+  char value[BATCH_VALUE_LEN];
+  AtSlice name = At_nextToken(&reading, ',');
+  if (!At_copy(name, telemetry, sizeof(telemetry)) || !At_copy(reading, value, sizeof(value))) {
+    Serial.println("?");
+    return false;
+  }
+  return queueTelemetry(telemetry, value, 0);
+}
+
+static void atTelemetry(const AtRequest *request) {
+  if (!request->hasArgs) {
+    Serial.println("?");
+    return;
+  }
+  if (atQueueReading(request->args)) {
+    Serial.println("OK");
+  }
+}
+
+// AT+batch=<name>,<value>;<name>,<value>...
+static void atBatch(const AtRequest *request) {
+  if (!request->hasArgs) {
+    Serial.println("?");
+    return;
+  }
+  AtSlice rest = request->args;
+  while (rest.len > 0) {
+    if (!atQueueReading(At_nextToken(&rest, ';'))) {
+      return;
+    }
+  }
+  // one batch command is one sampling cycle
+  if (wifiMode) {
+    flushBatch();
+  }
+  Serial.println("OK");
+}
+
+static void atBatchSize(const AtRequest *request) {
+  long size;
+  if (!request->hasArgs) {
+    Serial.println(batchSize);
+    Serial.println("OK");
+    return;
+  }
+  if (!At_toLong(request->args, &size) || size < 1 || size > BATCH_MAX_READINGS) {
+    Serial.println("?");
+    return;
+  }
+  batchSize = size;
+  if (batchCount >= batchSize) {
+    flushBatch();
+  }
+  Serial.println("OK");
+}
+
+static void atBatchDeadline(const AtRequest *request) {
+  long deadline;
+  if (!request->hasArgs) {
+    Serial.println(batchDeadlineMs);
+    Serial.println("OK");
+    return;
+  }
+  if (!At_toLong(request->args, &deadline) || deadline < 0) {
+    Serial.println("?");
+    return;
+  }
+  batchDeadlineMs = deadline;
+  Serial.println("OK");
+}
+
+// AT+queue answers "<queued>,<rejected>"
+static void atQueue(const AtRequest *request) {
+  Serial.printf("%u,%lu\n", TelemetryQueue_count(&telemetryQueue), (unsigned long)telemetryQueue.rejected);
+  Serial.println("OK");
+}
+
+static void atReplayInterval(const AtRequest *request) {
+  long interval;
+  if (!request->hasArgs) {
+    Serial.println(replayIntervalMs);
+    Serial.println("OK");
+    return;
+  }
+  if (!At_toLong(request->args, &interval) || interval < 0) {
+    Serial.println("?");
+    return;
+  }
+  replayIntervalMs = interval;
+  Serial.println("OK");
+}
+
+static void atMode(const AtRequest *request) {
+  if (!request->hasArgs) {
+    if (wifiMode) {
+      Serial.println("0: WiFi mode");
+    } else {
+      Serial.println("1: BLE mode");
+    }
+    Serial.println("OK");
+    return;
+  }
+  if (request->args.len == 1 && request->args.ptr[0] == '0') {
+    wifiMode = true;
+    if (hasSSID && hasPass) {
+      InitWifi();
+      azurePending = connectionString[0] != '\0';
+    }
+  } else if (request->args.len == 1 && request->args.ptr[0] == '1') {
+    wifiMode = false;
+  } else {
+    Serial.println("?");
+    return;
+  }
+  forgetFrames();
+  Serial.println("OK");
+}
+
+static void atBaud(const AtRequest *request) {
+  long baud;
+  if (!request->hasArgs || !At_toLong(request->args, &baud) || baud <= 0) {
+    Serial.println("?");
+    return;
+  }
+  baud_rate = baud;
+  Serial.printf("Changing baud rate to %d\n", baud_rate);
+  Serial.println("OK");
+  // loop() switches once the reply is out
+  baudPending = true;
+  baudRequested_ms = millis();
+}
+
+// AT+latency answers the longest loop() pass in us, AT+latency=0 resets it
+static void atLatency(const AtRequest *request) {
+  if (request->hasArgs) {
+    loopLatencyMax_us = 0;
+  } else {
+    Serial.println(loopLatencyMax_us);
+  }
+  Serial.println("OK");
+}
+
+static void atSleep(const AtRequest *request) {
+  long timer_int;
+  if (!request->hasArgs || !At_toLong(request->args, &timer_int) || timer_int < 0) {
+    Serial.println("?");
+    return;
+  }
+  // The MSP430 has its OK for the pending batch and the queued readings
+  // and no longer logs them: only RTC memory keeps them over deep sleep.
+  // The ESP32 stays awake if they do not fit there.
+  if (wifiMode) {
+    if (TelemetryQueue_space(&telemetryQueue) < batchCount) {
+      Serial.println("ERR: Queue full");
+      return;
+    }
+    flushBatch();
+    if (!TelemetryQueue_persist(&telemetryQueue)) {
+      Serial.println("ERR: Queue full");
+      return;
+    }
+  }
+  esp_sleep_enable_timer_wakeup(timer_int * 1000000ULL);
+  Serial.printf("ESP32 set to sleep for %ld seconds\n", timer_int);
+  Serial.println("Going to sleep now");
+  Serial.flush();
+  esp_deep_sleep_start();
+}
+
+// Lookup goes through the parser's hash index, order does not matter
+static const AtCommand atCommands[] = {
+  { "",             atOk },
+  { "ssid",         atSsid },
+  { "pass",         atPass },
+  { "connString",   atConnString },
+  { "telemetry",    atTelemetry },
+  { "batch",        atBatch },
+  { "batchSize",    atBatchSize },
+  { "batchDeadline", atBatchDeadline },
+  { "queue",        atQueue },
+  { "replayInterval", atReplayInterval },
+  { "mode",         atMode },
+  { "baud",         atBaud },
+  { "latency",      atLatency },
+  { "sleep",        atSleep },
+};
+
+// Routes one byte from the MSP430 to the frame decoder or the AT parser
+static void receiveByte(uint8_t inChar) {
+  // a sync byte between commands starts a binary frame
+  if (frameLength > 0 || (inChar == FRAME_SYNC && AtParser_isIdle(&atParser))) {
+    frameBuffer[frameLength++] = inChar;
+    frameByte_us = micros();
+    if (frameLength >= FRAME_HEADER_SIZE) {
+      size_t expected = Frame_expectedLength(frameBuffer, frameLength);
+      if (expected == 0) {
+        // not a frame header, resynchronize on the next sync byte
+        frameLength = 0;
+      } else if (frameLength == expected) {
+        handleFrame();
+        frameLength = 0;
+      }
+    }
+    return;
+  }
+  if (AtParser_push(&atParser, inChar)) {
+    Serial.println(AtParser_line(&atParser));
+    AtParser_dispatch(&atParser);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Arduino sketch
 void setup()
@@ -223,13 +1051,15 @@ void setup()
   Serial.begin(baud_rate);
   Serial.println("ESP32 Device");
   Serial.println("Initializing...");
+  AtParser_init(&atParser, atCommands, sizeof(atCommands) / sizeof(atCommands[0]), atUnknown);
+  TelemetryQueue_init(&telemetryQueue, queueRam, QUEUE_RAM_READINGS,
+                      &queueOverflow, queueRtc, QUEUE_RTC_READINGS);
   initBLE();
   hasWifi = false;
+  WiFi.onEvent(WiFiEvent);
   if (hasSSID && hasPass && wifiMode) {
     InitWifi();
-    if(connectionString[0] != '\0'){
-      initAzure();
-    }
+    azurePending = connectionString[0] != '\0';
   }
   randomSeed(analogRead(0));
   send_interval_ms = millis();
@@ -237,172 +1067,59 @@ void setup()
 
 void loop()
 {
-  while (Serial.available()) {
-    //
-    char inChar = (char)Serial.read();
-    //
-    inputString += inChar;
-    //
-    if (inChar == '\r') {
-      commandReady = true;
-    }
+  uint8_t rx[64];
+  int available;
+  unsigned long now_us = micros();
+  if (loopStarted_us != 0 && now_us - loopStarted_us > loopLatencyMax_us) {
+    loopLatencyMax_us = now_us - loopStarted_us;
   }
-
-  if (commandReady) {
-    commandReady = false;
-    int i;
-    int j = 0;
-    char command[256];
-    for (i = 0; inputString[i] != '\0'; i++) {
-      command[i] = inputString[i];
+  loopStarted_us = now_us;
+  while ((available = Serial.available()) > 0) {
+    size_t n = Serial.readBytes(rx, available < (int)sizeof(rx) ? available : sizeof(rx));
+    for (size_t i = 0; i < n; i++) {
+      receiveByte(rx[i]);
     }
-    command[i] = '\0';
-    Serial.println(command);
-    inputString = "";
-    if (!strcmp("AT\r", command)) {
-      Serial.println("OK");
-    } else if (!strncmp("AT+ssid\r", (const char*)command, 8)) {
-      Serial.println(ssid);
-      Serial.println("OK");
-    } else if (!strncmp("AT+ssid=", (const char*)command, 8)) {
-      for (i = 8; command[i] != '\r'; i++) {
-        ssid[j++] = command[i];
-      }
-      ssid[j] = '\0';
-      hasSSID = true;
-      Serial.println("OK");
-      if (hasSSID && hasPass) {
-        InitWifi();
-      }
-    } else if (!strncmp("AT+pass\r", (const char*)command, 8)) {
-      Serial.println(password);
-      Serial.println("OK");
-    } else if (!strncmp("AT+pass=", (const char*)command, 8)) {
-      for (i = 8; command[i] != '\r'; i++) {
-        password[j++] = command[i];
-      }
-      password[j] = '\0';
-      hasPass = true;
-      Serial.println("OK");
-      if (hasSSID && hasPass) {
-        InitWifi();
-      }
-    } else if (!strncmp("AT+connString\r", command, 14)) {
-      Serial.println(connectionString);
-      Serial.println("OK");
-    } else if (!strncmp("AT+connString=", command, 14)) {
-      for (i = 14; command[i] != '\r'; i++) {
-        connectionString[j++] = command[i];
-      }
-      connectionString[j] = '\0';
-      initAzure();
-      Serial.println("OK");
-    } else if (!strncmp("AT+telemetry=", command, 13)) {
-      char telemetry[32];
-      for (i = 13; command[i] != ','; i++) {
-        telemetry[j++] = command[i];
-      }
-      telemetry[j] = '\0';
-      j = 0;
-      char value[32];
-      i++;
-      while (command[i] != '\r') {
-        value[j++] = command[i++];
-      }
-      value[j] = '\0';
-      if (wifiMode) {
-        char messagePayload[MESSAGE_MAX_LEN];
-        snprintf(messagePayload, MESSAGE_MAX_LEN, messageData, DEVICE_ID, messageCount++, telemetry, value);
-        if (hasWifi) {
-          if (messageSending) {
-            Serial.println(messagePayload);
-            EVENT_INSTANCE* message = Esp32MQTTClient_Event_Generate(messagePayload, MESSAGE);
-            Esp32MQTTClient_Event_AddProp(message, "temperatureAlert", "true");
-            Esp32MQTTClient_SendEventInstance(message);
-            send_interval_ms = millis();
-            Serial.println("OK");
-          }
-          else {
-            Esp32MQTTClient_Check();
-          }
-        } else {
-          Serial.println("ERR: No wifi");
-        }
-      }
-      else {
-        char ble_message[32];
-        sprintf(ble_message, "%s=%s", telemetry, value);
-        Serial.println(ble_message);
-        if (deviceConnected) {
-          pTxCharacteristic->setValue(ble_message);
-          pTxCharacteristic->notify();
-          Serial.println("OK");
-        } else {
-          Serial.println("ERR: Device not connected");
-        }
-      }
-    } else if (!strncmp("AT+mode\r", command, 8)) {
-      if (wifiMode) {
-        Serial.println("0: WiFi mode");
-      } else {
-        Serial.println("1: BLE mode");
-      }
-      Serial.println("OK");
-    } else if (!strncmp("AT+mode=", command, 8)) {
-      if (command[8] == '0') {
-        wifiMode = true;
-        if (hasSSID && hasPass) {
-          InitWifi();
-          if (hasWifi) {
-            initAzure();
-          }
-        }
-      } else if (command[8] == '1') {
-        wifiMode = false;
-      } else {
-        Serial.println("?");
-        return;
-      }
-      Serial.println("OK");
-    } else if (!strncmp("AT+baud=", command, 8)) {
-      String baud_rate_str = "";
-      for (i = 8; command[i] != '\r'; i++) {
-        baud_rate_str += command[i];
-      }
-      baud_rate = baud_rate_str.toInt();
-      Serial.printf("Changing baud rate to %d\n", baud_rate);
-      delay(50);
-      Serial.begin(baud_rate);
-      delay(50);
-      Serial.printf("Baud rate is now %d\n", baud_rate);
-      Serial.println("OK");
-    } else if (!strncmp("AT+sleep=", command, 9)) {
-      String timer = "";
-      for (i = 9; command[i] != '\r'; i++) {
-        timer += command[i];
-      }
-      int timer_int = timer.toInt();
-      esp_sleep_enable_timer_wakeup(timer_int * 1000000);
-      Serial.printf("ESP32 set to sleep for %d seconds\n", timer_int);
-      Serial.println("Going to sleep now");
-      Serial.flush();
-      esp_deep_sleep_start();
-    } else {
-      Serial.println("?");
-      return;
-    }
-
+  }
+  // only counted once the receive buffer is empty: bytes that waited there
+  // while loop() was busy are not a gap on the line
+  if (frameLength > 0 && micros() - frameByte_us >= FRAME_TIMEOUT_CHARS * 10000000UL / baud_rate) {
+    frameLength = 0;
+  }
+  // publish a partial batch once its oldest reading is due
+  if (batchCount > 0 && millis() - batchStarted_ms >= batchDeadlineMs) {
+    flushBatch();
+  }
+  // replay queued readings, rate limited so a reconnect does not cause a
+  // burst of publishes
+  if (wifiMode && messageSending && cloudConnected() && TelemetryQueue_count(&telemetryQueue) > 0 &&
+      millis() - replayed_ms >= replayIntervalMs) {
+    replayQueue();
+  }
+  serviceWifi();
+  if (wifiMode && cloudConnected() && millis() - mqttChecked_ms >= MQTT_CHECK_MS) {
+    mqttChecked_ms = millis();
+    Esp32MQTTClient_Check();
+  }
+  if (baudPending && millis() - baudRequested_ms >= BAUD_SETTLE_MS) {
+    baudPending = false;
+    Serial.updateBaudRate(baud_rate);
+    Serial.printf("Baud rate is now %d\n", baud_rate);
   }
   // disconnecting
   if (!deviceConnected && oldDeviceConnected) {
-    delay(500); // give the bluetooth stack the chance to get things ready
+    // give the bluetooth stack the chance to get things ready
+    bleReadvertise = true;
+    bleDisconnected_ms = millis();
+    oldDeviceConnected = deviceConnected;
+  }
+  if (bleReadvertise && millis() - bleDisconnected_ms >= BLE_READVERTISE_MS) {
+    bleReadvertise = false;
     pServer->startAdvertising(); // restart advertising
     Serial.println("start advertising");
-    oldDeviceConnected = deviceConnected;
   }
   // connecting
   if (deviceConnected && !oldDeviceConnected) {
-    // do stuff here on connecting
+    bleReadvertise = false;
     oldDeviceConnected = deviceConnected;
   }
 }
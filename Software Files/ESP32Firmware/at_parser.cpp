@@ -0,0 +1,172 @@
+#include "at_parser.h"
+
+#include <limits.h>
+#include <string.h>
+
+static uint8_t At_hash(const char *name, size_t len)
+{
+  // FNV-1a folded to the index size
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+  }
+  return (hash ^ (hash >> 16)) & (AT_INDEX_SIZE - 1);
+}
+
+bool AtParser_init(AtParser *parser, const AtCommand *commands, size_t count, AtHandler unknown)
+{
+  parser->commands = commands;
+  parser->commandCount = count;
+  parser->unknown = unknown;
+  parser->length = 0;
+  parser->overflow = false;
+  memset(parser->index, 0, sizeof(parser->index));
+  if (count >= AT_INDEX_SIZE) {
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    uint8_t slot = At_hash(commands[i].name, strlen(commands[i].name));
+    while (parser->index[slot] != 0) {
+      slot = (slot + 1) & (AT_INDEX_SIZE - 1);
+    }
+    parser->index[slot] = i + 1;
+  }
+  return true;
+}
+
+bool AtParser_push(AtParser *parser, char c)
+{
+  if (c == '\r') {
+    parser->line[parser->length] = '\0';
+    return true;
+  }
+  if (c == '\n' && parser->length == 0) {
+    // line feed left over from a CR LF terminator
+    return false;
+  }
+  // keep room for the terminator, drop the rest of an overlong line
+  if (parser->length < AT_LINE_MAX - 1) {
+    parser->line[parser->length++] = c;
+  } else {
+    parser->overflow = true;
+  }
+  return false;
+}
+
+bool AtParser_isIdle(const AtParser *parser)
+{
+  return parser->length == 0 && !parser->overflow;
+}
+
+const char *AtParser_line(const AtParser *parser)
+{
+  return parser->line;
+}
+
+static const AtCommand *AtParser_find(const AtParser *parser, AtSlice name)
+{
+  uint8_t slot = At_hash(name.ptr, name.len);
+  while (parser->index[slot] != 0) {
+    const AtCommand *command = &parser->commands[parser->index[slot] - 1];
+    if (strlen(command->name) == name.len && !memcmp(command->name, name.ptr, name.len)) {
+      return command;
+    }
+    slot = (slot + 1) & (AT_INDEX_SIZE - 1);
+  }
+  return NULL;
+}
+
+void AtParser_dispatch(AtParser *parser)
+{
+  AtRequest request;
+  const AtCommand *command = NULL;
+  request.line.ptr = parser->line;
+  request.line.len = parser->length;
+  request.name.ptr = parser->line + parser->length;
+  request.name.len = 0;
+  request.args = request.name;
+  request.hasArgs = false;
+
+  if (!parser->overflow && parser->length >= 2 && !memcmp(parser->line, "AT", 2)) {
+    if (parser->length == 2) {
+      command = AtParser_find(parser, request.name);
+    } else if (parser->line[2] == '+') {
+      const char *end = parser->line + parser->length;
+      const char *equals = (const char *)memchr(parser->line + 3, '=', parser->length - 3);
+      request.name.ptr = parser->line + 3;
+      request.name.len = (equals ? equals : end) - request.name.ptr;
+      if (equals) {
+        request.hasArgs = true;
+        request.args.ptr = equals + 1;
+        request.args.len = end - request.args.ptr;
+      }
+      command = AtParser_find(parser, request.name);
+    }
+  }
+
+  parser->length = 0;
+  parser->overflow = false;
+  if (command != NULL) {
+    command->handler(&request);
+  } else if (parser->unknown != NULL) {
+    parser->unknown(&request);
+  }
+}
+
+AtSlice At_nextToken(AtSlice *rest, char separator)
+{
+  AtSlice token = *rest;
+  const char *found = (const char *)memchr(rest->ptr, separator, rest->len);
+  if (found) {
+    token.len = found - rest->ptr;
+    rest->ptr = found + 1;
+    rest->len -= token.len + 1;
+  } else {
+    rest->ptr += rest->len;
+    rest->len = 0;
+  }
+  return token;
+}
+
+bool At_copy(AtSlice slice, char *dst, size_t size)
+{
+  if (slice.len >= size) {
+    return false;
+  }
+  memcpy(dst, slice.ptr, slice.len);
+  dst[slice.len] = '\0';
+  return true;
+}
+
+bool At_toLong(AtSlice slice, long *value)
+{
+  // accumulated unsigned so that LONG_MIN fits, checked before each step
+  unsigned long result = 0;
+  unsigned long limit = LONG_MAX;
+  bool negative = false;
+  size_t i = 0;
+  if (slice.len > 0 && slice.ptr[0] == '-') {
+    negative = true;
+    limit = (unsigned long)LONG_MAX + 1;
+    i++;
+  }
+  if (i == slice.len) {
+    return false;
+  }
+  for (; i < slice.len; i++) {
+    if (slice.ptr[i] < '0' || slice.ptr[i] > '9') {
+      return false;
+    }
+    unsigned long digit = slice.ptr[i] - '0';
+    if (result > (limit - digit) / 10) {
+      return false;
+    }
+    result = result * 10 + digit;
+  }
+  if (negative && result > 0) {
+    *value = -(long)(result - 1) - 1;
+  } else {
+    *value = (long)result;
+  }
+  return true;
+}
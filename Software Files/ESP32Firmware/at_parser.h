@@ -0,0 +1,70 @@
+// Fixed buffer AT command line assembler and table driven dispatcher.
+//
+// Bytes are fed in as they come off the UART. Complete lines are matched
+// against a constant command table through a small hash index, and the
+// handler gets slices pointing into the line buffer, nothing is copied or
+// allocated. No Arduino dependencies so this builds on a host as well.
+
+#ifndef AT_PARSER_H
+#define AT_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AT_LINE_MAX 256
+// must be a power of two larger than the command table
+#define AT_INDEX_SIZE 32
+
+// Part of the line buffer, not NUL terminated
+struct AtSlice {
+  const char *ptr;
+  size_t len;
+};
+
+// "AT+name=args\r" or the query form "AT+name\r". Plain "AT\r" has an
+// empty name.
+struct AtRequest {
+  AtSlice line;
+  AtSlice name;
+  AtSlice args;
+  bool hasArgs;
+};
+
+typedef void (*AtHandler)(const AtRequest *request);
+
+struct AtCommand {
+  const char *name;
+  AtHandler handler;
+};
+
+struct AtParser {
+  const AtCommand *commands;
+  size_t commandCount;
+  AtHandler unknown;
+  uint8_t index[AT_INDEX_SIZE];   // command number + 1, 0 is empty
+  char line[AT_LINE_MAX];
+  size_t length;
+  bool overflow;
+};
+
+// commands must outlive the parser. Returns false if the table does not
+// fit the index.
+bool AtParser_init(AtParser *parser, const AtCommand *commands, size_t count, AtHandler unknown);
+
+// Adds one byte, returns true once a complete line is waiting. The line
+// must then be handed to AtParser_dispatch before the next byte is pushed.
+bool AtParser_push(AtParser *parser, char c);
+bool AtParser_isIdle(const AtParser *parser);
+const char *AtParser_line(const AtParser *parser);
+
+// Runs the handler for the waiting line. Overlong lines and lines with no
+// matching command go to the unknown handler.
+void AtParser_dispatch(AtParser *parser);
+
+// Helpers for handlers working on slices
+AtSlice At_nextToken(AtSlice *rest, char separator);
+bool At_copy(AtSlice slice, char *dst, size_t size);
+// false if slice is not a decimal number that fits a long
+bool At_toLong(AtSlice slice, long *value);
+
+#endif
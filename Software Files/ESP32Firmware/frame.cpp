@@ -0,0 +1,162 @@
+#include "frame.h"
+#include "crc_soft.h"
+
+#include <stdio.h>
+
+struct ChannelInfo {
+  const char *name;
+  float scale;
+  float offset;
+};
+
+// Raw to engineering units, mirrors the old MSP430 string conversions:
+// SHT35 temperature in F and humidity in %RH, ADC readings as a percentage
+// of the calibrated maximum. The MSP430 oversamples the ADC and sends those
+// readings left aligned to 16 bits, so the 12 bit maxima are scaled by 16.
+static const ChannelInfo channels[CHANNEL_COUNT] = {
+  { "temperature", 315.0f / 65535.0f,  -49.0f },
+  { "humidity",    100.0f / 65535.0f,    0.0f },
+  { "moisture",    100.0f / (1100.0f * 16), 0.0f },
+  { "light",       100.0f / (3000.0f * 16), 0.0f },
+};
+
+size_t Frame_expectedLength(const uint8_t *frame, size_t length)
+{
+  if (length < FRAME_HEADER_SIZE || frame[0] != FRAME_SYNC) {
+    return 0;
+  }
+  size_t total = FRAME_HEADER_SIZE + frame[1];
+  if (frame[1] < FRAME_PAYLOAD_SIZE + FRAME_CRC_SIZE || total > FRAME_MAX_SIZE) {
+    return 0;
+  }
+  return total;
+}
+
+static uint32_t Frame_read32(const uint8_t *data)
+{
+  return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+         ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+bool Frame_decode(const uint8_t *frame, size_t length, TelemetryFrame *out)
+{
+  size_t total = Frame_expectedLength(frame, length);
+  if (total == 0 || length < total) {
+    return false;
+  }
+  size_t crcOffset = total - FRAME_CRC_SIZE;
+  uint16_t crc = frame[crcOffset] | (frame[crcOffset + 1] << 8);
+  if (CrcSoft_crc16(frame, crcOffset) != crc) {
+    return false;
+  }
+  out->channel = frame[2];
+  out->seq = frame[3];
+  out->value = frame[4] | (frame[5] << 8);
+  out->age = 0;
+  out->summary = false;
+  out->block = false;
+  out->encrypted = false;
+  if (out->channel == FRAME_ENCRYPTED) {
+    out->encrypted = true;
+    out->sealed = frame + FRAME_HEADER_SIZE;
+    out->sealedLength = crcOffset - FRAME_HEADER_SIZE;
+  } else if (out->channel == FRAME_BLOCK) {
+    out->block = true;
+    out->count = frame[4];
+    out->records = frame + FRAME_HEADER_SIZE + FRAME_BLOCK_HEADER;
+    out->recordsLength = crcOffset - FRAME_HEADER_SIZE - FRAME_BLOCK_HEADER;
+  } else if (frame[1] == FRAME_PAYLOAD_SIZE + FRAME_AGE_SIZE + FRAME_CRC_SIZE) {
+    out->age = Frame_read32(frame + 6);
+  } else if (frame[1] == FRAME_PAYLOAD_SIZE + FRAME_SUMMARY_SIZE + FRAME_CRC_SIZE) {
+    out->summary = true;
+    out->min = frame[6] | (frame[7] << 8);
+    out->max = frame[8] | (frame[9] << 8);
+    out->count = frame[10] | (frame[11] << 8);
+    out->variance = Frame_read32(frame + 12);
+  }
+  return true;
+}
+
+bool Frame_base64(const uint8_t *data, size_t length, char *out, size_t size)
+{
+  static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  if (size < (length + 2) / 3 * 4 + 1) {
+    return false;
+  }
+  for (size_t i = 0; i < length; i += 3) {
+    uint32_t group = (uint32_t)data[i] << 16;
+    if (i + 1 < length) {
+      group |= data[i + 1] << 8;
+    }
+    if (i + 2 < length) {
+      group |= data[i + 2];
+    }
+    *out++ = digits[group >> 18];
+    *out++ = digits[(group >> 12) & 0x3F];
+    *out++ = i + 1 < length ? digits[(group >> 6) & 0x3F] : '=';
+    *out++ = i + 2 < length ? digits[group & 0x3F] : '=';
+  }
+  *out = '\0';
+  return true;
+}
+
+void Frame_blockBegin(FrameBlockReader *reader, const TelemetryFrame *frame)
+{
+  reader->records = frame->records;
+  reader->length = frame->recordsLength;
+  reader->position = 0;
+  reader->remaining = frame->count;
+  for (int i = 0; i < CHANNEL_COUNT; i++) {
+    Delta_init(&reader->value[i]);
+  }
+  Delta_init(&reader->age);
+}
+
+bool Frame_blockNext(FrameBlockReader *reader, uint8_t *channel, uint16_t *value, uint32_t *age)
+{
+  uint32_t decoded;
+  if (reader->remaining == 0 || reader->position >= reader->length) {
+    return false;
+  }
+  *channel = reader->records[reader->position++];
+  if (*channel >= CHANNEL_COUNT ||
+      !Delta_get(&reader->value[*channel], &decoded, reader->records, &reader->position, reader->length) ||
+      !Delta_get(&reader->age, age, reader->records, &reader->position, reader->length)) {
+    return false;
+  }
+  *value = decoded;
+  reader->remaining--;
+  return true;
+}
+
+bool Frame_blockDone(const FrameBlockReader *reader)
+{
+  return reader->remaining == 0 && reader->position == reader->length;
+}
+
+const char *Frame_channelName(uint8_t channel)
+{
+  if (channel >= CHANNEL_COUNT) {
+    return NULL;
+  }
+  return channels[channel].name;
+}
+
+bool Frame_formatValue(uint8_t channel, uint16_t raw, char *value, size_t size)
+{
+  if (channel >= CHANNEL_COUNT) {
+    return false;
+  }
+  float engineering = raw * channels[channel].scale + channels[channel].offset;
+  return snprintf(value, size, "%.2f", engineering) < (int)size;
+}
+
+bool Frame_formatVariance(uint8_t channel, uint32_t variance, char *value, size_t size)
+{
+  if (channel >= CHANNEL_COUNT) {
+    return false;
+  }
+  float scale = channels[channel].scale;
+  // small variances need the exponent, %g gives a valid JSON number
+  return snprintf(value, size, "%.4g", variance * scale * scale) < (int)size;
+}
@@ -0,0 +1,114 @@
+// Binary telemetry frames from the MSP430, see uart/frame.h in Ex5_OutOfBox.
+//
+//   [SYNC][LEN][CHANNEL][SEQ][VALUE_L][VALUE_H]([AGE 4 bytes])[CRC_L][CRC_H]
+//
+// LEN counts the bytes after itself. CRC is CRC-16/CCITT-FALSE over
+// everything before it, computed by the MSP430 CRC16 module and checked
+// with crc_soft.h. AGE is only present on readings replayed from the
+// MSP430 FRAM log: seconds since the reading was taken, little endian.
+//
+// A window summary from the MSP430 statistics stage has the mean as VALUE
+// and carries MIN, MAX, COUNT (2 bytes each) and VARIANCE (4 bytes, raw
+// counts squared) in place of AGE.
+//
+// Readings replayed from the MSP430 FRAM log come packed in block frames:
+//
+//   [SYNC][LEN][FRAME_BLOCK][SEQ][COUNT][RECORDS...][CRC_L][CRC_H]
+//
+// Each record is a channel byte, the value and the age, coded with
+// delta.h. Every channel is its own value series, the ages of all records
+// are one series.
+//
+// With AES_CTR the MSP430 encrypts its frames. SEQ and the keystream
+// POSITION stay readable, the rest of the frame up to the CRC is
+// encrypted and only the cloud has the key:
+//
+//   [SYNC][LEN][FRAME_ENCRYPTED][SEQ][POSITION0..3][ENCRYPTED...][CRC_L][CRC_H]
+//
+// The CRC covers the encrypted bytes. Such frames are forwarded from
+// FRAME_ENCRYPTED up to the CRC as they are, base64 coded.
+// No Arduino dependencies so this builds on a host as well.
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "delta.h"
+
+#define FRAME_SYNC          0xA5
+#define FRAME_HEADER_SIZE   2
+#define FRAME_PAYLOAD_SIZE  4
+#define FRAME_AGE_SIZE      4
+#define FRAME_SUMMARY_SIZE  10
+#define FRAME_CRC_SIZE      2
+#define FRAME_BLOCK         0x80
+#define FRAME_BLOCK_HEADER  3
+#define FRAME_BLOCK_RECORDS 96
+#define FRAME_ENCRYPTED     0x40
+#define FRAME_ENCRYPTED_SIZE 5
+#define FRAME_MAX_SIZE      (FRAME_HEADER_SIZE + FRAME_BLOCK_HEADER + FRAME_BLOCK_RECORDS + FRAME_CRC_SIZE + \
+                             FRAME_ENCRYPTED_SIZE)
+// base64 of an encrypted frame without SYNC, LEN and CRC, NUL terminated
+#define FRAME_BASE64_SIZE   (((FRAME_MAX_SIZE - FRAME_HEADER_SIZE - FRAME_CRC_SIZE + 2) / 3) * 4 + 1)
+
+#define CHANNEL_TEMPERATURE 0
+#define CHANNEL_HUMIDITY    1
+#define CHANNEL_MOISTURE    2
+#define CHANNEL_LIGHT       3
+#define CHANNEL_COUNT       4
+
+struct TelemetryFrame {
+  uint8_t channel;
+  uint8_t seq;
+  uint16_t value;  // the mean for summaries
+  uint32_t age;  // 0 for live readings
+  bool summary;
+  uint16_t min;
+  uint16_t max;
+  uint16_t count;  // readings in a summary or a block
+  uint32_t variance;
+  bool block;
+  const uint8_t *records;  // block records, inside the decoded buffer
+  uint16_t recordsLength;
+  bool encrypted;
+  const uint8_t *sealed;  // encrypted frame from FRAME_ENCRYPTED up to the CRC
+  uint16_t sealedLength;
+};
+
+// Walks the records of a block frame
+struct FrameBlockReader {
+  const uint8_t *records;
+  uint16_t length;
+  uint16_t position;
+  uint16_t remaining;
+  DeltaState value[CHANNEL_COUNT];
+  DeltaState age;
+};
+
+// Total frame length announced by a header, 0 if the header is invalid.
+size_t Frame_expectedLength(const uint8_t *frame, size_t length);
+
+// Checks a complete frame in place and reads its fields, no copy of the
+// buffer is made. Returns false on a bad length or CRC.
+bool Frame_decode(const uint8_t *frame, size_t length, TelemetryFrame *out);
+
+// base64 of data, NUL terminated. Returns false if it does not fit in size.
+bool Frame_base64(const uint8_t *data, size_t length, char *out, size_t size);
+
+// Next reading of a block, false after the last one or on a malformed
+// record. Once false is returned after all count readings the block was
+// consumed exactly, see Frame_blockDone.
+void Frame_blockBegin(FrameBlockReader *reader, const TelemetryFrame *frame);
+bool Frame_blockNext(FrameBlockReader *reader, uint8_t *channel, uint16_t *value, uint32_t *age);
+bool Frame_blockDone(const FrameBlockReader *reader);
+
+// Name and engineering value of a channel reading, written as a JSON number
+// into value. Returns NULL for unknown channels.
+const char *Frame_channelName(uint8_t channel);
+bool Frame_formatValue(uint8_t channel, uint16_t raw, char *value, size_t size);
+// Variance in raw counts squared, in engineering units squared
+bool Frame_formatVariance(uint8_t channel, uint32_t variance, char *value, size_t size);
+
+#endif
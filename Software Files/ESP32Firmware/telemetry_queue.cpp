@@ -0,0 +1,132 @@
+#include "telemetry_queue.h"
+
+#include <string.h>
+
+static void Tier_reset(QueueTier *tier, QueuedReading *slots, uint16_t capacity)
+{
+  tier->slots = slots;
+  tier->capacity = capacity;
+  tier->head = 0;
+  tier->count = 0;
+}
+
+static QueuedReading *Tier_at(const QueueTier *tier, uint16_t index)
+{
+  return &tier->slots[(tier->head + index) % tier->capacity];
+}
+
+static QueuedReading *Tier_append(QueueTier *tier)
+{
+  if (tier->count == tier->capacity) {
+    return NULL;
+  }
+  return Tier_at(tier, tier->count++);
+}
+
+static void Tier_drop(QueueTier *tier)
+{
+  tier->head = (tier->head + 1) % tier->capacity;
+  tier->count--;
+}
+
+// Moves readings from the front of overflow to the back of RAM while RAM
+// has room; overflow only holds readings newer than RAM's, so the order is
+// kept. After a deep sleep RAM is empty and overflow is not.
+static void Queue_refill(TelemetryQueue *queue)
+{
+  QueuedReading *slot;
+  while (queue->overflow->count > 0 && (slot = Tier_append(&queue->ram)) != NULL) {
+    *slot = *Tier_at(queue->overflow, 0);
+    Tier_drop(queue->overflow);
+  }
+}
+
+static void Queue_copy(char *dst, const char *src, size_t size)
+{
+  strncpy(dst, src, size - 1);
+  dst[size - 1] = '\0';
+}
+
+void TelemetryQueue_init(TelemetryQueue *queue, QueuedReading *ramSlots, uint16_t ramCapacity,
+                         QueueTier *overflow, QueuedReading *overflowSlots, uint16_t overflowCapacity)
+{
+  Tier_reset(&queue->ram, ramSlots, ramCapacity);
+  queue->overflow = overflow;
+  queue->rejected = 0;
+  if (overflow->slots != overflowSlots || overflow->capacity != overflowCapacity ||
+      overflow->head >= overflowCapacity || overflow->count > overflowCapacity) {
+    Tier_reset(overflow, overflowSlots, overflowCapacity);
+  }
+}
+
+bool TelemetryQueue_push(TelemetryQueue *queue, uint32_t timestamp, const char *name, const char *value)
+{
+  QueuedReading *slot = NULL;
+  Queue_refill(queue);
+  // RAM only takes new readings while nothing newer waits in overflow
+  if (queue->overflow->count == 0) {
+    slot = Tier_append(&queue->ram);
+  }
+  if (slot == NULL) {
+    slot = Tier_append(queue->overflow);
+  }
+  if (slot == NULL) {
+    queue->rejected++;
+    return false;
+  }
+  slot->timestamp = timestamp;
+  Queue_copy(slot->name, name, sizeof(slot->name));
+  Queue_copy(slot->value, value, sizeof(slot->value));
+  return true;
+}
+
+uint16_t TelemetryQueue_count(const TelemetryQueue *queue)
+{
+  return queue->ram.count + queue->overflow->count;
+}
+
+uint16_t TelemetryQueue_space(const TelemetryQueue *queue)
+{
+  // TelemetryQueue_push refills RAM first, so every free slot counts
+  return queue->ram.capacity - queue->ram.count + queue->overflow->capacity - queue->overflow->count;
+}
+
+const QueuedReading *TelemetryQueue_peek(const TelemetryQueue *queue, uint16_t index)
+{
+  if (index < queue->ram.count) {
+    return Tier_at(&queue->ram, index);
+  }
+  index -= queue->ram.count;
+  if (index < queue->overflow->count) {
+    return Tier_at(queue->overflow, index);
+  }
+  return NULL;
+}
+
+void TelemetryQueue_pop(TelemetryQueue *queue, uint16_t count)
+{
+  while (count-- > 0 && TelemetryQueue_count(queue) > 0) {
+    if (queue->ram.count > 0) {
+      Tier_drop(&queue->ram);
+    } else {
+      Tier_drop(queue->overflow);
+    }
+  }
+  Queue_refill(queue);
+}
+
+bool TelemetryQueue_persist(TelemetryQueue *queue)
+{
+  QueueTier *overflow = queue->overflow;
+  if (queue->ram.count > overflow->capacity - overflow->count) {
+    return false;
+  }
+  // newest RAM reading first, each in front of the overflow head
+  while (queue->ram.count > 0) {
+    overflow->head = (overflow->head + overflow->capacity - 1) % overflow->capacity;
+    overflow->count++;
+    overflow->slots[overflow->head] = *Tier_at(&queue->ram, --queue->ram.count);
+  }
+  queue->ram.head = 0;
+  return true;
+}
@@ -0,0 +1,66 @@
+// Bounded queue for readings that could not be published right away.
+//
+// Two tiers of fixed slots supplied by the caller: a RAM tier and an
+// overflow tier meant for RTC memory, which survives deep sleep. The RAM
+// tier always holds the oldest readings; the overflow tier is only used
+// once RAM is full and is moved back into RAM as RAM has room, so the
+// scarce RTC slots are freed first. Before deep sleep TelemetryQueue_persist
+// moves the RAM tier into the overflow tier. No Arduino dependencies so
+// this builds on a host as well.
+
+#ifndef TELEMETRY_QUEUE_H
+#define TELEMETRY_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define QUEUE_NAME_LEN  16
+#define QUEUE_VALUE_LEN 12
+
+struct QueuedReading {
+  uint32_t timestamp;   // seconds, time(NULL) when the reading was taken
+  char name[QUEUE_NAME_LEN];
+  char value[QUEUE_VALUE_LEN];
+};
+
+// One ring of slots. Keep the overflow tier itself in RTC memory along with
+// its slots so its contents survive deep sleep.
+struct QueueTier {
+  QueuedReading *slots;
+  uint16_t capacity;
+  uint16_t head;
+  uint16_t count;
+};
+
+struct TelemetryQueue {
+  QueueTier ram;
+  QueueTier *overflow;
+  uint32_t rejected;
+};
+
+// The overflow tier is only reset if it does not match slots/capacity,
+// i.e. after power on, so readings queued before a deep sleep are kept.
+void TelemetryQueue_init(TelemetryQueue *queue, QueuedReading *ramSlots, uint16_t ramCapacity,
+                         QueueTier *overflow, QueuedReading *overflowSlots, uint16_t overflowCapacity);
+
+// Copies a reading in, names and values longer than the slot are cut.
+// Returns false if both tiers are full.
+bool TelemetryQueue_push(TelemetryQueue *queue, uint32_t timestamp, const char *name, const char *value);
+
+uint16_t TelemetryQueue_count(const TelemetryQueue *queue);
+
+// Readings that can still be pushed
+uint16_t TelemetryQueue_space(const TelemetryQueue *queue);
+
+// index 0 is the oldest reading, NULL past the end
+const QueuedReading *TelemetryQueue_peek(const TelemetryQueue *queue, uint16_t index);
+
+// Removes the count oldest readings
+void TelemetryQueue_pop(TelemetryQueue *queue, uint16_t count);
+
+// Moves the readings of the RAM tier into the overflow tier, ahead of the
+// ones there, so that all of them survive deep sleep. Returns false and
+// moves nothing if the overflow tier has no room for them.
+bool TelemetryQueue_persist(TelemetryQueue *queue);
+
+#endif
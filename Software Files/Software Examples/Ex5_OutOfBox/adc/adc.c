@@ -9,6 +9,12 @@
 uint16_t ADC_A3_value;
 uint16_t ADC_A4_value;
 
+static uint32_t sum_A3;
+static uint32_t sum_A4;
+static uint16_t sequences;
+static volatile bool ready = false;
+static volatile bool waiting = false;
+
 void ADC_initPorts(void) {
 	//Set P1.3 as Ternary Module Function Output.
 	/*
@@ -56,9 +62,10 @@ void init_ADC12B() {
 	 * Base address of ADC12B Module
 	 * For memory buffers 0-7 sample/hold for 64 clock cycles
 	 * For memory buffers 8-15 sample/hold for 4 clock cycles (default)
-	 * Disable Multiple Sampling
+	 * Enable Multiple Sampling, the repeated sequence runs back to back
+	 * and the longer hold leaves the ISR time to read each sequence
 	 */
-	ADC12_B_setupSamplingTimer(ADC12_B_BASE, ADC12_B_CYCLEHOLD_16_CYCLES,
+	ADC12_B_setupSamplingTimer(ADC12_B_BASE, ADC12_B_CYCLEHOLD_64_CYCLES,
 	ADC12_B_CYCLEHOLD_4_CYCLES,
 	ADC12_B_MULTIPLESAMPLESENABLE);
 
@@ -97,11 +104,43 @@ void init_ADC12B_memoryBuffer(uint8_t memoryBufferControlIndex,
 	}
 }
 
+// Sum of ADC_OVERSAMPLE 12 bit results down to 12 + ADC_OVERSAMPLE_BITS
+// bits, left aligned to 16 bits
+static uint16_t ADC_decimate(uint32_t sum) {
+	return (sum >> ADC_OVERSAMPLE_BITS) << (4 - ADC_OVERSAMPLE_BITS);
+}
+
+void ADC_startOversampling(void) {
+	sum_A3 = 0;
+	sum_A4 = 0;
+	sequences = 0;
+	ready = false;
+	ADC12_B_startConversion(ADC12_B_BASE, ADC12_B_MEMORY_0,
+	ADC12_B_REPEATED_SEQOFCHANNELS);
+}
+
+void ADC_waitResult(void) {
+	uint16_t state = __get_interrupt_state();
+	TRACE_BEGIN(TRACE_ADC_WAIT);
+	__disable_interrupt();
+	while (!ready) {
+		waiting = true;
+		__bis_SR_register(LPM0_bits + GIE);
+		__disable_interrupt();
+	}
+	__set_interrupt_state(state);
+	TRACE_END(TRACE_ADC_WAIT);
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
 #pragma vector=ADC12_VECTOR
 __interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(ADC12_VECTOR)))
+#endif
 void ADC12_ISR(void) {
-
-	switch (__even_in_range(ADC12IV, 34)) {
+	TRACE_ISR_BEGIN(TRACE_ISR_ADC12);
+	switch (__even_in_range(ADC12IV, ADC12IV__ADC12RDYIFG)) {
 	case 0:
 		break;                         // Vector  0:  No interrupt
 	case 2:
@@ -118,8 +157,20 @@ void ADC12_ISR(void) {
 
 		break;
 	case 14:						   // Vector 14:  ADC12BMEM1
-		ADC_A3_value = ADC12_B_getResults(ADC12_B_BASE, ADC12_B_MEMORY_0);
-		ADC_A4_value = ADC12_B_getResults(ADC12_B_BASE, ADC12_B_MEMORY_1);
+		// end of one A3/A4 sequence, the next one is already running
+		sum_A3 += ADC12_B_getResults(ADC12_B_BASE, ADC12_B_MEMORY_0);
+		sum_A4 += ADC12_B_getResults(ADC12_B_BASE, ADC12_B_MEMORY_1);
+		if (++sequences == ADC_OVERSAMPLE) {
+			ADC12_B_disableConversions(ADC12_B_BASE,
+			ADC12_B_PREEMPTCONVERSION);
+			ADC_A3_value = ADC_decimate(sum_A3);
+			ADC_A4_value = ADC_decimate(sum_A4);
+			ready = true;
+			if (waiting) {
+				waiting = false;
+				__bic_SR_register_on_exit(LPM0_bits);
+			}
+		}
 		break;
 	case 16:
 		break;                         // Vector 16:  ADC12BMEM2
@@ -186,37 +237,13 @@ void ADC12_ISR(void) {
 	default:
 		break;
 	}
+	TRACE_ISR_END(TRACE_ISR_ADC12);
 }
 
-void ADC_getPercentage(uint8_t buffer[], uint16_t value, uint16_t maximum) {
-	// convert to 32 bit integer and multiply by large number
-	uint32_t long_value = ((uint32_t) value) * 100000;
-	// divide by maximum to get "percentage"
-	uint32_t percentage = long_value / maximum;
-	// divide to get only two decimal places
-	percentage /= 10;
-
-	// use sprintf to convert to string form
-	uint16_t number_length = sprintf((char*) buffer, "%d", percentage);
-	// inserting the decimal point
-	uint16_t i;
-	int16_t j;
-	// this loop pads zeros to the beginning of the buffer to guarantee
-	// three digits before the decimal point is added
-	for (i = number_length; i < 3; i++) {
-		// move characters over by one
-		for (j = number_length; j >= 0; j--) {
-			buffer[j + 1] = buffer[j];
-		}
-		// add the zero to the start
-		buffer[0] = '0';
-	}
-	// insure terminal null at end of string
-	buffer[i + 1] = '\0';
-	// move over decimal places by one
-	buffer[i] = buffer[i - 1];
-	buffer[i - 1] = buffer[i - 2];
-	// insert decimal point
-	buffer[i - 2] = '.';
+void ADC_getPercentage(uint8_t buffer[], uint8_t size, uint16_t value,
+		uint32_t ratio) {
+	// "percentage" with two decimal places, ratio holds the division by
+	// the maximum
+	uint16_t percentage = Q_scale(value, ratio);
+	Format_fixed(buffer, size, percentage, 2);
 }
-
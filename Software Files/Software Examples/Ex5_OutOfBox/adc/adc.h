@@ -5,7 +5,9 @@
  *      Author: Caleb
  */
 #include "driverlib.h"
-#include <stdio.h>
+#include "format/format.h"
+#include "qmath/qmath.h"
+#include "trace/trace.h"
 
 #ifndef ADC_H_
 #define ADC_H_
@@ -14,10 +16,29 @@
 #define ADC
 #endif
 
+// Oversampling. The A3/A4 sequence is repeated ADC_OVERSAMPLE times in
+// hardware and the results are summed in the ISR, then decimated for
+// ADC_OVERSAMPLE_BITS extra bits: 1-4 bits for 4-256 samples, 13-16 bits
+// of effective resolution. The CPU is only woken for the final result.
+#define ADC_OVERSAMPLE_BITS (3)
+#define ADC_OVERSAMPLE (1 << (2 * ADC_OVERSAMPLE_BITS))
+
+// ADC_A3_value/ADC_A4_value are left aligned to 16 bits whatever the
+// oversampling; this scales a 12 bit reading to match.
+#define ADC_SCALE(value12) ((uint16_t) (value12) << 4)
+
+// ratio for ADC_getPercentage, hundredths of a percent of maximum. maximum
+// must be above 10000, i.e. a 12 bit calibration above 625 counts.
+#define ADC_PERCENT_RATIO(maximum) Q_RATIO(10000, maximum)
+
 void init_ADC12B(void);
 void init_ADC12B_memoryBuffer(uint8_t memoryBufferControlIndex,
 		uint8_t inputSourceSelect, uint16_t EOS, uint16_t IFG_mask, uint16_t IE_mask);
 void ADC_initPorts(void);
-void ADC_getPercentage(uint8_t buffer[], uint16_t value, uint16_t maximum);
+void ADC_getPercentage(uint8_t buffer[], uint8_t size, uint16_t value,
+		uint32_t ratio);
+void ADC_startOversampling(void);
+// LPM0 until the oversampled result is in ADC_A3_value/ADC_A4_value
+void ADC_waitResult(void);
 
 #endif /* ADC_H_ */
@@ -0,0 +1,186 @@
+/*
+ * aes_ctr.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "aes_ctr.h"
+#include "trace/trace.h"
+#include <string.h>
+
+// Stream position of the next unused keystream byte. Persistent variables
+// live in FRAM and keep their value across resets.
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma PERSISTENT(aes_position)
+static uint32_t aes_position = 0;
+#elif defined(__GNUC__)
+static uint32_t aes_position __attribute__((persistent)) = 0;
+#endif
+
+static uint32_t position;
+static uint8_t aes_mode;
+
+// AES_CTR_PIPELINE: ring[head] is the keystream byte at position, ready
+// bytes follow it. The ISR appends whole blocks at tail, next_block is
+// the counter of the next one.
+static uint8_t ring[AES_CTR_RING];
+static uint8_t head;
+static uint8_t tail;
+static volatile uint8_t ready;
+static uint32_t next_block;
+static volatile bool busy = false;
+static volatile bool waiting = false;
+
+// AES_CTR_BLOCKING: the last block computed, its other bytes are used by
+// the next call
+static uint8_t block[AES_CTR_BLOCK_SIZE];
+static uint32_t block_index;
+static bool block_valid = false;
+
+static void AesCtr_counter(uint8_t counter[], uint32_t index) {
+	memset(counter, 0, AES_CTR_BLOCK_SIZE - 4);
+	counter[12] = index >> 24;
+	counter[13] = (index >> 16) & 0xFF;
+	counter[14] = (index >> 8) & 0xFF;
+	counter[15] = index & 0xFF;
+}
+
+// Starts the next counter block if the ring has room for it. Called with
+// interrupts disabled or from the ISR.
+static void AesCtr_fill(void) {
+	uint8_t counter[AES_CTR_BLOCK_SIZE];
+
+	if (busy || ready > AES_CTR_RING - AES_CTR_BLOCK_SIZE)
+		return;
+	AesCtr_counter(counter, next_block);
+	AES256_startEncryptData(AES256_BASE, counter);
+	busy = true;
+}
+
+// High word first: a reset between the two writes leaves the position
+// ahead of the last byte used, never behind it.
+static void AesCtr_persist(void) {
+	uint16_t high = position >> 16;
+	uint16_t low = position & 0xFFFF;
+
+	FRAMCtl_write16(&high, (uint16_t*) &aes_position + 1, 1);
+	FRAMCtl_write16(&low, (uint16_t*) &aes_position, 1);
+}
+
+void AesCtr_init(const uint8_t key[AES_CTR_KEY_SIZE], uint8_t mode) {
+	uint16_t state = __get_interrupt_state();
+
+	__disable_interrupt();
+	AES256_disableInterrupt(AES256_BASE);
+	while (AES256_isBusy(AES256_BASE))
+		;
+	AES256_clearInterrupt(AES256_BASE);
+	busy = false;
+	AES256_setCipherKey(AES256_BASE, key, AES256_KEYLENGTH_256BIT);
+
+	// the rest of a partly used block is skipped, the ring starts on a
+	// block boundary
+	next_block = (aes_position + AES_CTR_BLOCK_SIZE - 1) / AES_CTR_BLOCK_SIZE;
+	position = next_block * AES_CTR_BLOCK_SIZE;
+	head = 0;
+	tail = 0;
+	ready = 0;
+	block_valid = false;
+	aes_mode = mode;
+	if (mode == AES_CTR_PIPELINE) {
+		AES256_enableInterrupt(AES256_BASE);
+		AesCtr_fill();
+	}
+	__set_interrupt_state(state);
+}
+
+static void AesCtr_applyBlocking(uint8_t data[], uint8_t length) {
+	uint8_t counter[AES_CTR_BLOCK_SIZE];
+	uint32_t index;
+	uint8_t i;
+
+	for (i = 0; i < length; i++) {
+		index = position / AES_CTR_BLOCK_SIZE;
+		if (!block_valid || block_index != index) {
+			AesCtr_counter(counter, index);
+			AES256_encryptData(AES256_BASE, counter, block);
+			block_index = index;
+			block_valid = true;
+		}
+		data[i] ^= block[position % AES_CTR_BLOCK_SIZE];
+		position++;
+	}
+}
+
+static void AesCtr_applyPipeline(uint8_t data[], uint8_t length) {
+	uint16_t state = __get_interrupt_state();
+	uint8_t i, n;
+
+	while (length > 0) {
+		__disable_interrupt();
+		while (ready == 0) {
+			AesCtr_fill();
+			waiting = true;
+			__bis_SR_register(LPM0_bits + GIE);
+			__disable_interrupt();
+		}
+		n = ready;
+		__set_interrupt_state(state);
+
+		// the ISR only writes past head + ready
+		if (n > length)
+			n = length;
+		if (n > AES_CTR_RING - head)
+			n = AES_CTR_RING - head;
+		for (i = 0; i < n; i++)
+			data[i] ^= ring[head + i];
+		head = (head + n) % AES_CTR_RING;
+		data += n;
+		length -= n;
+		position += n;
+
+		__disable_interrupt();
+		ready -= n;
+		AesCtr_fill();
+		__set_interrupt_state(state);
+	}
+}
+
+uint32_t AesCtr_apply(uint8_t data[], uint8_t length) {
+	uint32_t start = position;
+
+	if (aes_mode == AES_CTR_PIPELINE)
+		AesCtr_applyPipeline(data, length);
+	else
+		AesCtr_applyBlocking(data, length);
+	// before any of it leaves the MSP430
+	AesCtr_persist();
+	return start;
+}
+
+//******************************************************************************
+//
+//This is the AES256 interrupt vector service routine: one keystream block
+//is done.
+//
+//******************************************************************************
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=AES256_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(AES256_VECTOR)))
+#endif
+void AES256_ISR(void) {
+	TRACE_ISR_BEGIN(TRACE_ISR_AES256);
+	// reading the output clears AESRDYIFG
+	AES256_getDataOut(AES256_BASE, &ring[tail]);
+	tail = (tail + AES_CTR_BLOCK_SIZE) % AES_CTR_RING;
+	ready += AES_CTR_BLOCK_SIZE;
+	next_block++;
+	busy = false;
+	AesCtr_fill();
+	if (waiting) {
+		waiting = false;
+		__bic_SR_register_on_exit(LPM0_bits);
+	}
+	TRACE_ISR_END(TRACE_ISR_AES256);
+}
@@ -0,0 +1,44 @@
+/*
+ * aes_ctr.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "driverlib.h"
+
+#ifndef AES_CTR_H_
+#define AES_CTR_H_
+
+// AES-256 in counter mode on the AES256 accelerator, for frames to the
+// ESP32 (see Frame_encrypt). Counter block i is 12 zero bytes followed by
+// i, big endian; the keystream is their encryptions one after the other.
+// Data is XORed with the keystream from the current stream position on,
+// so the same call decrypts, and a frame carries the position of its
+// first byte.
+//
+// The position is kept in FRAM and never goes back, so no keystream byte
+// is used twice across resets. Loading the firmware again starts over at
+// 0: the key has to change with it. The 96 zero bits leave no room for a
+// per message nonce, so every device needs its own key.
+//
+// The AES256 module has no counter mode of its own, it encrypts the
+// counter blocks in ECB. With AES_CTR_PIPELINE the AES256 interrupt keeps
+// a ring of AES_CTR_RING keystream bytes filled ahead of use, while the
+// CPU sleeps or the DMA sends the previous frame; encrypting a frame is
+// then an XOR. AES_CTR_BLOCKING computes each block when it is needed,
+// waiting for AES256_encryptData.
+
+#define AES_CTR_KEY_SIZE    (32)
+#define AES_CTR_BLOCK_SIZE  (16)
+// keystream kept ready, a multiple of AES_CTR_BLOCK_SIZE
+#define AES_CTR_RING        (128)
+
+#define AES_CTR_BLOCKING    (0)
+#define AES_CTR_PIPELINE    (1)
+
+void AesCtr_init(const uint8_t key[AES_CTR_KEY_SIZE], uint8_t mode);
+// XORs data with the next length keystream bytes and returns the stream
+// position of the first one. Sleeps in LPM0 if the pipeline has not got
+// that far yet, so it must not be called from an ISR.
+uint32_t AesCtr_apply(uint8_t data[], uint8_t length);
+
+#endif /* AES_CTR_H_ */
@@ -0,0 +1,91 @@
+/*
+ * delta.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "delta.h"
+
+static uint32_t Delta_zigzag(uint32_t delta) {
+	// arithmetic shift of the sign without relying on signed right shifts
+	return (delta << 1) ^ ((delta & 0x80000000UL) ? 0xFFFFFFFFUL : 0);
+}
+
+static uint32_t Delta_unzigzag(uint32_t code) {
+	return (code >> 1) ^ ((code & 1) ? 0xFFFFFFFFUL : 0);
+}
+
+void Delta_init(DeltaState* state) {
+	state->previous = 0;
+	state->started = false;
+}
+
+bool Delta_put(DeltaState* state, uint32_t value, uint8_t out[],
+		uint16_t* length, uint16_t size) {
+	uint32_t code = state->started ?
+			Delta_zigzag(value - state->previous) : value;
+	uint16_t position = *length;
+
+	do {
+		if (position >= size)
+			return false;
+		out[position++] = (code & 0x7F) | ((code > 0x7F) ? 0x80 : 0);
+		code >>= 7;
+	} while (code != 0);
+
+	*length = position;
+	state->previous = value;
+	state->started = true;
+	return true;
+}
+
+bool Delta_get(DeltaState* state, uint32_t* value, const uint8_t in[],
+		uint16_t* position, uint16_t length) {
+	uint16_t index = *position;
+	uint32_t code = 0;
+	uint8_t shift = 0;
+	uint8_t data;
+
+	do {
+		if (index >= length || shift >= 7 * DELTA_VARINT_MAX)
+			return false;
+		data = in[index++];
+		code |= (uint32_t) (data & 0x7F) << shift;
+		shift += 7;
+	} while (data & 0x80);
+
+	*position = index;
+	*value = state->started ? state->previous + Delta_unzigzag(code) : code;
+	state->previous = *value;
+	state->started = true;
+	return true;
+}
+
+uint16_t Delta_encode(const uint16_t values[], uint16_t count, uint8_t out[],
+		uint16_t size) {
+	DeltaState state;
+	uint16_t length = 0;
+	uint16_t i;
+
+	Delta_init(&state);
+	for (i = 0; i < count; i++) {
+		if (!Delta_put(&state, values[i], out, &length, size))
+			return 0;
+	}
+	return length;
+}
+
+uint16_t Delta_decode(const uint8_t in[], uint16_t length, uint16_t values[],
+		uint16_t count) {
+	DeltaState state;
+	uint16_t position = 0;
+	uint32_t value;
+	uint16_t i;
+
+	Delta_init(&state);
+	for (i = 0; i < count; i++) {
+		if (!Delta_get(&state, &value, in, &position, length))
+			return 0;
+		values[i] = value;
+	}
+	return position;
+}
@@ -0,0 +1,61 @@
+/*
+ * delta.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef DELTA_H_
+#define DELTA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Block codec for sensor time series. The first value of a series is sent
+// as is, every further one as the difference to its predecessor. Values
+// are written as varints: 7 bits per byte, least significant group first,
+// the top bit set on all but the last byte. Differences are zigzag coded
+// first (0, -1, 1, -2, ... become 0, 1, 2, 3, ...), so a slowly varying
+// series costs about one byte per value.
+//
+// Differences wrap modulo 2^32, so any uint32_t series decodes exactly.
+//
+// Portable C without driverlib. Ex5_OutOfBox/codec and ESP32Firmware have
+// the same delta.c and delta.h, keep them in sync.
+
+// Longest varint of a 32 bit value
+#define DELTA_VARINT_MAX (5)
+
+// One series. Several series can share a buffer, each with its own state.
+typedef struct {
+	uint32_t previous;
+	bool started;
+} DeltaState;
+
+void Delta_init(DeltaState* state);
+
+// Appends value to out[*length], out holds size bytes. Returns false, with
+// *length unchanged, if it does not fit.
+bool Delta_put(DeltaState* state, uint32_t value, uint8_t out[],
+		uint16_t* length, uint16_t size);
+
+// Reads the next value at in[*position]. Returns false if in ends before
+// the varint does or the varint is longer than DELTA_VARINT_MAX.
+bool Delta_get(DeltaState* state, uint32_t* value, const uint8_t in[],
+		uint16_t* position, uint16_t length);
+
+// Whole series in one call. Delta_encode returns the bytes written, 0 if
+// they do not fit in size. Delta_decode returns the bytes read, 0 if in
+// does not hold count values.
+uint16_t Delta_encode(const uint16_t values[], uint16_t count, uint8_t out[],
+		uint16_t size);
+uint16_t Delta_decode(const uint8_t in[], uint16_t length, uint16_t values[],
+		uint16_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DELTA_H_ */
@@ -0,0 +1,77 @@
+/*
+ * crc_hw.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "crc_hw.h"
+
+static uint8_t crc_feed = CRC_FEED_DMA;
+
+void Crc_setFeed(uint8_t feed) {
+	crc_feed = feed;
+}
+
+// Software triggered block transfer of count words to input. The CPU is
+// halted until the last word is written, so the flag is set by the time
+// the first poll runs.
+static void Crc_feedDMA(uint16_t input, const uint16_t words[],
+		uint16_t count) {
+	DMA_initParam param = { 0 };
+	param.channelSelect = CRC_DMA_CHANNEL;
+	param.transferModeSelect = DMA_TRANSFER_BLOCK;
+	param.transferSize = count;
+	param.triggerSourceSelect = DMA_TRIGGERSOURCE_0;
+	param.transferUnitSelect = DMA_SIZE_SRCWORD_DSTWORD;
+	param.triggerTypeSelect = DMA_TRIGGER_RISINGEDGE;
+	DMA_init(&param);
+
+	DMA_setSrcAddress(CRC_DMA_CHANNEL, (uint32_t) (uintptr_t) words,
+	DMA_DIRECTION_INCREMENT);
+	DMA_setDstAddress(CRC_DMA_CHANNEL, input, DMA_DIRECTION_UNCHANGED);
+	DMA_enableTransfers(CRC_DMA_CHANNEL);
+	DMA_startTransfer(CRC_DMA_CHANNEL);
+	while (DMA_getInterruptStatus(CRC_DMA_CHANNEL) == DMA_INT_INACTIVE)
+		;
+	DMA_clearInterrupt(CRC_DMA_CHANNEL);
+}
+
+// Writes length bytes to the data input register at input in memory order
+static void Crc_feed(uint16_t input, const uint8_t data[], uint16_t length) {
+	const uint16_t* words;
+	uint16_t count;
+
+	if (crc_feed == CRC_FEED_BYTE) {
+		while (length--)
+			HWREG8(input) = *data++;
+		return;
+	}
+	// word accesses need an even address
+	if (length != 0 && ((uintptr_t) data & 1)) {
+		HWREG8(input) = *data++;
+		length--;
+	}
+	words = (const uint16_t*) data;
+	count = length / 2;
+	if (crc_feed == CRC_FEED_DMA && length >= CRC_DMA_MIN) {
+		Crc_feedDMA(input, words, count);
+		words += count;
+	} else {
+		while (count--)
+			HWREG16(input) = *words++;
+	}
+	if (length & 1)
+		HWREG8(input) = *(const uint8_t*) words;
+}
+
+// The bit reversed input takes each byte MSB first
+uint16_t Crc_crc16(const void* data, uint16_t length) {
+	CRC_setSeed(CRC_BASE, 0xFFFF);
+	Crc_feed(CRC_BASE + OFS_CRCDIRB, data, length);
+	return CRC_getResult(CRC_BASE);
+}
+
+uint32_t Crc_crc32(const void* data, uint16_t length) {
+	CRC32_setSeed(0xFFFFFFFF, CRC32_MODE);
+	Crc_feed(CRC32_BASE + OFS_CRC32DIW0, data, length);
+	return CRC32_getResult(CRC32_MODE) ^ 0xFFFFFFFFUL;
+}
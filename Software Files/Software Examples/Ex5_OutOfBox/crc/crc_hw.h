@@ -0,0 +1,42 @@
+/*
+ * crc_hw.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "driverlib.h"
+
+#ifndef CRC_HW_H_
+#define CRC_HW_H_
+
+// CRC service on the CRC16 and CRC32 modules for everything the firmware
+// sends or stores: frames to the ESP32 (Crc_crc16), sample log records and
+// the deadband configuration in FRAM (Crc_crc32). Both are catalogue CRCs,
+// crc/crc_soft.h computes the same in software:
+//
+//   Crc_crc16  CRC-16/CCITT-FALSE: poly 0x1021, seed 0xFFFF, MSB first
+//   Crc_crc32  CRC-32 as in zlib: poly 0x04C11DB7 reflected, seed and
+//              final XOR 0xFFFFFFFF
+//
+// The modules take 16 bits per write, low byte first, so data goes in a
+// word at a time straight from memory; only an odd first or last byte is
+// written on its own. With CRC_FEED_DMA, buffers of CRC_DMA_MIN bytes or
+// more are moved by a block transfer on CRC_DMA_CHANNEL instead, which
+// halts the CPU for 2 cycles per word. CRC_FEED_BYTE writes every byte on
+// its own, for comparison.
+//
+// Not reentrant: the main loop only, no ISR.
+
+#define CRC_DMA_CHANNEL     (DMA_CHANNEL_0)
+// shorter buffers are faster without the DMA setup
+#define CRC_DMA_MIN         (64)
+
+#define CRC_FEED_BYTE       (0)
+#define CRC_FEED_WORD       (1)
+#define CRC_FEED_DMA        (2)
+
+// CRC_FEED_DMA until changed
+void Crc_setFeed(uint8_t feed);
+uint16_t Crc_crc16(const void* data, uint16_t length);
+uint32_t Crc_crc32(const void* data, uint16_t length);
+
+#endif /* CRC_HW_H_ */
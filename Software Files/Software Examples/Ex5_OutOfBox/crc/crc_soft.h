@@ -0,0 +1,34 @@
+/*
+ * crc_soft.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CRC_SOFT_H_
+#define CRC_SOFT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The CRCs of crc/crc_hw.h in software, one table lookup per byte, for the
+// receiving side: the ESP32 checks frames with CrcSoft_crc16, the
+// simulation and the benchmarks check everything the firmware computes.
+//
+//   CrcSoft_crc16  CRC-16/CCITT-FALSE: poly 0x1021, seed 0xFFFF, MSB first
+//   CrcSoft_crc32  CRC-32 as in zlib: poly 0x04C11DB7 reflected, seed and
+//                  final XOR 0xFFFFFFFF
+//
+// Portable C without driverlib. Ex5_OutOfBox/crc and ESP32Firmware have
+// the same crc_soft.c and crc_soft.h, keep them in sync.
+
+uint16_t CrcSoft_crc16(const uint8_t data[], size_t length);
+uint32_t CrcSoft_crc32(const uint8_t data[], size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC_SOFT_H_ */
@@ -0,0 +1,121 @@
+/*
+ * deadband.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "deadband.h"
+#include "crc/crc_hw.h"
+
+#define DEADBAND_CONFIG_WORDS (sizeof(DeadbandConfig) / sizeof(uint16_t))
+
+// Persistent variables live in FRAM and keep their value across resets. A
+// fresh image has no valid CRC yet, Deadband_init writes it.
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma PERSISTENT(deadband_config)
+#pragma PERSISTENT(deadband_crc)
+static DeadbandConfig deadband_config[DEADBAND_CHANNELS] = DEADBAND_DEFAULTS;
+static uint32_t deadband_crc = 0;
+#elif defined(__GNUC__)
+static DeadbandConfig deadband_config[DEADBAND_CHANNELS]
+		__attribute__((persistent)) = DEADBAND_DEFAULTS;
+static uint32_t deadband_crc __attribute__((persistent)) = 0;
+#endif
+
+static const DeadbandConfig deadband_defaults[DEADBAND_CHANNELS] =
+		DEADBAND_DEFAULTS;
+
+// What was last sent per channel, a bit in sent means there is a value
+static uint16_t last_value[DEADBAND_CHANNELS];
+static uint32_t last_time[DEADBAND_CHANNELS];
+static uint8_t sent = 0;
+
+static uint32_t Deadband_crc(void) {
+	return Crc_crc32(deadband_config, sizeof(deadband_config));
+}
+
+static void Deadband_seal(void) {
+	uint32_t crc = Deadband_crc();
+	FRAMCtl_write32(&crc, &deadband_crc, 1);
+}
+
+void Deadband_init(void) {
+	if (deadband_crc == Deadband_crc())
+		return;
+	FRAMCtl_write16((uint16_t*) deadband_defaults,
+			(uint16_t*) deadband_config,
+			DEADBAND_CHANNELS * DEADBAND_CONFIG_WORDS);
+	Deadband_seal();
+}
+
+static bool Deadband_due(uint8_t channel, uint16_t value, uint32_t now) {
+	const DeadbandConfig* config = &deadband_config[channel];
+	uint16_t last = last_value[channel];
+	uint16_t change = (value > last) ? value - last : last - value;
+
+	if (!(sent & (1 << channel)))
+		return true;
+	if (config->heartbeat != 0
+			&& now - last_time[channel] >= config->heartbeat)
+		return true;
+	if (config->absolute == 0 && config->relative == 0)
+		return true;
+	if (config->absolute != 0 && change > config->absolute)
+		return true;
+	// |change| / last > relative / 1000 without a division
+	return config->relative != 0
+			&& (uint32_t) change * 1000 > (uint32_t) config->relative * last;
+}
+
+bool Deadband_check(uint8_t channel, uint16_t value, uint32_t now) {
+	if (!Deadband_due(channel, value, now))
+		return false;
+	last_value[channel] = value;
+	last_time[channel] = now;
+	sent |= 1 << channel;
+	return true;
+}
+
+// Parses a decimal number up to the next ',' or the end of the line.
+// Returns the position after it, or 0 if there is no number or it is larger
+// than 65535.
+static const uint8_t* Deadband_parse(const uint8_t* text, uint16_t* value) {
+	uint32_t result = 0;
+	const uint8_t* start = text;
+
+	while (*text >= '0' && *text <= '9') {
+		result = result * 10 + (*text++ - '0');
+		if (result > 0xFFFF)
+			return 0;
+	}
+	if (text == start || (*text != ',' && *text != '\0'))
+		return 0;
+	*value = result;
+	return (*text == ',') ? text + 1 : text;
+}
+
+bool Deadband_configure(const uint8_t line[]) {
+	static const char prefix[] = "CFG+deadband=";
+	const uint8_t* text = line;
+	uint16_t fields[1 + DEADBAND_CONFIG_WORDS];
+	DeadbandConfig config;
+	uint8_t i;
+
+	for (i = 0; prefix[i] != '\0'; i++) {
+		if (*text++ != (uint8_t) prefix[i])
+			return false;
+	}
+	for (i = 0; i < 1 + DEADBAND_CONFIG_WORDS; i++) {
+		if (*text == '\0' || (text = Deadband_parse(text, &fields[i])) == 0)
+			return false;
+	}
+	if (*text != '\0' || fields[0] >= DEADBAND_CHANNELS)
+		return false;
+
+	config.absolute = fields[1];
+	config.relative = fields[2];
+	config.heartbeat = fields[3];
+	FRAMCtl_write16((uint16_t*) &config,
+			(uint16_t*) &deadband_config[fields[0]], DEADBAND_CONFIG_WORDS);
+	Deadband_seal();
+	return true;
+}
@@ -0,0 +1,56 @@
+/*
+ * deadband.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "driverlib.h"
+
+#ifndef DEADBAND_H_
+#define DEADBAND_H_
+
+// Report on change. A reading is only sent when it moved away from the last
+// sent value of its channel by more than an absolute or a relative
+// threshold, or when the channel has been silent for its heartbeat time.
+// A zero disables that threshold; with both thresholds zero every reading
+// is sent.
+//
+// The thresholds are kept in FRAM and survive resets, with a CRC-32 over
+// all of them (crc/crc_hw.h). The ESP32 changes them with a configuration
+// line, see Deadband_configure. The last sent values are in RAM, so the
+// first reading after a reset always goes out.
+
+// channels, CHANNEL_* from frame.h
+#define DEADBAND_CHANNELS (4)
+
+typedef struct {
+	uint16_t absolute;	// raw counts
+	uint16_t relative;	// per mille of the last sent value
+	uint16_t heartbeat;	// longest silence in seconds
+} DeadbandConfig;
+
+// Defaults of a fresh FRAM image, in raw counts (see sht35.h and adc.h):
+// 0.2 C, 1 %RH, 1 % of the ADC range and 5 % of the last light reading,
+// with a heartbeat every 15 minutes.
+#define DEADBAND_HEARTBEAT_S (900)
+#define DEADBAND_DEFAULTS { \
+	{ 75, 0, DEADBAND_HEARTBEAT_S }, \
+	{ 655, 0, DEADBAND_HEARTBEAT_S }, \
+	{ 655, 0, DEADBAND_HEARTBEAT_S }, \
+	{ 0, 50, DEADBAND_HEARTBEAT_S } }
+
+// Checks the thresholds in FRAM and goes back to DEADBAND_DEFAULTS if the
+// CRC does not match: a fresh image, damaged FRAM, or a reset in the middle
+// of Deadband_configure, which loses all changes and not only that one.
+void Deadband_init(void);
+
+// Returns true if value is to be sent and then takes it as the last sent
+// value of channel. now is timer_getSeconds().
+bool Deadband_check(uint8_t channel, uint16_t value, uint32_t now);
+
+// Applies a configuration line from the ESP32:
+//   CFG+deadband=channel,absolute,relative,heartbeat
+// Returns false, and changes nothing, if the line is not one or a field is
+// out of range.
+bool Deadband_configure(const uint8_t line[]);
+
+#endif /* DEADBAND_H_ */
@@ -0,0 +1,55 @@
+/*
+ * format.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "format.h"
+
+#define FORMAT_DIGITS (10)
+
+static const uint32_t powers_of_ten[FORMAT_DIGITS] = { 1000000000, 100000000,
+		10000000, 1000000, 100000, 10000, 1000, 100, 10, 1 };
+
+uint8_t Format_fixed(uint8_t buffer[], uint8_t size, int32_t value,
+		uint8_t fraction) {
+	uint8_t digits[FORMAT_DIGITS];
+	uint8_t count = 0;
+	uint8_t length;
+	uint8_t i;
+	bool negative = value < 0;
+	uint32_t magnitude = negative ? -(uint32_t) value : (uint32_t) value;
+
+	if (fraction > FORMAT_FRACTION_MAX)
+		fraction = FORMAT_FRACTION_MAX;
+
+	for (i = 0; i < FORMAT_DIGITS; i++) {
+		// at most 9 subtractions per digit
+		uint8_t digit = '0';
+		while (magnitude >= powers_of_ten[i]) {
+			magnitude -= powers_of_ten[i];
+			digit++;
+		}
+		// drop leading zeros, but keep one integer digit and all of the
+		// fraction
+		if (count > 0 || digit != '0' || i >= FORMAT_DIGITS - 1 - fraction)
+			digits[count++] = digit;
+	}
+
+	length = negative + count + (fraction > 0);
+	if (length >= size) {
+		if (size > 0)
+			buffer[0] = '\0';
+		return 0;
+	}
+
+	length = 0;
+	if (negative)
+		buffer[length++] = '-';
+	for (i = 0; i < count; i++) {
+		if (i == count - fraction)
+			buffer[length++] = '.';
+		buffer[length++] = digits[i];
+	}
+	buffer[length] = '\0';
+	return length;
+}
@@ -0,0 +1,27 @@
+/*
+ * format.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+// Decimal formatting without sprintf. Digits are found by subtracting
+// powers of ten, so there is no division and no RTS printf in the image.
+
+// Most fraction digits Format_fixed supports
+#define FORMAT_FRACTION_MAX (9)
+// Longest result: sign, 10 digits, point and the terminating NUL
+#define FORMAT_SIZE (13)
+
+// Writes value / 10^fraction with exactly fraction digits after the point
+// and at least one before it, e.g. (-705, 2) gives "-7.05". Returns the
+// length without the NUL, or 0 with an empty string if it does not fit in
+// size bytes.
+uint8_t Format_fixed(uint8_t buffer[], uint8_t size, int32_t value,
+		uint8_t fraction);
+
+#endif /* FORMAT_H_ */
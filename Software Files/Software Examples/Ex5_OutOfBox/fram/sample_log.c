@@ -0,0 +1,91 @@
+/*
+ * sample_log.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sample_log.h"
+#include "crc/crc_hw.h"
+#include <stddef.h>
+
+#define SAMPLE_LOG_MASK (SAMPLE_LOG_SIZE - 1)
+#define SAMPLE_LOG_WORDS (sizeof(SampleRecord) / sizeof(uint32_t))
+
+// Persistent variables live in FRAM and keep their value across resets.
+// head and tail are free running like in the UART ring buffer.
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma PERSISTENT(sample_log)
+#pragma PERSISTENT(log_head)
+#pragma PERSISTENT(log_tail)
+static SampleRecord sample_log[SAMPLE_LOG_SIZE] = { 0 };
+static uint16_t log_head = 0;
+static uint16_t log_tail = 0;
+#elif defined(__GNUC__)
+static SampleRecord sample_log[SAMPLE_LOG_SIZE]
+		__attribute__((persistent)) = { 0 };
+static uint16_t log_head __attribute__((persistent)) = 0;
+static uint16_t log_tail __attribute__((persistent)) = 0;
+#endif
+
+// added to timer_getSeconds() so timestamps keep increasing across resets
+static uint32_t time_base = 0;
+
+static uint32_t SampleLog_crc(const SampleRecord* record) {
+	return Crc_crc32(record, offsetof(SampleRecord, crc));
+}
+
+static void SampleLog_setTail(uint16_t tail) {
+	FRAMCtl_write16(&tail, &log_tail, 1);
+}
+
+// After a power failure the indexes are still consistent because each is a
+// single word write, but a fresh or corrupted image can hold anything.
+void SampleLog_init(void) {
+	if ((uint16_t) (log_head - log_tail) > SAMPLE_LOG_SIZE) {
+		uint16_t zero = 0;
+		FRAMCtl_write16(&zero, &log_head, 1);
+		SampleLog_setTail(0);
+	}
+	SampleRecord newest;
+	if (SampleLog_peek(SampleLog_count() - 1, &newest))
+		time_base = newest.timestamp + 1;
+}
+
+void SampleLog_append(uint32_t timestamp, uint8_t channel, uint16_t value) {
+	SampleRecord record;
+	record.timestamp = time_base + timestamp;
+	record.channel = channel;
+	record.flags = 0;
+	record.value = value;
+	record.crc = SampleLog_crc(&record);
+
+	if (SampleLog_count() == SAMPLE_LOG_SIZE) {
+		// full, drop the oldest before its slot is reused
+		SampleLog_setTail(log_tail + 1);
+	}
+	FRAMCtl_write32((uint32_t*) &record,
+			(uint32_t*) &sample_log[log_head & SAMPLE_LOG_MASK],
+			SAMPLE_LOG_WORDS);
+	uint16_t head = log_head + 1;
+	FRAMCtl_write16(&head, &log_head, 1);
+}
+
+uint16_t SampleLog_count(void) {
+	return log_head - log_tail;
+}
+
+bool SampleLog_peek(uint16_t index, SampleRecord* record) {
+	if (index >= SampleLog_count())
+		return false;
+	*record = sample_log[(log_tail + index) & SAMPLE_LOG_MASK];
+	return record->crc == SampleLog_crc(record);
+}
+
+void SampleLog_discard(uint16_t count) {
+	if (count > SampleLog_count())
+		count = SampleLog_count();
+	SampleLog_setTail(log_tail + count);
+}
+
+uint32_t SampleLog_age(const SampleRecord* record, uint32_t now) {
+	return time_base + now - record->timestamp;
+}
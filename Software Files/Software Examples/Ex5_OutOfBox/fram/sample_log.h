@@ -0,0 +1,47 @@
+/*
+ * sample_log.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "driverlib.h"
+
+#ifndef SAMPLE_LOG_H_
+#define SAMPLE_LOG_H_
+
+// Store and forward log in FRAM. Readings taken while the ESP32 has no link
+// are appended here and replayed once it comes back. The log survives
+// resets and power loss; when it is full the oldest record is overwritten.
+//
+// Each record is sealed with a CRC-32 (crc/crc_hw.h). The record is
+// written first and the head index last, so a power failure in between
+// leaves the old head and the half written record is never seen. A record
+// whose CRC does not match is skipped on replay.
+
+// records, must be a power of 2
+#define SAMPLE_LOG_SIZE (256)
+// records replayed per sampling cycle once the link is back
+#define SAMPLE_LOG_BURST (32)
+
+typedef struct {
+	uint32_t timestamp;	// timer_getSeconds() when the reading was taken
+	uint8_t channel;	// CHANNEL_* from frame.h
+	uint8_t flags;		// reserved, 0
+	uint16_t value;		// raw sensor reading
+	uint32_t crc;		// CRC32 over the fields above
+} SampleRecord;
+
+// There is no calendar clock, timestamps are seconds since reset. After a
+// reset new records continue from the newest logged one, so replayed ages
+// stay ordered but do not include the time the board was off.
+void SampleLog_init(void);
+void SampleLog_append(uint32_t timestamp, uint8_t channel, uint16_t value);
+uint16_t SampleLog_count(void);
+// Copies the index-th oldest record. Returns false if there is no such
+// record or its CRC does not match.
+bool SampleLog_peek(uint16_t index, SampleRecord* record);
+// Frees the count oldest records
+void SampleLog_discard(uint16_t count);
+// Seconds between record and now (timer_getSeconds())
+uint32_t SampleLog_age(const SampleRecord* record, uint32_t now);
+
+#endif /* SAMPLE_LOG_H_ */
@@ -0,0 +1,122 @@
+/*
+ * i2c_bus.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "i2c_bus.h"
+#include "timers.h"
+
+// A command takes well under a millisecond at 400 kHz, this keeps the last
+// device in a burst from being read before its conversion is done
+#define I2C_BUS_COMMAND_MS (1)
+
+static I2C_Device* devices[I2C_BUS_DEVICES_MAX];
+static uint8_t device_count = 0;
+static volatile bool reads_scheduled = false;
+static volatile bool waiting = false;
+
+bool I2CBus_add(I2C_Device* device)
+{
+    if (device_count == I2C_BUS_DEVICES_MAX)
+        return false;
+    // first reading on the first cycle
+    device->countdown = 1;
+    device->due = false;
+    device->fresh = false;
+    devices[device_count++] = device;
+    return true;
+}
+
+static void I2CBus_submitRead(I2C_Device* device, bool withCommand)
+{
+    I2C_Transaction* t = &device->readTransaction;
+
+    t->address = device->address;
+    t->txData = device->command;
+    t->txLength = withCommand ? device->commandLength : 0;
+    t->rxData = device->data;
+    t->rxLength = device->readLength;
+    t->retries = I2C_RETRIES;
+    I2C_submit(t);
+}
+
+// Timer one shot, every conversion is done
+static bool I2CBus_readConverted(void)
+{
+    uint8_t i;
+
+    reads_scheduled = false;
+    for (i = 0; i < device_count; i++) {
+        if (devices[i]->due && devices[i]->conversionMs)
+            I2CBus_submitRead(devices[i], false);
+    }
+    return waiting;
+}
+
+void I2CBus_startCycle(void)
+{
+    uint8_t i;
+    uint8_t commands = 0;
+    uint8_t conversion = 0;
+
+    for (i = 0; i < device_count; i++) {
+        I2C_Device* device = devices[i];
+
+        device->fresh = false;
+        device->due = device->period && --device->countdown == 0;
+        if (!device->due)
+            continue;
+        device->countdown = device->period;
+
+        if (device->conversionMs == 0) {
+            // command, repeated start, read
+            I2CBus_submitRead(device, true);
+            continue;
+        }
+        device->commandTransaction.address = device->address;
+        device->commandTransaction.txData = device->command;
+        device->commandTransaction.txLength = device->commandLength;
+        device->commandTransaction.rxLength = 0;
+        device->commandTransaction.retries = I2C_RETRIES;
+        I2C_submit(&device->commandTransaction);
+        commands++;
+        if (device->conversionMs > conversion)
+            conversion = device->conversionMs;
+    }
+
+    if (commands) {
+        reads_scheduled = true;
+        timer_after(conversion + commands * I2C_BUS_COMMAND_MS,
+                    I2CBus_readConverted);
+    }
+}
+
+uint8_t I2CBus_waitCycle(void)
+{
+    uint8_t i;
+    uint8_t fresh = 0;
+
+    __disable_interrupt();
+    while (reads_scheduled) {
+        waiting = true;
+        __bis_SR_register(LPM0_bits + GIE);
+        __disable_interrupt();
+    }
+    waiting = false;
+    __enable_interrupt();
+
+    for (i = 0; i < device_count; i++) {
+        I2C_Device* device = devices[i];
+
+        if (!device->due)
+            continue;
+        // a failed command still has its read scheduled, let it NACK
+        device->fresh = I2C_wait(&device->readTransaction) == I2C_DONE
+                && (device->conversionMs == 0
+                    || device->commandTransaction.status == I2C_DONE);
+        if (device->fresh)
+            fresh++;
+    }
+    return fresh;
+}
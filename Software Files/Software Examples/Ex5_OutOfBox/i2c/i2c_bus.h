@@ -0,0 +1,45 @@
+/*
+ * i2c_bus.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "driverlib.h"
+#include "sensor_i2c.h"
+
+#ifndef I2C_BUS_H_
+#define I2C_BUS_H_
+
+// Table of the sensors on UCB2, read once per report cycle.
+//
+// Each due device gets its command and read queued back to back, so the
+// bus is busy in one burst per cycle. Devices that need a conversion time
+// between command and read have all their commands sent first. Their
+// reads then go out together once the longest conversion is done, using
+// the timer one shot.
+
+#define I2C_BUS_DEVICES_MAX (8)
+
+typedef struct I2C_Device {
+    uint8_t address;
+    const uint8_t* command;     // sent to start a reading, may be 0
+    uint8_t commandLength;
+    uint8_t* data;              // readLength bytes, one buffer per device
+    uint8_t readLength;
+    uint8_t conversionMs;       // 0 reads right after the command, max 120
+    uint8_t period;             // in I2C cycles, 0 never reads
+    // bus manager state
+    uint8_t countdown;
+    bool due;
+    bool fresh;                 // data holds this cycle's reading
+    I2C_Transaction commandTransaction;
+    I2C_Transaction readTransaction;
+} I2C_Device;
+
+// Returns false if the table is full
+bool I2CBus_add(I2C_Device* device);
+// Queues the devices due this cycle
+void I2CBus_startCycle(void);
+// LPM0 until every due device is read, returns how many are fresh
+uint8_t I2CBus_waitCycle(void);
+
+#endif /* I2C_BUS_H_ */
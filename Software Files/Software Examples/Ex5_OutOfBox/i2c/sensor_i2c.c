@@ -6,16 +6,20 @@
  */
 
 #include "sensor_i2c.h"
-#include "sht35.h"
-#include "uart/esp32.h"
 
-#ifdef I2C
-extern uint8_t RXDATA[];
-#else
-uint8_t rxdata[2];
-#endif
+#define I2C_INTERRUPTS (EUSCI_B_I2C_TRANSMIT_INTERRUPT0 \
+        + EUSCI_B_I2C_RECEIVE_INTERRUPT0 + EUSCI_B_I2C_STOP_INTERRUPT \
+        + EUSCI_B_I2C_NAK_INTERRUPT + EUSCI_B_I2C_ARBITRATIONLOST_INTERRUPT \
+        + EUSCI_B_I2C_CLOCK_LOW_TIMEOUT_INTERRUPT)
 
-uint8_t count = 0;
+// queue, head is the transaction on the bus
+static I2C_Transaction* head = 0;
+static I2C_Transaction* tail = 0;
+// bytes moved in the current phase
+static uint8_t count = 0;
+// outcome of the current attempt, acted on once the bus is released
+static uint8_t error = I2C_DONE;
+static volatile bool waiting = false;
 
 
 void I2C_initPorts(void)
@@ -31,23 +35,6 @@ void I2C_initPorts(void)
                                                GPIO_PRIMARY_MODULE_FUNCTION);
 }
 
-void I2C_initReceive(void)
-{
-    EUSCI_B_I2C_setMode(EUSCI_B2_BASE, EUSCI_B_I2C_RECEIVE_MODE);
-    EUSCI_B_I2C_clearInterrupt(
-            EUSCI_B2_BASE,
-            EUSCI_B_I2C_RECEIVE_INTERRUPT0 + EUSCI_B_I2C_BYTE_COUNTER_INTERRUPT
-                    + EUSCI_B_I2C_NAK_INTERRUPT);
-
-    //Enable master Receive interrupt
-    EUSCI_B_I2C_enableInterrupt(
-            EUSCI_B2_BASE,
-            EUSCI_B_I2C_RECEIVE_INTERRUPT0 + EUSCI_B_I2C_BYTE_COUNTER_INTERRUPT
-                    + EUSCI_B_I2C_NAK_INTERRUPT);
-    EUSCI_B_I2C_masterReceiveStart(EUSCI_B2_BASE);
-    count = 0;
-}
-
 void I2C_init(void)
 {
     //Initialize Master
@@ -59,38 +46,155 @@ void I2C_init(void)
     param.autoSTOPGeneration = EUSCI_B_I2C_NO_AUTO_STOP;
     EUSCI_B_I2C_initMaster(EUSCI_B2_BASE, &param);
 
-    //Specify slave address
-    EUSCI_B_I2C_setSlaveAddress(EUSCI_B2_BASE,
-    SLAVE_ADDRESS);
+    // A slave holding SCL low for 28 ms raises UCCLTOIFG
+    EUSCI_B_I2C_setTimeout(EUSCI_B2_BASE, EUSCI_B_I2C_TIMEOUT_28_MS);
 
-    //Set in transmit mode
+    //Idle in receive mode, TXIFG0 only comes up in transmit mode
     EUSCI_B_I2C_setMode(EUSCI_B2_BASE,
-    EUSCI_B_I2C_TRANSMIT_MODE);
+    EUSCI_B_I2C_RECEIVE_MODE);
 
     //Enable I2C Module to start operations
     EUSCI_B_I2C_enable(EUSCI_B2_BASE);
+
+    EUSCI_B_I2C_clearInterrupt(EUSCI_B2_BASE, I2C_INTERRUPTS);
+    EUSCI_B_I2C_enableInterrupt(EUSCI_B2_BASE, I2C_INTERRUPTS);
+}
+
+// Receive phase. A single byte read needs the STOP requested as soon as the
+// address is out, the only place the engine polls (one address byte).
+static void I2C_startReceive(void)
+{
+    count = 0;
+    EUSCI_B_I2C_masterReceiveStart(EUSCI_B2_BASE);
+    if (head->rxLength == 1) {
+        while (EUSCI_B_I2C_masterIsStartSent(EUSCI_B2_BASE))
+            ;
+        EUSCI_B_I2C_masterReceiveMultiByteStop(EUSCI_B2_BASE);
+    }
+}
+
+// Starts head on the bus, the rest is driven by the ISR
+static void I2C_start(void)
+{
+    error = I2C_DONE;
+    count = 0;
+    EUSCI_B_I2C_setSlaveAddress(EUSCI_B2_BASE, head->address);
+    if (head->txLength > 0) {
+        EUSCI_B_I2C_setMode(EUSCI_B2_BASE, EUSCI_B_I2C_TRANSMIT_MODE);
+        EUSCI_B_I2C_masterSendStart(EUSCI_B2_BASE);
+    } else {
+        I2C_startReceive();
+    }
+}
+
+// Ends the attempt on head: retries it, or completes it and starts the
+// next one. Returns true if a waiting caller should be woken.
+static bool I2C_finish(void)
+{
+    I2C_Transaction* done = head;
+    EUSCI_B_I2C_setMode(EUSCI_B2_BASE, EUSCI_B_I2C_RECEIVE_MODE);
+    if (error != I2C_DONE && done->retries > 0) {
+        done->retries--;
+        I2C_start();
+        return false;
+    }
+    head = done->next;
+    if (head == 0)
+        tail = 0;
+    done->status = error;
+    if (done->callback)
+        done->callback(done);
+    if (head)
+        I2C_start();
+    if (waiting) {
+        waiting = false;
+        return true;
+    }
+    return false;
+}
+
+bool I2C_submit(I2C_Transaction* transaction)
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+    if (transaction->status == I2C_PENDING) {
+        __set_interrupt_state(state);
+        return false;
+    }
+    transaction->status = I2C_PENDING;
+    transaction->next = 0;
+    if (tail) {
+        tail->next = transaction;
+        tail = transaction;
+    } else {
+        head = tail = transaction;
+        I2C_start();
+    }
+    __set_interrupt_state(state);
+    return true;
+}
+
+uint8_t I2C_wait(I2C_Transaction* transaction)
+{
+    uint16_t state = __get_interrupt_state();
+    TRACE_BEGIN(TRACE_I2C_WAIT);
+    __disable_interrupt();
+    while (transaction->status == I2C_PENDING) {
+        waiting = true;
+        __bis_SR_register(LPM0_bits + GIE);
+        __disable_interrupt();
+    }
+    __set_interrupt_state(state);
+    TRACE_END(TRACE_I2C_WAIT);
+    return transaction->status;
+}
+
+bool I2C_isIdle(void)
+{
+    return head == 0;
 }
 
 #if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
 #pragma vector=USCI_B2_VECTOR
 __interrupt
 #elif defined(__GNUC__)
-__attribute__((interrupt(USCI_B0_VECTOR)))
+__attribute__((interrupt(USCI_B2_VECTOR)))
 #endif
 void USCIB2_ISR(void)
 {
+    TRACE_ISR_BEGIN(TRACE_ISR_USCI_B2);
     switch (__even_in_range(UCB2IV, USCI_I2C_UCBIT9IFG))
     {
     case USCI_NONE:             // No interrupts break;
         break;
     case USCI_I2C_UCALIFG:      // Arbitration lost
+        // the module fell back to slave mode, take the bus again later
+        HWREG16(EUSCI_B2_BASE + OFS_UCBxCTLW0) |= UCMST;
+        if (head) {
+            error = I2C_ARBITRATION;
+            if (I2C_finish())
+                __bic_SR_register_on_exit(LPM0_bits);
+        }
         break;
     case USCI_I2C_UCNACKIFG:    // NAK received (master only)
-        //EUSCI_B_I2C_masterReceiveStart(EUSCI_B0_BASE);
+        // release the bus, the attempt ends with the STOP
+        error = I2C_NACK;
+        EUSCI_B_I2C_masterReceiveMultiByteStop(EUSCI_B2_BASE);
         break;
     case USCI_I2C_UCSTTIFG: // START condition detected with own address (slave mode only)
         break;
     case USCI_I2C_UCSTPIFG:     // STOP condition detected (master & slave mode)
+        if (head) {
+            // the last byte may still be waiting behind the higher
+            // priority STOP
+            if (error == I2C_DONE && count < head->rxLength
+                    && (EUSCI_B_I2C_getInterruptStatus(EUSCI_B2_BASE,
+                            EUSCI_B_I2C_RECEIVE_INTERRUPT0)))
+                head->rxData[count++] = EUSCI_B_I2C_masterReceiveMultiByteNext(
+                        EUSCI_B2_BASE);
+            if (I2C_finish())
+                __bic_SR_register_on_exit(LPM0_bits);
+        }
         break;
     case USCI_I2C_UCRXIFG3:     // RXIFG3
         break;
@@ -106,21 +210,41 @@ void USCIB2_ISR(void)
         break;
     case USCI_I2C_UCRXIFG0:     // RXIFG0
         // Get RX data
-        RXDATA[count] = EUSCI_B_I2C_masterReceiveSingle(EUSCI_B2_BASE);
-        if (++count >= RXCOUNT)
-        {
+        head->rxData[count++] = EUSCI_B_I2C_masterReceiveMultiByteNext(
+                EUSCI_B2_BASE);
+        // STOP goes out after the byte being received now
+        if (head->rxLength - count == 1)
             EUSCI_B_I2C_masterReceiveMultiByteStop(EUSCI_B2_BASE);
-        }
         break; // Vector 24: RXIFG0 break;
     case USCI_I2C_UCTXIFG0:     // TXIFG0
+        if (count < head->txLength) {
+            EUSCI_B_I2C_slavePutData(EUSCI_B2_BASE, head->txData[count++]);
+        } else if (head->rxLength > 0) {
+            // repeated start for the read
+            I2C_startReceive();
+        } else {
+            EUSCI_B_I2C_masterReceiveMultiByteStop(EUSCI_B2_BASE);
+            EUSCI_B_I2C_clearInterrupt(EUSCI_B2_BASE,
+                    EUSCI_B_I2C_TRANSMIT_INTERRUPT0);
+        }
         break;
     case USCI_I2C_UCBCNTIFG:    // Byte count limit reached (UCBxTBCNT)
         break;
     case USCI_I2C_UCCLTOIFG:    // Clock low timeout - clock held low too long
+        // the bus is stuck, reset the module (clears UCB2IE) and retry
+        EUSCI_B_I2C_disable(EUSCI_B2_BASE);
+        EUSCI_B_I2C_enable(EUSCI_B2_BASE);
+        EUSCI_B_I2C_enableInterrupt(EUSCI_B2_BASE, I2C_INTERRUPTS);
+        if (head) {
+            error = I2C_TIMEOUT;
+            if (I2C_finish())
+                __bic_SR_register_on_exit(LPM0_bits);
+        }
         break;
     case USCI_I2C_UCBIT9IFG: // Generated on 9th bit of a transmit (for debugging)
         break;
     default:
         break;
     }
+    TRACE_ISR_END(TRACE_ISR_USCI_B2);
 }
@@ -5,13 +5,53 @@
  *      Author: caleb
  */
 #include "driverlib.h"
+#include "trace/trace.h"
 
 #ifndef SENSOR_I2C_H_
 #define SENSOR_I2C_H_
 
+// Queued I2C master on UCB2, run entirely from USCIB2_ISR.
+//
+// A transaction writes txLength bytes, reads rxLength bytes, or does both
+// with a repeated start in between. Transactions are owned by the caller
+// and must stay untouched until their status leaves I2C_PENDING. They run
+// in submit order; a NACK, lost arbitration or a clock low timeout restarts
+// the transaction until its retries are used up.
+
+#define I2C_RETRIES (2)
+
+// status, a zeroed transaction is I2C_IDLE
+#define I2C_IDLE        (0)
+#define I2C_PENDING     (1)
+#define I2C_DONE        (2)
+#define I2C_NACK        (3)
+#define I2C_ARBITRATION (4)
+#define I2C_TIMEOUT     (5)
+
+struct I2C_Transaction;
+// Called from the ISR once a transaction is finished, any status
+typedef void (*I2C_Callback)(struct I2C_Transaction* transaction);
+
+typedef struct I2C_Transaction {
+    uint8_t address;
+    const uint8_t* txData;
+    uint8_t txLength;
+    uint8_t* rxData;
+    uint8_t rxLength;
+    uint8_t retries;            // extra attempts after an error
+    I2C_Callback callback;      // may be 0
+    volatile uint8_t status;
+    struct I2C_Transaction* next;
+} I2C_Transaction;
+
 void I2C_initPorts(void);
 void I2C_init(void);
-void I2C_initReceive(void);
+// Queues a transaction, starting it if the bus is idle. Returns false if it
+// is already queued.
+bool I2C_submit(I2C_Transaction* transaction);
+// LPM0 until the transaction is finished, returns its status
+uint8_t I2C_wait(I2C_Transaction* transaction);
+bool I2C_isIdle(void);
 
 
 #endif /* SENSOR_I2C_H_ */
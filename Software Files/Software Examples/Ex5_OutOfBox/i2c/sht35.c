@@ -7,42 +7,59 @@
 
 #include "sht35.h"
 
-uint8_t sht35data[6];
+static uint8_t sht35data[SHT35_DATA_SIZE];
+
+static uint8_t command[2];
+static I2C_Transaction command_transaction;
+#ifdef SHT35_SINGLE_SHOT
+static const uint8_t measure_command[2] = { SINGLE_MSB, SINGLE_RP };
+#define MEASURE_MS SINGLE_MS
+#else
+static const uint8_t measure_command[2] = { FETCH_DATA_MSB, FETCH_DATA_LSB };
+#define MEASURE_MS (0)
+#endif
+
+I2C_Device SHT35_device = {
+	.address = SHT35_ADDRESS,
+	.command = measure_command,
+	.commandLength = sizeof(measure_command),
+	.data = sht35data,
+	.readLength = SHT35_DATA_SIZE,
+	.conversionMs = MEASURE_MS,
+	.period = 1,
+};
 
 void SHT35_sendCommand(uint8_t MSB, uint8_t LSB) {
-	// Send command.
-	EUSCI_B_I2C_masterSendMultiByteStart(EUSCI_B2_BASE, MSB);
-	EUSCI_B_I2C_masterSendMultiByteFinish(EUSCI_B2_BASE, LSB);
-	// Delay until transmission completes
-	while (EUSCI_B_I2C_isBusBusy(EUSCI_B2_BASE))
-		;
+	command[0] = MSB;
+	command[1] = LSB;
+	command_transaction.address = SHT35_ADDRESS;
+	command_transaction.txData = command;
+	command_transaction.txLength = sizeof(command);
+	command_transaction.rxLength = 0;
+	command_transaction.retries = I2C_RETRIES;
+	I2C_submit(&command_transaction);
+	I2C_wait(&command_transaction);
 }
 
-void SHT35_getTemp(uint8_t data[], uint8_t temp_string[]) {
-	uint32_t temp_raw = (data[0] << 8) + data[1];
-	temp_raw *= 10000;
-	int32_t temp = temp_raw / 65535;
-	temp *= 315;
-	temp -= 490000;
-	temp /= 100;
-
-	uint16_t number_length = sprintf((char*) temp_string, "%d", temp);
-	temp_string[number_length + 1] = '\0';
-	temp_string[number_length] = temp_string[number_length - 1];
-	temp_string[number_length - 1] = temp_string[number_length - 2];
-	temp_string[number_length - 2] = '.';
+void SHT35_init(void) {
+#ifndef SHT35_SINGLE_SHOT
+	SHT35_sendCommand(PERIODIC_MPS, PERIODIC_RP(SHT35_REPEATABILITY));
+#endif
+	I2CBus_add(&SHT35_device);
 }
 
-void SHT35_getHumidity(uint8_t data[], uint8_t humidity_string[]) {
-	uint32_t humidity_raw = (data[3] << 8) + data[4];
-	humidity_raw *= 10000;
-	uint32_t humidity = humidity_raw / 65535;
-	humidity /= 10;
+void SHT35_getTemp(uint16_t temp_raw, uint8_t temp_string[], uint8_t size) {
+	// hundredths of a degree
+	int16_t temp = (int16_t) Q_scale(temp_raw, SHT35_TEMP_RATIO)
+			+ SHT35_TEMP_OFFSET;
+
+	Format_fixed(temp_string, size, temp, 2);
+}
 
-	uint16_t number_length = sprintf((char*) humidity_string, "%d", humidity);
-	humidity_string[number_length + 1] = '\0';
-	humidity_string[number_length] = humidity_string[number_length - 1];
-	humidity_string[number_length - 1] = humidity_string[number_length - 2];
-	humidity_string[number_length - 2] = '.';
+void SHT35_getHumidity(uint16_t humidity_raw, uint8_t humidity_string[],
+		uint8_t size) {
+	// hundredths of a percent
+	uint16_t humidity = Q_scale(humidity_raw, SHT35_HUMIDITY_RATIO);
 
+	Format_fixed(humidity_string, size, humidity, 2);
 }
@@ -7,7 +7,11 @@
 
 #include "driverlib.h"
 #include <inttypes.h>
-#include <stdio.h>
+#include "format/format.h"
+#include "qmath/qmath.h"
+#include "sensor_i2c.h"
+#include "i2c_bus.h"
+#include "timers.h"
 
 #ifndef SHT35_H_
 #define SHT35_H_
@@ -16,16 +20,31 @@
 
 #ifdef SHT35
 #define I2C
-#define SLAVE_ADDRESS 0x45
-#define RXCOUNT (5)
-#define RXDATA sht35data
-#else
-#define SLAVE_ADDRESS (0)
-#define RXCOUNT (0)
-#define RXDATA rxdata
 #endif
+#define SHT35_ADDRESS 0x45
+// T, CRC, RH, CRC
+#define SHT35_DATA_SIZE (6)
+
+// Single shot (default) powers the sensor down between reports, otherwise it
+// runs in periodic mode at the slowest rate that keeps up with the report
+// interval. Repeatability: 0 low, 1 medium, 2 high.
+#define SHT35_SINGLE_SHOT
+#define SHT35_REPEATABILITY (2)
 
 // SHT35 Commands
+#define FETCH_DATA_MSB  0xE0
+#define FETCH_DATA_LSB  0x00
+//
+// Single shot without clock stretching, the result is read once the
+// conversion is done. Times are the datasheet maximums rounded up in ms.
+#define SINGLE_MSB      0x24
+#define SINGLE_LOW_RP   0x16
+#define SINGLE_MED_RP   0x0B
+#define SINGLE_HIGH_RP  0x00
+#define SINGLE_LOW_MS   (5)
+#define SINGLE_MED_MS   (7)
+#define SINGLE_HIGH_MS  (16)
+//
 #define HALF_MPS        0x20
 #define ONE_MPS         0x21
 #define TWO_MPS         0x22
@@ -53,8 +72,55 @@
 #define TEN_HIGH_RP     0x37
 //
 
+#if SHT35_REPEATABILITY == 0
+#define SINGLE_RP       SINGLE_LOW_RP
+#define SINGLE_MS       SINGLE_LOW_MS
+#elif SHT35_REPEATABILITY == 1
+#define SINGLE_RP       SINGLE_MED_RP
+#define SINGLE_MS       SINGLE_MED_MS
+#else
+#define SINGLE_RP       SINGLE_HIGH_RP
+#define SINGLE_MS       SINGLE_HIGH_MS
+#endif
+
+// One periodic sample per I2C cycle at most
+#if I2C_INTERVAL_MS >= 2000
+#define PERIODIC_MPS    HALF_MPS
+#define PERIODIC_RP(r)  ((r) == 0 ? HALF_LOW_RP : (r) == 1 ? HALF_MED_RP : HALF_HIGH_RP)
+#elif I2C_INTERVAL_MS >= 1000
+#define PERIODIC_MPS    ONE_MPS
+#define PERIODIC_RP(r)  ((r) == 0 ? ONE_LOW_RP : (r) == 1 ? ONE_MED_RP : ONE_HIGH_RP)
+#elif I2C_INTERVAL_MS >= 500
+#define PERIODIC_MPS    TWO_MPS
+#define PERIODIC_RP(r)  ((r) == 0 ? TWO_LOW_RP : (r) == 1 ? TWO_MED_RP : TWO_HIGH_RP)
+#elif I2C_INTERVAL_MS >= 250
+#define PERIODIC_MPS    FOUR_MPS
+#define PERIODIC_RP(r)  ((r) == 0 ? FOUR_LOW_RP : (r) == 1 ? FOUR_MED_RP : FOUR_HIGH_RP)
+#else
+#define PERIODIC_MPS    TEN_MPS
+#define PERIODIC_RP(r)  ((r) == 0 ? TEN_LOW_RP : (r) == 1 ? TEN_MED_RP : TEN_HIGH_RP)
+#endif
+
+// Goes through the I2C queue and sleeps until the bus is done
 void SHT35_sendCommand(uint8_t MSB, uint8_t LSB);
-void SHT35_getTemp(uint8_t data[], uint8_t temp_string[]);
-void SHT35_getHumidity(uint8_t data[], uint8_t humidity_string[]);
+// Adds the sensor to the bus manager and starts periodic mode if used.
+// Single shot: every cycle sends the measurement command and reads the
+// result SINGLE_MS later. Periodic: every cycle fetches the latest sample.
+void SHT35_init(void);
+// SHT35_device.data holds the reading when SHT35_device.fresh is set
+extern I2C_Device SHT35_device;
+// Datasheet conversions in hundredths: T = -49 + 315 * raw / 65535 F,
+// RH = 100 * raw / 65535 %
+#define SHT35_TEMP_RATIO        Q_RATIO(31500, 65535)
+#define SHT35_TEMP_OFFSET       (-4900)
+#define SHT35_HUMIDITY_RATIO    Q_RATIO(10000, 65535)
+
+// Readings as strings with two decimals, temperature in F, humidity in %RH
+void SHT35_getTemp(uint16_t temp_raw, uint8_t temp_string[], uint8_t size);
+void SHT35_getHumidity(uint16_t humidity_raw, uint8_t humidity_string[],
+		uint8_t size);
+// Raw readings out of the data buffer
+#define SHT35_TEMP_RAW(data)     (((uint16_t) (data)[0] << 8) + (data)[1])
+#define SHT35_HUMIDITY_RAW(data) (((uint16_t) (data)[3] << 8) + (data)[4])
 
 #endif /* SHT35_H_ */
@@ -1,17 +1,42 @@
 //
 #include "driverlib.h"
 #include "i2c/sensor_i2c.h"
+#include "i2c/i2c_bus.h"
 #include "i2c/sht35.h"
 #include "timers.h"
+#include "scheduler/scheduler.h"
+#include "trace/trace.h"
 #include "ports.h"
 #include "uart/uart.h"
 #include "uart/esp32.h"
 #include "adc/adc.h"
+#include "fram/sample_log.h"
+#include "deadband/deadband.h"
+#include "stats/stats.h"
+#include "aes/aes_ctr.h"
 
 #define ADC_A3
 #define ADC_A4
 #define ADC
 
+// Keep readings in FRAM while the ESP32 has no link, binary mode only
+#ifdef ESP32_BINARY
+#define SAMPLE_LOG
+#endif
+
+// Build with -DSTATS to aggregate the readings of each channel over a
+// window (timers.h) and send one summary per window instead of every
+// reading. Binary mode only; the deadband filter is not used then.
+#if defined(STATS) && !defined(ESP32_BINARY)
+#error "STATS needs ESP32_BINARY"
+#endif
+
+// Build with -DAES_CTR to encrypt the frames to the ESP32 on the AES256
+// module (aes/aes_ctr.h). The ESP32 forwards them to the cloud as they are.
+#if defined(AES_CTR) && !defined(ESP32_BINARY)
+#error "AES_CTR needs ESP32_BINARY"
+#endif
+
 //
 //Set the address for slave module. This is a 7-bit address sent in the
 //following format:
@@ -24,18 +49,271 @@
 //*****************************************************************************
 
 extern bool client_connected;
-extern uint8_t RXDATA[];
 extern uint16_t ADC_A3_value;
 extern uint16_t ADC_A4_value;
-extern bool ok;
+
+#ifdef AES_CTR
+// Example key from FIPS-197, every device needs its own
+static const uint8_t aes_key[AES_CTR_KEY_SIZE] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F
+};
+#endif
+
+#ifdef ESP32_BINARY
+// One raw reading of a sampling cycle. With STATS it is the summary of a
+// window and value is its mean, which is what goes to the sample log.
+typedef struct {
+	uint8_t channel;
+	uint16_t value;
+#ifdef STATS
+	StatsSummary summary;
+#endif
+} Reading;
+#define READINGS_MAX (4)
+
+#ifdef SAMPLE_LOG
+// What went out last cycle, with the SEQs of its frames. It is settled at
+// the start of the next cycle, once every frame of it is answered or given
+// up on (ESP32_flush).
+static Reading sent[READINGS_MAX];
+static uint8_t sent_seq[READINGS_MAX];
+static uint8_t sent_count = 0;
+static uint32_t sent_time;
+// Block frames of the replay: replay_end[i] is replay_count after block i
+#define REPLAY_BLOCKS (4)
+static uint8_t replay_seq[REPLAY_BLOCKS];
+static uint16_t replay_end[REPLAY_BLOCKS];
+static uint8_t replay_blocks = 0;
+static uint16_t replay_count = 0;
+#endif
+
+// Sends one cycle of readings. While the link is down they go to the FRAM
+// log instead and the oldest logged record is sent as a probe; once the link
+// is back the log is replayed in bursts of SAMPLE_LOG_BURST, packed into
+// block frames.
+static void report(const Reading readings[], uint8_t count) {
+	uint8_t i;
+#ifdef SAMPLE_LOG
+	uint32_t now = timer_getSeconds();
+	uint16_t burst;
+	uint16_t done = 0;
+	SampleRecord record;
+
+	// usually all answered long ago, frames keep going out meanwhile
+	ESP32_flush();
+	// the log is discarded from the oldest record on: up to the first block
+	// that failed, the rest is replayed again
+	for (i = 0; i < replay_blocks && !ESP32_frameFailed(replay_seq[i]); i++)
+		done = replay_end[i];
+	SampleLog_discard(done);
+	// live readings whose frame failed go to the log
+	for (i = 0; i < sent_count; i++) {
+		if (ESP32_frameFailed(sent_seq[i]))
+			SampleLog_append(sent_time, sent[i].channel, sent[i].value);
+	}
+	sent_count = 0;
+	replay_blocks = 0;
+	replay_count = 0;
+
+	if (ESP32_isLinkDown()) {
+		for (i = 0; i < count; i++)
+			SampleLog_append(now, readings[i].channel, readings[i].value);
+		burst = 1;
+	} else {
+		for (i = 0; i < count; i++) {
+#ifdef STATS
+			sent_seq[i] = ESP32_telemetrySummary(readings[i].channel,
+					&readings[i].summary);
+#else
+			sent_seq[i] = ESP32_telemetryFrame(readings[i].channel,
+					readings[i].value);
+#endif
+			sent[i] = readings[i];
+		}
+		sent_count = count;
+		sent_time = now;
+		burst = SAMPLE_LOG_BURST;
+	}
+
+	// as many block frames as the burst needs
+	while (replay_blocks < REPLAY_BLOCKS && replay_count < burst
+			&& replay_count < SampleLog_count()) {
+		replay_seq[replay_blocks] = ESP32_blockBegin();
+		while (replay_count < burst && replay_count < SampleLog_count()) {
+			// corrupted records are skipped and discarded with the rest
+			if (SampleLog_peek(replay_count, &record)
+					&& !ESP32_blockAdd(record.channel, record.value,
+							SampleLog_age(&record, now)))
+				break;
+			replay_count++;
+		}
+		ESP32_blockSend();
+		replay_end[replay_blocks++] = replay_count;
+	}
+#else
+	for (i = 0; i < count; i++) {
+#ifdef STATS
+		ESP32_telemetrySummary(readings[i].channel, &readings[i].summary);
+#else
+		ESP32_telemetryFrame(readings[i].channel, readings[i].value);
+#endif
+	}
+#endif
+}
+#endif
+
+// Latest raw value of each channel, a bit in fresh means it has not been
+// sent yet. Sensors are sampled by their own tasks at their own rate. A
+// fresh value is only reported if it passes the deadband filter.
+#define CHANNELS (4)
+static uint16_t latest[CHANNELS];
+static uint8_t fresh = 0;
+#ifdef STATS
+// readings of the current window
+static Stats stats[CHANNELS];
+#endif
+
+static void store(uint8_t channel, uint16_t value) {
+	latest[channel] = value;
+	fresh |= 1 << channel;
+#ifdef STATS
+	Stats_add(&stats[channel], value);
+#endif
+}
+
+#ifdef I2C
+static Task i2c_task;
+
+static void sample_i2c(void) {
+	TRACE_BEGIN(TRACE_TASK_I2C);
+	I2CBus_startCycle();
+	I2CBus_waitCycle();
+	if (SHT35_device.fresh) {
+		store(CHANNEL_TEMPERATURE, SHT35_TEMP_RAW(SHT35_device.data));
+		store(CHANNEL_HUMIDITY, SHT35_HUMIDITY_RAW(SHT35_device.data));
+	}
+	TRACE_END(TRACE_TASK_I2C);
+}
+#endif
+
+#ifdef ADC
+static Task adc_task;
+
+static void sample_adc(void) {
+	TRACE_BEGIN(TRACE_TASK_ADC);
+	ADC_startOversampling();
+	ADC_waitResult();
+#ifdef ADC_A3
+	store(CHANNEL_MOISTURE, ADC_A3_value);
+#endif
+#ifdef ADC_A4
+	store(CHANNEL_LIGHT, ADC_A4_value);
+#endif
+	TRACE_END(TRACE_TASK_ADC);
+}
+#endif
+
+static Task report_task;
+
+#ifndef STATS
+// true if channel has a fresh value that is to be sent
+static bool due(uint8_t channel, uint32_t now) {
+	return (fresh & (1 << channel))
+			&& Deadband_check(channel, latest[channel], now);
+}
+#endif
+
+static void send_readings(void) {
+	uint8_t channel;
+	uint8_t count = 0;
+#ifndef STATS
+	uint32_t now = timer_getSeconds();
+#endif
+	uint8_t config[UART_LINE_SIZE];
+#ifdef ESP32_BINARY
+	Reading readings[READINGS_MAX];
+
+	TRACE_BEGIN(TRACE_TASK_REPORT);
+	if (ESP32_getConfig(config))
+		Deadband_configure(config);
+
+	for (channel = 0; channel < CHANNELS; channel++) {
+#ifdef STATS
+		if (stats[channel].count == 0)
+			continue;
+		Stats_summarize(&stats[channel], &readings[count].summary);
+		Stats_reset(&stats[channel]);
+		readings[count].value = readings[count].summary.mean;
+#else
+		if (!due(channel, now))
+			continue;
+		readings[count].value = latest[channel];
+#endif
+		readings[count++].channel = channel;
+	}
+	// also called without readings, the sample log may need replaying
+	report(readings, count);
+#else
+	// one AT+batch command per cycle
+	uint8_t* names[ESP32_BATCH_MAX];
+	uint8_t* values[ESP32_BATCH_MAX];
+	uint8_t text[CHANNELS][16];
+
+	TRACE_BEGIN(TRACE_TASK_REPORT);
+	if (ESP32_getConfig(config))
+		Deadband_configure(config);
+	TRACE_BEGIN(TRACE_FORMAT);
+	for (channel = 0; channel < CHANNELS; channel++) {
+		if (!due(channel, now))
+			continue;
+		switch (channel) {
+		case CHANNEL_TEMPERATURE:
+			SHT35_getTemp(latest[channel], text[channel], sizeof(text[0]));
+			names[count] = "temperature";
+			break;
+		case CHANNEL_HUMIDITY:
+			SHT35_getHumidity(latest[channel], text[channel],
+					sizeof(text[0]));
+			names[count] = "humidity";
+			break;
+		case CHANNEL_MOISTURE:
+			ADC_getPercentage(text[channel], sizeof(text[0]), latest[channel],
+					ADC_PERCENT_RATIO(ADC_SCALE(1100)));
+			names[count] = "moisture";
+			break;
+		default:
+			ADC_getPercentage(text[channel], sizeof(text[0]), latest[channel],
+					ADC_PERCENT_RATIO(ADC_SCALE(3000)));
+			names[count] = "light";
+			break;
+		}
+		values[count++] = text[channel];
+	}
+	TRACE_END(TRACE_FORMAT);
+	// a batch too long for one command goes out one reading at a time
+	if (count > 0 && !ESP32_telemetryBatch(names, values, count)) {
+		uint8_t i;
+		for (i = 0; i < count; i++)
+			ESP32_telemetry(names[i], values[i]);
+	}
+#endif
+	fresh = 0;
+	TRACE_END(TRACE_TASK_REPORT);
+}
 
 void main(void) {
 	WDT_A_hold(WDT_A_BASE);
 
 	//Set DCO frequency to 8MHz
 	CS_setDCOFreq(CS_DCORSEL_0, CS_DCOFSEL_6);
-	//Set ACLK = VLO with frequency divider of 1
+#ifndef TIMER_LFXT
+	//Set ACLK = VLO with frequency divider of 1, timer_a_init moves it to
+	//the crystal otherwise
 	CS_initClockSignal(CS_ACLK, CS_VLOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+#endif
 	//Set SMCLK = DCO with frequency divider of 1
 	CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
 	//Set MCLK = DCO with frequency divider of 1
@@ -48,6 +326,10 @@ void main(void) {
 	 * previously configured port settings
 	 */
 	PMM_unlockLPM5();
+#ifdef SAMPLE_LOG
+	SampleLog_init();
+#endif
+	Deadband_init();
 #ifdef ADC
 	init_ADC12B();
 
@@ -55,7 +337,7 @@ void main(void) {
 	ADC12_B_NOTENDOFSEQUENCE, ADC12_B_IFG0,
 	ADC12_B_IE0);
 
-	init_ADC12B_memoryBuffer(ADC12_B_MEMORY_0, ADC12_B_INPUT_A4,
+	init_ADC12B_memoryBuffer(ADC12_B_MEMORY_1, ADC12_B_INPUT_A4,
 	ADC12_B_ENDOFSEQUENCE, ADC12_B_IFG1,
 	ADC12_B_IE1);
 
@@ -65,53 +347,44 @@ void main(void) {
 	UART_init(EUSCI_A3_BASE);
 
 	timer_a_init(TIMER_A0_BASE);
+#ifdef TRACE_ENABLE
+	Trace_init();
+#endif
+#ifdef AES_CTR
+	AesCtr_init(aes_key, AES_CTR_PIPELINE);
+#endif
 	__enable_interrupt();
-	// Enable ESp32
+	// Enable ESp32. Each command is answered before the next one goes out:
+	// the ESP32 connects while it handles them and reads nothing meanwhile.
 	ESP32_mode('0');
-	//while(!ok);
+	ESP32_waitForOK();
 	ESP32_ssid("ClickForFreeViruses-2.4G");
-	//while(!ok);
+	ESP32_waitForOK();
 	ESP32_pass("u0y8-lokv-bu9x");
-	//while(!ok);
+	ESP32_waitForOK();
 	ESP32_connString(
 			"HostName=iothub-mhvvc.azure-devices.net;DeviceId=63260816-6df9-4dae-8b87-afa2816fab8f;SharedAccessKey=uw3SedOYkJVwkIxTVEivzWNwMKaPxMjzBZcirOPtz+Y=");
-	//while(!ok);
+	ESP32_waitForOK();
 
 #ifdef I2C
 	I2C_init();
 #endif
 #ifdef SHT35
-	SHT35_sendCommand(FOUR_MPS, FOUR_HIGH_RP);
+	SHT35_init();
 #endif
-	while (1) {
-
-		//Delay between each transaction
-		__bis_SR_register(LPM1_bits + GIE);
+	// Sampling deadlines are short so that a report released at the same
+	// time goes out after them
 #ifdef I2C
-		I2C_initReceive();
-		uint8_t temp[16];
-		uint8_t humidity[16];
-		if (RXDATA[0] != '\0') {
-			SHT35_getTemp(RXDATA, temp);
-			ESP32_telemetry("temperature", temp);
-			SHT35_getHumidity(RXDATA, humidity);
-			ESP32_telemetry("humidity", humidity);
-		}
-#endif
-#ifdef ADC_A3
-		ADC12_B_startConversion(ADC12_B_BASE, ADC12_B_MEMORY_0,
-		ADC12_B_SEQOFCHANNELS);
-		uint8_t moisture[16];
-		ADC_getPercentage(moisture, ADC_A3_value, 1100);
-		ESP32_telemetry("moisture", moisture);
-
+	i2c_task.run = sample_i2c;
+	Scheduler_every(&i2c_task, TIMER_MS(I2C_INTERVAL_MS), TIMER_MS(100), 0);
 #endif
-#ifdef ADC_A4
-		uint8_t light[16];
-		ADC_getPercentage(light, ADC_A4_value, 3000);
-		ESP32_telemetry("light", light);
+#ifdef ADC
+	adc_task.run = sample_adc;
+	Scheduler_every(&adc_task, TIMER_MS(ADC_INTERVAL_MS), TIMER_MS(100), 0);
 #endif
+	report_task.run = send_readings;
+	Scheduler_every(&report_task, TIMER_MS(REPORT_INTERVAL_MS),
+			TIMER_MS(REPORT_INTERVAL_MS), 0);
 
-	}
+	Scheduler_run();
 }
-
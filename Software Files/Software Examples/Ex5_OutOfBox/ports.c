@@ -12,9 +12,18 @@ void init_ports(void){
     UART_initPorts();
     ADC_initPorts();
     init_port8();
+#ifdef TIMER_LFXT
+    init_portJ();
+#endif
 }
 
 
+// LFXIN/LFXOUT for the 32 kHz crystal
+void init_portJ(void){
+    GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_PJ,
+            GPIO_PIN4 + GPIO_PIN5, GPIO_PRIMARY_MODULE_FUNCTION);
+}
+
 void init_port8(void){
     P8SEL0 &= ~0x2;
     P8SEL1 &= ~0x2;
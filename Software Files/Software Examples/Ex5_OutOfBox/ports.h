@@ -7,11 +7,13 @@
 #include "i2c/sensor_i2c.h"
 #include "uart/uart.h"
 #include "adc/adc.h"
+#include "timers.h"
 
 #ifndef PORTS_H_
 #define PORTS_H_
 
 void init_ports(void);
 void init_port8(void);
+void init_portJ(void);
 
 #endif /* PORTS_H_ */
@@ -0,0 +1,124 @@
+/*
+ * qmath.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "qmath.h"
+
+#if defined(__MSP430__) && !defined(QMATH_REFERENCE)
+#include "driverlib.h"
+#define QMATH_MPY32
+#endif
+
+q15_t Q15_sat(int32_t value) {
+	if (value > Q15_MAX)
+		return Q15_MAX;
+	if (value < Q15_MIN)
+		return Q15_MIN;
+	return value;
+}
+
+q31_t Q31_sat(int64_t value) {
+	if (value > Q31_MAX)
+		return Q31_MAX;
+	if (value < Q31_MIN)
+		return Q31_MIN;
+	return value;
+}
+
+#ifdef QMATH_MPY32
+
+// The compiler uses MPY32 for ordinary multiplications, in ISRs as well, so
+// the multiplier is owned with interrupts off and put back in integer mode.
+static uint16_t Q_begin(bool fractional) {
+	uint16_t state = __get_interrupt_state();
+	__disable_interrupt();
+	if (fractional) {
+		MPY32_enableFractionalMode();
+		MPY32_enableSaturationMode();
+	}
+	return state;
+}
+
+static void Q_end(uint16_t state) {
+	MPY32_disableFractionalMode();
+	MPY32_disableSaturationMode();
+	__set_interrupt_state(state);
+}
+
+// Results are read after the setter returns, which is past the 16x16 and
+// 32x32 multiply latency.
+q15_t Q15_mul(q15_t a, q15_t b) {
+	uint16_t state = Q_begin(true);
+	MPY32_setOperandOne16Bit(MPY32_MULTIPLY_SIGNED, a);
+	MPY32_setOperandTwo16Bit(b);
+	q15_t result = HWREG16(MPY32_BASE + OFS_RES1);
+	Q_end(state);
+	return result;
+}
+
+q31_t Q31_mul(q31_t a, q31_t b) {
+	uint16_t state = Q_begin(true);
+	MPY32_setOperandOne32Bit(MPY32_MULTIPLY_SIGNED, a);
+	MPY32_setOperandTwo32Bit(b);
+	q31_t result = ((uint32_t) HWREG16(MPY32_BASE + OFS_RES3) << 16)
+			| HWREG16(MPY32_BASE + OFS_RES2);
+	Q_end(state);
+	return result;
+}
+
+q31_t Q15_dot(const q15_t a[], const q15_t b[], uint16_t length) {
+	uint16_t i;
+	uint16_t state = Q_begin(false);
+	// 32 bit MACS keeps all 64 bits of the sum
+	MPY32_preloadResult(0);
+	for (i = 0; i < length; i++) {
+		MPY32_setOperandOne32Bit(MPY32_MULTIPLYACCUMULATE_SIGNED,
+				(int32_t) a[i]);
+		MPY32_setOperandTwo32Bit((int32_t) b[i]);
+	}
+	int64_t sum = (int64_t) MPY32_getResult();
+	Q_end(state);
+	// Q30 products to Q31
+	return Q31_sat(sum * 2);
+}
+
+uint16_t Q_scale(uint16_t value, uint32_t ratio) {
+	uint16_t state = Q_begin(false);
+	// 16 x 32 bit, the integer part of the 0.32 result is RES2
+	MPY32_setOperandOne16Bit(MPY32_MULTIPLY_UNSIGNED, value);
+	MPY32_setOperandTwo32Bit(ratio);
+	uint16_t result = HWREG16(MPY32_BASE + OFS_RES2);
+	Q_end(state);
+	return result;
+}
+
+#else
+
+// Reference model, matches the MPY32 fractional/saturation behaviour
+
+q15_t Q15_mul(q15_t a, q15_t b) {
+	if (a == Q15_MIN && b == Q15_MIN)
+		return Q15_MAX;
+	return ((int32_t) a * b) >> 15;
+}
+
+q31_t Q31_mul(q31_t a, q31_t b) {
+	if (a == Q31_MIN && b == Q31_MIN)
+		return Q31_MAX;
+	return ((int64_t) a * b) >> 31;
+}
+
+q31_t Q15_dot(const q15_t a[], const q15_t b[], uint16_t length) {
+	uint16_t i;
+	int64_t sum = 0;
+	for (i = 0; i < length; i++)
+		sum += (int32_t) a[i] * b[i];
+	return Q31_sat(sum * 2);
+}
+
+uint16_t Q_scale(uint16_t value, uint32_t ratio) {
+	return ((uint64_t) value * ratio) >> 32;
+}
+
+#endif
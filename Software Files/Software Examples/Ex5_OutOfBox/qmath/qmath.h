@@ -0,0 +1,50 @@
+/*
+ * qmath.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include <stdint.h>
+
+#ifndef QMATH_H_
+#define QMATH_H_
+
+// Q15/Q31 fixed point math on the MPY32 hardware multiplier.
+//
+// On the MSP430 the operations run on MPY32 with interrupts disabled, since
+// compiled code uses the same multiplier. Elsewhere, or with QMATH_REFERENCE
+// defined, the C reference model below is built instead; it gives the same
+// result bit for bit, so conversions can be checked on a PC.
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+#define Q15_MAX ((q15_t) 0x7FFF)
+#define Q15_MIN ((q15_t) -0x8000)
+#define Q31_MAX ((q31_t) 0x7FFFFFFF)
+#define Q31_MIN ((q31_t) (-0x7FFFFFFF - 1))
+
+// Constants in [-1, 1), converted by the compiler
+#define Q15(x) ((q15_t) ((x) * 32768.0 + ((x) >= 0 ? 0.5 : -0.5)))
+#define Q31(x) ((q31_t) ((x) * 2147483648.0 + ((x) >= 0 ? 0.5 : -0.5)))
+
+// num / den as an unsigned 0.32 fraction for Q_scale, rounded up. Use
+// constant arguments so the division happens at compile time. Needs
+// num < den <= 65536; Q_scale is then exact.
+#define Q_RATIO(num, den) \
+	((uint32_t) ((((uint64_t) (num) << 32) + (den) - 1) / (den)))
+
+// a * b with rounding toward minus infinity, -1 * -1 saturates to MAX
+q15_t Q15_mul(q15_t a, q15_t b);
+q31_t Q31_mul(q31_t a, q31_t b);
+
+// Sum of a[i] * b[i] accumulated in 64 bits, saturated to Q31
+q31_t Q15_dot(const q15_t a[], const q15_t b[], uint16_t length);
+
+// Clamp to the Q15/Q31 range
+q15_t Q15_sat(int32_t value);
+q31_t Q31_sat(int64_t value);
+
+// floor(value * num / den) for ratio = Q_RATIO(num, den), no division
+uint16_t Q_scale(uint16_t value, uint32_t ratio);
+
+#endif /* QMATH_H_ */
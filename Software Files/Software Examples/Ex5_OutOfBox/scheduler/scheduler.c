@@ -0,0 +1,135 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "scheduler.h"
+
+// every task that has been scheduled or posted, caller owned
+static Task* tasks = 0;
+static volatile bool sleeping = false;
+
+static void Scheduler_add(Task* task)
+{
+    if (task->added)
+        return;
+    task->added = true;
+    task->next = tasks;
+    tasks = task;
+}
+
+static void Scheduler_release(Task* task, uint32_t period, uint32_t deadline,
+                              uint32_t delay)
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+    Scheduler_add(task);
+    task->period = period;
+    task->deadline = deadline;
+    task->release = timer_now() + delay;
+    task->scheduled = true;
+    __set_interrupt_state(state);
+}
+
+void Scheduler_every(Task* task, uint32_t period, uint32_t deadline,
+                     uint32_t offset)
+{
+    Scheduler_release(task, period, deadline, offset);
+}
+
+void Scheduler_after(Task* task, uint32_t delay, uint32_t deadline)
+{
+    Scheduler_release(task, 0, deadline, delay);
+}
+
+void Scheduler_cancel(Task* task)
+{
+    task->scheduled = false;
+}
+
+bool Scheduler_post(Task* task)
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+    Scheduler_add(task);
+    task->posted = true;
+    __set_interrupt_state(state);
+    return sleeping;
+}
+
+// CCR0 reached the earliest release
+static bool Scheduler_wake(void)
+{
+    return sleeping;
+}
+
+// With interrupts disabled. Returns the task to run next, or 0 and the
+// earliest pending release in *wake (now if nothing is scheduled).
+static Task* Scheduler_next(uint32_t now, uint32_t* wake, bool* timed)
+{
+    Task* task;
+    Task* best = 0;
+    int32_t best_left = 0;
+
+    *timed = false;
+    *wake = now;
+    for (task = tasks; task; task = task->next) {
+        int32_t left;
+
+        if (task->posted)
+            return task;
+        if (!task->scheduled)
+            continue;
+        if ((int32_t)(now - task->release) < 0) {
+            if (!*timed || (int32_t)(task->release - *wake) < 0)
+                *wake = task->release;
+            *timed = true;
+            continue;
+        }
+        left = (int32_t)(task->release + task->deadline - now);
+        if (!best || left < best_left) {
+            best = task;
+            best_left = left;
+        }
+    }
+    return best;
+}
+
+void Scheduler_run(void)
+{
+    while (1) {
+        uint32_t now;
+        uint32_t wake;
+        bool timed;
+        Task* task;
+
+        __disable_interrupt();
+        now = timer_now();
+        task = Scheduler_next(now, &wake, &timed);
+        if (task) {
+            if (task->posted) {
+                task->posted = false;
+            } else if (task->period) {
+                do {
+                    task->release += task->period;
+                } while ((int32_t)(now - task->release) >= 0);
+            } else {
+                task->scheduled = false;
+            }
+            __enable_interrupt();
+            task->run();
+            continue;
+        }
+        // nothing ready, sleep until the next release or a post
+        if (timed && !timer_wakeAt(wake, Scheduler_wake)) {
+            __enable_interrupt();
+            continue;
+        }
+        sleeping = true;
+        __bis_SR_register(SCHEDULER_SLEEP + GIE);
+        __disable_interrupt();
+        sleeping = false;
+        __enable_interrupt();
+    }
+}
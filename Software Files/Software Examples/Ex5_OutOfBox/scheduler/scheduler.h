@@ -0,0 +1,52 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "driverlib.h"
+#include "timers.h"
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+// Cooperative, tickless task scheduler on the TA0 time base.
+//
+// Tasks run to completion from Scheduler_run with interrupts enabled. When
+// none is ready the timer is armed for the earliest release and the CPU
+// sleeps in SCHEDULER_SLEEP, so there are no wake-ups between releases.
+// Peripherals that need SMCLK request it while they run, so tasks can
+// leave transfers going into the sleep.
+// Ready tasks run in order of absolute deadline (release + deadline);
+// posted tasks run before timed ones. A periodic task that overruns skips
+// the releases it missed instead of running back to back.
+
+#define SCHEDULER_SLEEP (TIMER_SLEEP)
+
+typedef void (*TaskFunction)(void);
+
+typedef struct Task {
+    TaskFunction run;
+    uint32_t period;            // timer counts, 0 for a one shot
+    uint32_t deadline;          // timer counts after each release
+    // scheduler state
+    uint32_t release;
+    bool scheduled;
+    volatile bool posted;
+    bool added;
+    struct Task* next;
+} Task;
+
+// Releases the task every period counts, the first time offset from now
+void Scheduler_every(Task* task, uint32_t period, uint32_t deadline,
+                     uint32_t offset);
+// Releases the task once, delay counts from now
+void Scheduler_after(Task* task, uint32_t delay, uint32_t deadline);
+// Drops pending releases, a post already made still runs
+void Scheduler_cancel(Task* task);
+// ISR safe. Runs the task as soon as main gets to it; from an ISR wake
+// main with __bic_SR_register_on_exit(SCHEDULER_SLEEP) if it returns true.
+bool Scheduler_post(Task* task);
+// Never returns
+void Scheduler_run(void);
+
+#endif /* SCHEDULER_H_ */
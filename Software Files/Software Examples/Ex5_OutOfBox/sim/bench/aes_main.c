@@ -0,0 +1,316 @@
+/*
+ * aes_main.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim/sim.h"
+#include "aes/aes_ctr.h"
+#include "uart/uart.h"
+#include "uart/frame.h"
+#include "crc/crc_soft.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// sim_memmap.h renames the firmware's main
+#undef main
+
+// Frame encryption benchmark, AES_CTR_PIPELINE against AES_CTR_BLOCKING on
+// the simulated MSP430 (see ../README.md):
+//
+//   keystream  AesCtr_apply on --bytes zero bytes in --chunk byte calls:
+//              simulated time and active cycles per byte
+//   frames     --frames block frames of up to --records readings (as many
+//              as fit), each one built, encrypted with Frame_encrypt and sent with
+//              UART_transmitAsyncDMA at 115200 baud while the next one is
+//              built: time until UCA3 is idle and active cycles
+//
+// The keystream and every frame on the wire are checked against
+// SimAes_encrypt; a mismatch fails the run. Results are printed as one
+// JSON object per line, mode and test.
+
+#define AES_BYTES_MAX       (16384)
+#define AES_CHUNK_MAX       (255)
+#define AES_FRAMES_MAX      (64)
+#define AES_FRAME_SIZE      (FRAME_BLOCK_MAX_SIZE + FRAME_ENCRYPTED_SIZE)
+#define AES_WIRE_MAX        (AES_FRAMES_MAX * AES_FRAME_SIZE)
+// replayed readings are this old
+#define AES_AGE_S           (60)
+
+typedef struct {
+    const char* name;
+    uint8_t mode;
+} AesMode;
+
+static const AesMode modes[] = {
+    { "pipeline", AES_CTR_PIPELINE },
+    { "blocking", AES_CTR_BLOCKING },
+};
+
+// FIPS-197 example key, as in main.c
+static const uint8_t key[AES_CTR_KEY_SIZE] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F
+};
+
+// options and the mode under test, read by the firmware side
+static uint32_t bytes = 4096;
+static uint8_t chunk = 32;
+static uint8_t frames = 16;
+static uint8_t records = 30;
+static uint8_t mode;
+static uint32_t packed;
+
+static uint8_t keystream[AES_BYTES_MAX];
+static uint32_t keystream_start;
+
+// frames as built, before Frame_encrypt, and what went out of UCA3
+static uint8_t plain[AES_FRAMES_MAX][AES_FRAME_SIZE];
+static uint8_t plain_length[AES_FRAMES_MAX];
+static uint8_t wire[AES_WIRE_MAX];
+static uint16_t wire_length = 0;
+
+// The keystream byte at position, in software
+static uint8_t Aes_keystreamAt(uint32_t position)
+{
+    static uint32_t cached = UINT32_MAX;
+    static uint8_t block[SIM_AES_BLOCK_SIZE];
+    uint8_t counter[SIM_AES_BLOCK_SIZE] = { 0 };
+    uint32_t index = position / SIM_AES_BLOCK_SIZE;
+
+    if (index != cached) {
+        counter[12] = index >> 24;
+        counter[13] = index >> 16;
+        counter[14] = index >> 8;
+        counter[15] = index;
+        SimAes_encrypt(key, counter, block);
+        cached = index;
+    }
+    return block[position % SIM_AES_BLOCK_SIZE];
+}
+
+//*****************************************************************************
+// MSP430 side, runs under the simulator
+//*****************************************************************************
+static void Aes_capture(SimUart* uart, uint8_t data)
+{
+    (void) uart;
+    if (wire_length < AES_WIRE_MAX)
+        wire[wire_length++] = data;
+}
+
+static void Aes_initBoard(void)
+{
+    WDT_A_hold(WDT_A_BASE);
+    CS_setDCOFreq(CS_DCORSEL_0, CS_DCOFSEL_6);
+    CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+    CS_initClockSignal(CS_MCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+    PMM_unlockLPM5();
+    UART_init(EUSCI_A3_BASE);
+    __enable_interrupt();
+}
+
+static void Aes_initMode(void)
+{
+    AesCtr_init(key, mode);
+}
+
+static void Aes_keystream(void)
+{
+    uint32_t done, n;
+
+    memset(keystream, 0, bytes);
+    for (done = 0; done < bytes; done += n) {
+        n = bytes - done < chunk ? bytes - done : chunk;
+        if (done == 0)
+            keystream_start = AesCtr_apply(keystream, n);
+        else
+            AesCtr_apply(keystream + done, n);
+    }
+}
+
+// Two buffers: the next frame is built and encrypted while the DMA sends
+// the previous one
+static void Aes_frames(void)
+{
+    static uint8_t buffer[2][AES_FRAME_SIZE];
+    FrameBlock block;
+    uint8_t* frame;
+    uint8_t length;
+    uint8_t f, r;
+
+    packed = 0;
+    for (f = 0; f < frames; f++) {
+        frame = buffer[f % 2];
+        Frame_blockBegin(&block, frame, f);
+        for (r = 0; r < records; r++) {
+            if (!Frame_blockAdd(&block, r % CHANNEL_COUNT,
+                    25278 + 7 * (r / CHANNEL_COUNT) + f, AES_AGE_S + r))
+                break;
+        }
+        packed += Frame_blockCount(&block);
+        length = Frame_blockEnd(&block);
+        memcpy(plain[f], frame, length);
+        plain_length[f] = length;
+        length = Frame_encrypt(frame, length, AesCtr_apply);
+        UART_waitDMA();
+        UART_transmitAsyncDMA(EUSCI_A3_BASE, frame, length, 0);
+    }
+    UART_waitDMA();
+    while (UART_isTransmitting(EUSCI_A3_BASE))
+        __delay_cycles(80);
+}
+
+//*****************************************************************************
+// Checks, on the host
+//*****************************************************************************
+static bool Aes_checkKeystream(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < bytes; i++) {
+        if (keystream[i] != Aes_keystreamAt(keystream_start + i)) {
+            fprintf(stderr, "aes: keystream byte %lu is wrong\n",
+                    (unsigned long) (keystream_start + i));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decrypts every frame on the wire and compares it with the frame as built
+static bool Aes_checkFrames(void)
+{
+    uint8_t decrypted[AES_FRAME_SIZE];
+    uint16_t offset = 0;
+    uint32_t position;
+    uint8_t length, rest, i;
+    uint8_t f;
+
+    for (f = 0; f < frames; f++) {
+        const uint8_t* frame = &wire[offset];
+
+        length = FRAME_HEADER_SIZE + frame[1];
+        if (offset + length > wire_length || frame[0] != FRAME_SYNC
+                || frame[2] != FRAME_ENCRYPTED
+                || length != plain_length[f] + FRAME_ENCRYPTED_SIZE
+                || CrcSoft_crc16(frame, length - FRAME_CRC_SIZE)
+                        != (frame[length - 2] | frame[length - 1] << 8)) {
+            fprintf(stderr, "aes: frame %u is not an encrypted frame\n", f);
+            return false;
+        }
+        position = frame[4] | (uint32_t) frame[5] << 8
+                | (uint32_t) frame[6] << 16 | (uint32_t) frame[7] << 24;
+        rest = length - 8 - FRAME_CRC_SIZE;
+        for (i = 0; i < rest; i++)
+            decrypted[i] = frame[8 + i] ^ Aes_keystreamAt(position + i);
+        // CHANNEL, SEQ, the rest of the payload
+        if (decrypted[0] != plain[f][2] || frame[3] != plain[f][3]
+                || memcmp(&decrypted[1], &plain[f][4], rest - 1)) {
+            fprintf(stderr, "aes: frame %u does not decrypt\n", f);
+            return false;
+        }
+        offset += length;
+    }
+    return true;
+}
+
+//*****************************************************************************
+// One mode
+//*****************************************************************************
+static bool Aes_mode(const AesMode* m)
+{
+    uint64_t start, active;
+
+    mode = m->mode;
+    if (!Sim_call(Aes_initMode, SIM_CYCLES_MS(10)))
+        return false;
+
+    active = Sim_stats.active;
+    start = Sim_now();
+    if (!Sim_call(Aes_keystream, SIM_CYCLES_MS(10000)))
+        return false;
+    active = Sim_stats.active - active;
+    start = Sim_now() - start;
+    if (!Aes_checkKeystream())
+        return false;
+    printf("{\"mode\":\"%s\",\"test\":\"keystream\",\"bytes\":%lu,"
+            "\"chunk\":%u,\"cycles_per_byte\":%.2f,"
+            "\"active_cycles_per_byte\":%.2f,\"kbyte_per_s\":%.1f}\n",
+            m->name, (unsigned long) bytes, chunk, (double) start / bytes,
+            (double) active / bytes,
+            bytes * (double) SIM_MCLK_HZ / start / 1000);
+
+    wire_length = 0;
+    active = Sim_stats.active;
+    start = Sim_now();
+    if (!Sim_call(Aes_frames, SIM_CYCLES_MS(10000)))
+        return false;
+    active = Sim_stats.active - active;
+    start = Sim_now() - start;
+    if (!Aes_checkFrames())
+        return false;
+    printf("{\"mode\":\"%s\",\"test\":\"frames\",\"frames\":%u,"
+            "\"readings\":%lu,\"wire_bytes\":%u,\"line_us\":%.1f,"
+            "\"active_cycles\":%llu,\"active_cycles_per_frame\":%.1f}\n",
+            m->name, frames, (unsigned long) packed, wire_length,
+            start * 1e6 / SIM_MCLK_HZ, (unsigned long long) active,
+            (double) active / frames);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned long value;
+    uint8_t i;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (arg + 1 >= argc || argv[arg][0] != '-') {
+            arg = 0;
+            break;
+        }
+        value = strtoul(argv[arg + 1], 0, 10);
+        if (!strcmp(argv[arg], "--bytes") && value > 0
+                && value <= AES_BYTES_MAX) {
+            bytes = value;
+        } else if (!strcmp(argv[arg], "--chunk") && value > 0
+                && value <= AES_CHUNK_MAX) {
+            chunk = value;
+        } else if (!strcmp(argv[arg], "--frames") && value > 0
+                && value <= AES_FRAMES_MAX) {
+            frames = value;
+        } else if (!strcmp(argv[arg], "--records") && value > 0
+                && value <= FRAME_BLOCK_RECORDS) {
+            records = value;
+        } else {
+            arg = 0;
+            break;
+        }
+        arg++;
+    }
+    if (arg == 0) {
+        fprintf(stderr, "usage: %s [--bytes N (1..%u)] [--chunk N (1..%u)]"
+                " [--frames N (1..%u)] [--records N (1..%u)]\n", argv[0],
+                AES_BYTES_MAX, AES_CHUNK_MAX, AES_FRAMES_MAX,
+                FRAME_BLOCK_RECORDS);
+        return 2;
+    }
+
+    Sim_init();
+    SimTimer_init();
+    SimDma_init();
+    SimSystem_init();
+    SimAes_init();
+    SimUart_init(EUSCI_A3_BASE, "UCA3", Aes_capture);
+    if (!Sim_call(Aes_initBoard, SIM_CYCLES_MS(100)))
+        return 1;
+
+    for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (!Aes_mode(&modes[i]))
+            return 1;
+    }
+    return 0;
+}
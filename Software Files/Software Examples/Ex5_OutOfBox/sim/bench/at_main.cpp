@@ -0,0 +1,283 @@
+// AT parser benchmark and fuzz target, on the host. at_parser.cpp is the
+// sketch's own file; the command table has the sketch's names, the
+// handlers only split and convert their arguments the way the sketch's do.
+//
+//   bench   a mix of the lines the MSP430 and a terminal send, pushed byte
+//           by byte and dispatched: commands per second of host CPU time
+//   fuzz    random and mutated lines through the parser. Every line has to
+//           reach exactly one handler with slices inside the line buffer,
+//           and At_toLong has to agree with strtol.
+//
+// LLVMFuzzerTestOneInput is the libFuzzer entry point; built with
+// -DAT_FUZZ -fsanitize=fuzzer it replaces main. Results are printed as
+// one JSON object per line, a failed check fails the run.
+
+#include "at_parser.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// longest fuzz input, past AT_LINE_MAX to reach the overflow path
+#define AT_FUZZ_MAX (AT_LINE_MAX + 64)
+
+static AtParser parser;
+static uint32_t dispatched;
+static uint32_t unknown;
+static long sink;
+static bool failed;
+
+static uint64_t At_ns()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static void At_fail(const char *what, const AtRequest *request)
+{
+  fprintf(stderr, "at: %s: \"%.*s\"\n", what, (int)request->line.len, request->line.ptr);
+  failed = true;
+}
+
+// true if slice lies within the line of request
+static bool At_inside(AtSlice slice, const AtRequest *request)
+{
+  return slice.ptr >= request->line.ptr && slice.len <= request->line.len &&
+         slice.ptr + slice.len <= request->line.ptr + request->line.len;
+}
+
+// At_toLong against strtol on the same text, for -?[0-9]+ only: strtol
+// also takes spaces and '+'
+static void At_checkLong(AtSlice slice, const AtRequest *request)
+{
+  char text[AT_LINE_MAX];
+  long value = 0, expected;
+  bool number = slice.len > 0 && slice.len < sizeof(text);
+  char *end;
+  for (size_t i = 0; number && i < slice.len; i++) {
+    number = (slice.ptr[i] >= '0' && slice.ptr[i] <= '9') || (i == 0 && slice.ptr[i] == '-' && slice.len > 1);
+  }
+  bool ok = At_toLong(slice, &value);
+  if (!number) {
+    if (ok) {
+      At_fail("At_toLong took something that is no number", request);
+    }
+    return;
+  }
+  memcpy(text, slice.ptr, slice.len);
+  text[slice.len] = '\0';
+  errno = 0;
+  expected = strtol(text, &end, 10);
+  if (ok != (errno == 0) || (ok && value != expected)) {
+    At_fail("At_toLong differs from strtol", request);
+  }
+  sink ^= value;
+}
+
+// Checks the request, then splits and converts the arguments like the
+// sketch's handlers: "<name>,<value>;..." and numbers
+static void At_handle(const AtRequest *request)
+{
+  char copy[64];
+  dispatched++;
+  if (!At_inside(request->name, request) || !At_inside(request->args, request)) {
+    At_fail("slice outside the line", request);
+  }
+  if (request->hasArgs != (request->args.ptr > request->name.ptr + request->name.len)) {
+    At_fail("arguments do not follow the name", request);
+  }
+  At_checkLong(request->args, request);
+  AtSlice rest = request->args;
+  size_t total = 0, tokens = 0;
+  while (rest.len > 0) {
+    AtSlice reading = At_nextToken(&rest, ';');
+    AtSlice name = At_nextToken(&reading, ',');
+    if (!At_inside(name, request) || !At_inside(reading, request)) {
+      At_fail("token outside the line", request);
+    }
+    if (At_copy(name, copy, sizeof(copy)) && strlen(copy) > name.len) {
+      At_fail("At_copy", request);
+    }
+    At_checkLong(reading, request);
+    total += name.len + reading.len;
+    tokens++;
+  }
+  // only the separators are left out
+  if (total > request->args.len || total + 2 * tokens < request->args.len) {
+    At_fail("tokens do not add up", request);
+  }
+}
+
+static void At_unknown(const AtRequest *request)
+{
+  unknown++;
+  if (!At_inside(request->name, request) || !At_inside(request->args, request)) {
+    At_fail("slice outside the line", request);
+  }
+}
+
+// ESP32Firmware.ino's table
+static const AtCommand commands[] = {
+  { "",             At_handle },
+  { "ssid",         At_handle },
+  { "pass",         At_handle },
+  { "connString",   At_handle },
+  { "telemetry",    At_handle },
+  { "batch",        At_handle },
+  { "batchSize",    At_handle },
+  { "batchDeadline", At_handle },
+  { "queue",        At_handle },
+  { "replayInterval", At_handle },
+  { "mode",         At_handle },
+  { "baud",         At_handle },
+  { "latency",      At_handle },
+  { "sleep",        At_handle },
+};
+
+static void At_init()
+{
+  if (!AtParser_init(&parser, commands, sizeof(commands) / sizeof(commands[0]), At_unknown)) {
+    fprintf(stderr, "at: the table does not fit the index\n");
+    exit(1);
+  }
+}
+
+// Pushes data and dispatches every complete line, returns the lines
+static uint32_t At_feed(const uint8_t *data, size_t size)
+{
+  uint32_t lines = 0;
+  for (size_t i = 0; i < size; i++) {
+    if (AtParser_push(&parser, (char)data[i])) {
+      AtParser_dispatch(&parser);
+      lines++;
+    }
+  }
+  return lines;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  static bool initialized = false;
+  if (!initialized) {
+    At_init();
+    initialized = true;
+  }
+  uint32_t before = dispatched + unknown;
+  uint32_t lines = At_feed(data, size);
+  // a line left open is closed, so the next input starts clean
+  if (AtParser_push(&parser, '\r')) {
+    AtParser_dispatch(&parser);
+    lines++;
+  }
+  if (dispatched + unknown - before != lines) {
+    fprintf(stderr, "at: %lu lines, %lu handler calls\n", (unsigned long)lines,
+            (unsigned long)(dispatched + unknown - before));
+    failed = true;
+  }
+  if (failed) {
+    abort();
+  }
+  return 0;
+}
+
+#ifndef AT_FUZZ
+static const char *const mix[] = {
+  "AT+telemetry=temperature,25.31\r",
+  "AT+telemetry=humidity,48.20\r",
+  "AT+batch=temperature,25.31;humidity,48.20;moisture,31.5;light,72.0\r",
+  "AT+batchSize=4\r",
+  "AT+queue\r",
+  "AT\r",
+  "AT+mode=0\r",
+  "AT+nothing=1\r\n",
+};
+
+static void At_bench(uint32_t iterations)
+{
+  uint32_t lines = 0;
+  size_t bytes = 0;
+  uint64_t start = At_ns();
+  for (uint32_t i = 0; i < iterations; i++) {
+    for (size_t m = 0; m < sizeof(mix) / sizeof(mix[0]); m++) {
+      size_t length = strlen(mix[m]);
+      lines += At_feed((const uint8_t *)mix[m], length);
+      bytes += length;
+    }
+  }
+  uint64_t ns = At_ns() - start;
+  printf("{\"test\":\"bench\",\"commands\":%lu,\"bytes\":%lu,\"ns_per_command\":%.1f,"
+         "\"commands_per_s\":%.0f,\"ns_per_byte\":%.2f}\n", (unsigned long)lines,
+         (unsigned long)bytes, (double)ns / lines, lines * 1e9 / ns, (double)ns / bytes);
+}
+
+// Random bytes biased towards what the parser looks at, and mutated
+// lines of the mix
+static void At_fuzz(uint32_t inputs, uint32_t seed)
+{
+  static const char alphabet[] = "AT+=,;-0123456789\r\n";
+  uint8_t input[AT_FUZZ_MAX];
+  srand(seed);
+  dispatched = 0;
+  unknown = 0;
+  for (uint32_t n = 0; n < inputs; n++) {
+    size_t size;
+    if (n % 2) {
+      const char *line = mix[rand() % (sizeof(mix) / sizeof(mix[0]))];
+      size = strlen(line);
+      memcpy(input, line, size);
+      for (int flips = rand() % 4; flips >= 0; flips--) {
+        input[rand() % size] = rand() % 3 ? alphabet[rand() % (sizeof(alphabet) - 1)] : rand();
+      }
+    } else {
+      size = rand() % AT_FUZZ_MAX;
+      for (size_t i = 0; i < size; i++) {
+        input[i] = rand() % 4 ? alphabet[rand() % (sizeof(alphabet) - 1)] : rand();
+      }
+      // numbers around the limits of a long
+      if (size > 30 && rand() % 2) {
+        memcpy(input, "AT+baud=", 8);
+        for (size_t i = 8; i < 30; i++) {
+          input[i] = '0' + rand() % 10;
+        }
+        input[8 + rand() % 22] = '\r';
+      }
+    }
+    LLVMFuzzerTestOneInput(input, size);
+  }
+  printf("{\"test\":\"fuzz\",\"result\":\"pass\",\"inputs\":%lu,\"commands\":%lu,\"unknown\":%lu}\n",
+         (unsigned long)inputs, (unsigned long)dispatched, (unsigned long)unknown);
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t iterations = 1000000;
+  uint32_t inputs = 1000000;
+  uint32_t seed = 1;
+  for (int arg = 1; arg < argc; arg++) {
+    if (!strcmp(argv[arg], "--iterations") && arg + 1 < argc) {
+      iterations = strtoul(argv[++arg], 0, 10);
+    } else if (!strcmp(argv[arg], "--fuzz") && arg + 1 < argc) {
+      inputs = strtoul(argv[++arg], 0, 10);
+    } else if (!strcmp(argv[arg], "--seed") && arg + 1 < argc) {
+      seed = strtoul(argv[++arg], 0, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--iterations N] [--fuzz N] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (iterations == 0) {
+    iterations = 1;
+  }
+
+  At_init();
+  At_bench(iterations);
+  if (failed) {
+    return 1;
+  }
+  At_fuzz(inputs, seed);
+  return 0;
+}
+#endif
@@ -0,0 +1,36 @@
+/*
+ * bench.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ESP32 side of the benchmark, the sketch itself (bench_esp32.cpp)
+typedef struct {
+    uint32_t replies;           // bytes the sketch wrote to Serial
+    uint32_t messages;          // MQTT messages published
+    uint32_t payload;           // bytes in those messages
+} BenchEsp32Stats;
+
+// setup() and the WiFi provisioning commands
+void BenchEsp32_init(bool echo);
+// Hands length bytes to Serial and runs loop() until they are read, then
+// moves the clock ms ahead and runs loop() once more for the batch
+// deadline and the replay queue
+void BenchEsp32_run(const uint8_t data[], uint16_t length, uint32_t ms);
+// Running totals since BenchEsp32_init
+void BenchEsp32_stats(BenchEsp32Stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H_ */
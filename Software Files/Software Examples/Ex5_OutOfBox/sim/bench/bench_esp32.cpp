@@ -0,0 +1,44 @@
+// The ESP32 sketch driven by sim/bench: setup() once, then loop() on the
+// bytes the MSP430 put on the wire, with the stubbed Serial, WiFi and MQTT
+// client in esp32/.
+
+#include "esp32/Arduino.h"
+#include "esp32/Esp32MQTTClient.h"
+#include "bench.h"
+
+void setup();
+void loop();
+
+// AT+mode=0 (WiFi) and the credentials, like the MSP430 sends at startup
+static const char provisioning[] =
+  "AT+mode=0\rAT+ssid=bench\rAT+pass=bench\rAT+connString=HostName=bench\r";
+
+static void BenchEsp32_drain()
+{
+  // the real loop() reads at most 64 bytes per pass
+  while (Serial.available() > 0) {
+    loop();
+  }
+}
+
+extern "C" void BenchEsp32_init(bool echo)
+{
+  Serial.echo = echo;
+  setup();
+  BenchEsp32_run((const uint8_t *)provisioning, sizeof(provisioning) - 1, 1);
+}
+
+extern "C" void BenchEsp32_run(const uint8_t data[], uint16_t length, uint32_t ms)
+{
+  ArduinoStub_receive(data, length);
+  BenchEsp32_drain();
+  ArduinoStub_advance(ms * 1000UL);
+  loop();
+}
+
+extern "C" void BenchEsp32_stats(BenchEsp32Stats *stats)
+{
+  stats->replies = Serial.written;
+  stats->messages = mqttStubStats.messages;
+  stats->payload = mqttStubStats.bytes;
+}
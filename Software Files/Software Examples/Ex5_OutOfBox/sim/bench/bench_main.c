@@ -0,0 +1,346 @@
+/*
+ * bench_main.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim/sim.h"
+#include "uart/esp32.h"
+#include "i2c/sht35.h"
+#include "adc/adc.h"
+#include "timers.h"
+#include "crc/crc_soft.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// sim_memmap.h renames the firmware's main
+#undef main
+
+// Telemetry pipeline benchmark. One sampling cycle (four readings) goes
+// through each protocol option end to end:
+//
+//   format   MSP430 conversions to text (SHT35_get*, ADC_getPercentage),
+//            host CPU time
+//   send     ESP32_* on the simulated MSP430 until UCA3 is idle: active
+//            cycles (estimates, see sim.h) and the bytes on the wire
+//   uart     wire time of those bytes at each baud rate, 8N1
+//   esp32    the sketch's loop() parsing them and publishing through the
+//            stubbed MQTT client, host CPU time. The sketch does not
+//            forward a frame twice, so every pass gets the frames with
+//            new SEQs.
+//   payload  bytes published per reading
+//
+// Results are printed as one JSON object per line and protocol.
+
+#define BENCH_READINGS      (4)
+#define BENCH_WIRE_MAX      (512)
+#define BENCH_TEXT_SIZE     (16)
+// passes with different SEQs, more frames than the sketch remembers
+#define BENCH_COPIES        (64)
+// replayed readings are this old
+#define BENCH_AGE_S         (60)
+
+typedef struct {
+    const char* name;
+    bool text;                  // readings formatted on the MSP430
+    void (*send)(void);
+} BenchProtocol;
+
+static const uint32_t bauds[] = {
+    9600, 57600, 115200, 230400, 460800, 921600
+};
+
+// One cycle of raw readings: 22.5 C, 40 %RH and two ADC channels left
+// aligned to 16 bits
+static const uint8_t channels[BENCH_READINGS] = {
+    CHANNEL_TEMPERATURE, CHANNEL_HUMIDITY, CHANNEL_MOISTURE, CHANNEL_LIGHT
+};
+static const uint16_t raw[BENCH_READINGS] = { 25278, 26214, 11520, 24000 };
+static uint8_t* names[BENCH_READINGS] = {
+    (uint8_t*) "temperature", (uint8_t*) "humidity", (uint8_t*) "moisture",
+    (uint8_t*) "light"
+};
+static uint8_t text[BENCH_READINGS][BENCH_TEXT_SIZE];
+static uint8_t* values[BENCH_READINGS] = { text[0], text[1], text[2], text[3] };
+
+// what went out of UCA3
+static SimUart* uca3;
+static uint8_t wire[BENCH_WIRE_MAX];
+static uint16_t wire_length = 0;
+static uint8_t copies[BENCH_COPIES][BENCH_WIRE_MAX];
+
+static uint64_t Bench_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// Same conversions as send_readings() in main.c
+static void Bench_format(void)
+{
+    SHT35_getTemp(raw[0], text[0], BENCH_TEXT_SIZE);
+    SHT35_getHumidity(raw[1], text[1], BENCH_TEXT_SIZE);
+    ADC_getPercentage(text[2], BENCH_TEXT_SIZE, raw[2],
+            ADC_PERCENT_RATIO(ADC_SCALE(1100)));
+    ADC_getPercentage(text[3], BENCH_TEXT_SIZE, raw[3],
+            ADC_PERCENT_RATIO(ADC_SCALE(3000)));
+}
+
+//*****************************************************************************
+// MSP430 side, runs under the simulator
+//*****************************************************************************
+static void Bench_capture(SimUart* uart, uint8_t data)
+{
+    (void) uart;
+    if (wire_length < BENCH_WIRE_MAX)
+        wire[wire_length++] = data;
+}
+
+static void Bench_init(void)
+{
+    WDT_A_hold(WDT_A_BASE);
+    CS_setDCOFreq(CS_DCORSEL_0, CS_DCOFSEL_6);
+    CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+    CS_initClockSignal(CS_MCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+    PMM_unlockLPM5();
+    UART_init(EUSCI_A0_BASE);
+    UART_init(EUSCI_A3_BASE);
+    __enable_interrupt();
+}
+
+// Sleeps until the last byte has left UCA3
+static void Bench_waitLine(void)
+{
+    UART_waitDMA();
+    while (UART_isTransmitting(EUSCI_A3_BASE))
+        __delay_cycles(80);
+}
+
+static void Bench_flush(void)
+{
+    ESP32_flush();
+}
+
+static void Bench_sendTelemetry(void)
+{
+    uint8_t i;
+    for (i = 0; i < BENCH_READINGS; i++)
+        ESP32_telemetry(names[i], values[i]);
+    Bench_waitLine();
+}
+
+static void Bench_sendBatch(void)
+{
+    ESP32_telemetryBatch(names, values, BENCH_READINGS);
+    Bench_waitLine();
+}
+
+static void Bench_sendFrame(void)
+{
+    uint8_t i;
+    for (i = 0; i < BENCH_READINGS; i++)
+        ESP32_telemetryFrame(channels[i], raw[i]);
+    Bench_waitLine();
+}
+
+static void Bench_sendBlock(void)
+{
+    uint8_t i;
+
+    ESP32_blockBegin();
+    for (i = 0; i < BENCH_READINGS; i++)
+        ESP32_blockAdd(channels[i], raw[i], BENCH_AGE_S);
+    ESP32_blockSend();
+    Bench_waitLine();
+}
+
+// A window of 60 readings around raw[i]
+static void Bench_sendSummary(void)
+{
+    StatsSummary summary;
+    uint8_t i;
+
+    for (i = 0; i < BENCH_READINGS; i++) {
+        summary.count = 60;
+        summary.min = raw[i] - 20;
+        summary.max = raw[i] + 20;
+        summary.mean = raw[i];
+        summary.variance = 100;
+        ESP32_telemetrySummary(channels[i], &summary);
+    }
+    Bench_waitLine();
+}
+
+static void Bench_sendFrameAged(void)
+{
+    uint8_t i;
+    for (i = 0; i < BENCH_READINGS; i++)
+        ESP32_telemetryFrameAged(channels[i], raw[i], BENCH_AGE_S);
+    Bench_waitLine();
+}
+
+static const BenchProtocol protocols[] = {
+    { "telemetry", true, Bench_sendTelemetry },
+    { "batch", true, Bench_sendBatch },
+    { "frame", false, Bench_sendFrame },
+    { "frame_aged", false, Bench_sendFrameAged },
+    { "block", false, Bench_sendBlock },
+    { "summary", false, Bench_sendSummary },
+};
+
+//*****************************************************************************
+// Host side
+//*****************************************************************************
+// Answers every frame on the wire "OK <seq>" and lets the MSP430 take the
+// answers, so the next protocol starts with an empty window. AT commands
+// are not waited for.
+static bool Bench_answer(void)
+{
+    char answer[16];
+    uint16_t offset;
+    int length;
+
+    for (offset = 0; offset + 3 < wire_length && wire[offset] == FRAME_SYNC;
+            offset += FRAME_HEADER_SIZE + wire[offset + 1]) {
+        length = snprintf(answer, sizeof(answer), "OK %u\r\n",
+                wire[offset + 3]);
+        SimUart_input(uca3, (const uint8_t*) answer, length, 0);
+    }
+    return Sim_call(Bench_flush, SIM_CYCLES_MS(1000));
+}
+
+// copies[c] is the wire with c * frames added to every SEQ
+static void Bench_renumber(void)
+{
+    uint16_t offset, crc;
+    uint8_t frames = 0;
+    uint8_t* frame;
+    uint8_t c;
+
+    for (offset = 0; offset + 3 < wire_length && wire[offset] == FRAME_SYNC;
+            offset += FRAME_HEADER_SIZE + wire[offset + 1])
+        frames++;
+    for (c = 0; c < BENCH_COPIES; c++) {
+        memcpy(copies[c], wire, wire_length);
+        for (offset = 0; offset < wire_length && frames > 0;
+                offset += FRAME_HEADER_SIZE + frame[1]) {
+            frame = &copies[c][offset];
+            frame[3] += c * frames;
+            crc = CrcSoft_crc16(frame, FRAME_HEADER_SIZE + frame[1]
+                    - FRAME_CRC_SIZE);
+            frame[FRAME_HEADER_SIZE + frame[1] - 2] = crc & 0xFF;
+            frame[FRAME_HEADER_SIZE + frame[1] - 1] = crc >> 8;
+        }
+    }
+}
+
+//*****************************************************************************
+// One protocol end to end
+//*****************************************************************************
+static bool Bench_protocol(const BenchProtocol* protocol, uint32_t iterations)
+{
+    uint64_t format_ns = 0;
+    uint64_t esp32_ns;
+    uint64_t start;
+    uint64_t active;
+    uint64_t line;
+    BenchEsp32Stats before, after;
+    uint32_t i;
+    uint8_t b;
+
+    // format
+    if (protocol->text) {
+        start = Bench_ns();
+        for (i = 0; i < iterations; i++)
+            Bench_format();
+        format_ns = Bench_ns() - start;
+    }
+
+    // send, once: the simulation is deterministic
+    wire_length = 0;
+    active = Sim_stats.active;
+    start = Sim_now();
+    if (!Sim_call(protocol->send, SIM_CYCLES_MS(1000)))
+        return false;
+    active = Sim_stats.active - active;
+    line = Sim_now() - start;
+    if (wire_length == BENCH_WIRE_MAX) {
+        fprintf(stderr, "bench: %s: more than %u bytes\n", protocol->name,
+                BENCH_WIRE_MAX);
+        return false;
+    }
+    Bench_renumber();
+    if (!Bench_answer())
+        return false;
+
+    // esp32: the same bytes every report interval, the batch deadline and
+    // the replay interval pass in between
+    BenchEsp32_run(0, 0, 10000);
+    BenchEsp32_stats(&before);
+    start = Bench_ns();
+    for (i = 0; i < iterations; i++)
+        BenchEsp32_run(copies[i % BENCH_COPIES], wire_length,
+                REPORT_INTERVAL_MS);
+    esp32_ns = Bench_ns() - start;
+    BenchEsp32_stats(&after);
+
+    printf("{\"protocol\":\"%s\",\"readings\":%u,\"wire_bytes\":%u,"
+            "\"wire_bytes_per_reading\":%.2f,\"reply_bytes\":%.2f,"
+            "\"uart_us\":{", protocol->name, BENCH_READINGS, wire_length,
+            (double) wire_length / BENCH_READINGS,
+            (double) (after.replies - before.replies) / iterations);
+    for (b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++)
+        printf("%s\"%lu\":%.1f", b ? "," : "", (unsigned long) bauds[b],
+                wire_length * 10 * 1e6 / bauds[b]);
+    printf("},\"msp430_format_ns\":%.1f,\"msp430_send_cycles\":%llu,"
+            "\"msp430_line_us\":%.1f,\"esp32_loop_ns\":%.1f,"
+            "\"mqtt_messages\":%.3f,\"payload_bytes\":%.2f,"
+            "\"payload_bytes_per_reading\":%.2f}\n",
+            (double) format_ns / iterations, (unsigned long long) active,
+            line * 1e6 / SIM_MCLK_HZ, (double) esp32_ns / iterations,
+            (double) (after.messages - before.messages) / iterations,
+            (double) (after.payload - before.payload) / iterations,
+            (double) (after.payload - before.payload) / iterations
+                    / BENCH_READINGS);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t iterations = 10000;
+    bool echo = false;
+    uint8_t i;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "--iterations") && arg + 1 < argc) {
+            iterations = strtoul(argv[++arg], 0, 10);
+        } else if (!strcmp(argv[arg], "--echo")) {
+            echo = true;
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--echo]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    Sim_init();
+    SimTimer_init();
+    SimDma_init();
+    SimSystem_init();
+    SimUart_init(EUSCI_A0_BASE, "UCA0", 0);
+    uca3 = SimUart_init(EUSCI_A3_BASE, "UCA3", Bench_capture);
+    if (!Sim_call(Bench_init, SIM_CYCLES_MS(100)))
+        return 1;
+    BenchEsp32_init(echo);
+
+    for (i = 0; i < sizeof(protocols) / sizeof(protocols[0]); i++) {
+        if (!Bench_protocol(&protocols[i], iterations))
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * codec_main.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "codec/delta.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Block codec benchmark on recorded traces. A trace has one reading per
+// line, "seconds,channel,value" with the raw value, as written by
+// ex5_sim --trace. Each channel is cut into blocks of --block readings and
+// every block is encoded, decoded and compared with the input; a mismatch
+// fails the run.
+//
+// Sizes are compared with the raw value as decimal text plus one separator
+// (the text protocols) and as 2 binary bytes (frames). Timings are host
+// CPU time per reading and only compare options against each other.
+
+#define CODEC_CHANNELS      (4)
+#define CODEC_BLOCK_MAX     (1024)
+#define CODEC_OUT_SIZE      (CODEC_BLOCK_MAX * DELTA_VARINT_MAX)
+
+typedef struct {
+    uint16_t* values;
+    uint32_t count;
+    uint32_t size;
+} CodecSeries;
+
+static CodecSeries series[CODEC_CHANNELS];
+
+static uint64_t Codec_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static bool Codec_append(CodecSeries* s, uint16_t value)
+{
+    if (s->count == s->size) {
+        uint32_t size = s->size ? 2 * s->size : 1024;
+        uint16_t* values = realloc(s->values, size * sizeof(values[0]));
+        if (values == 0)
+            return false;
+        s->values = values;
+        s->size = size;
+    }
+    s->values[s->count++] = value;
+    return true;
+}
+
+static bool Codec_read(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    char line[128];
+    double seconds;
+    unsigned channel, value;
+    unsigned long number = 0;
+
+    if (file == 0) {
+        perror(path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        if (sscanf(line, "%lf,%u,%u", &seconds, &channel, &value) != 3
+                || channel >= CODEC_CHANNELS || value > 0xFFFF) {
+            fprintf(stderr, "%s:%lu: expected seconds,channel,value\n", path,
+                    number);
+            fclose(file);
+            return false;
+        }
+        if (!Codec_append(&series[channel], value)) {
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static uint32_t Codec_textBytes(const CodecSeries* s)
+{
+    char text[8];
+    uint32_t bytes = 0;
+    uint32_t i;
+
+    for (i = 0; i < s->count; i++)
+        bytes += snprintf(text, sizeof(text), "%u", s->values[i]) + 1;
+    return bytes;
+}
+
+// Encodes and decodes s in blocks, iterations times. Returns false on a
+// round trip mismatch.
+static bool Codec_run(const CodecSeries* s, uint16_t block,
+        uint32_t iterations, uint32_t* bytes, uint64_t* encode_ns,
+        uint64_t* decode_ns)
+{
+    static uint8_t out[CODEC_OUT_SIZE];
+    static uint16_t decoded[CODEC_BLOCK_MAX];
+    uint32_t start, n;
+    uint16_t length;
+    uint32_t i;
+    uint64_t t;
+
+    *bytes = 0;
+    *encode_ns = 0;
+    *decode_ns = 0;
+    for (start = 0; start < s->count; start += block) {
+        n = s->count - start < block ? s->count - start : block;
+        t = Codec_ns();
+        for (i = 0; i < iterations; i++)
+            length = Delta_encode(s->values + start, n, out, sizeof(out));
+        *encode_ns += Codec_ns() - t;
+        t = Codec_ns();
+        for (i = 0; i < iterations; i++)
+            Delta_decode(out, length, decoded, n);
+        *decode_ns += Codec_ns() - t;
+        if (length == 0 || Delta_decode(out, length, decoded, n) != length
+                || memcmp(decoded, s->values + start, n * sizeof(decoded[0])))
+            return false;
+        *bytes += length;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t iterations = 100;
+    uint16_t block = 30;
+    uint32_t total_count = 0, total_text = 0, total_codec = 0;
+    uint32_t bytes, text;
+    uint64_t encode_ns, decode_ns;
+    bool traces = false;
+    uint8_t channel;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "--iterations") && arg + 1 < argc) {
+            iterations = strtoul(argv[++arg], 0, 10);
+        } else if (!strcmp(argv[arg], "--block") && arg + 1 < argc) {
+            block = strtoul(argv[++arg], 0, 10);
+        } else if (argv[arg][0] != '-') {
+            if (!Codec_read(argv[arg]))
+                return 1;
+            traces = true;
+        } else {
+            traces = false;
+            break;
+        }
+    }
+    if (!traces || block == 0 || block > CODEC_BLOCK_MAX) {
+        fprintf(stderr, "usage: %s [--iterations N] [--block N (1..%u)]"
+                " trace.csv...\n", argv[0], CODEC_BLOCK_MAX);
+        return 2;
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    for (channel = 0; channel < CODEC_CHANNELS; channel++) {
+        const CodecSeries* s = &series[channel];
+
+        if (s->count == 0)
+            continue;
+        if (!Codec_run(s, block, iterations, &bytes, &encode_ns,
+                &decode_ns)) {
+            fprintf(stderr, "codec: channel %u does not round trip\n",
+                    channel);
+            return 1;
+        }
+        text = Codec_textBytes(s);
+        printf("{\"channel\":%u,\"readings\":%lu,\"block\":%u,"
+                "\"text_bytes\":%lu,\"binary_bytes\":%lu,\"codec_bytes\":%lu,"
+                "\"codec_bytes_per_reading\":%.2f,\"ratio_text\":%.2f,"
+                "\"ratio_binary\":%.2f,\"encode_ns\":%.1f,\"decode_ns\":%.1f}\n",
+                channel, (unsigned long) s->count, block, (unsigned long) text,
+                (unsigned long) s->count * 2, (unsigned long) bytes,
+                (double) bytes / s->count, (double) text / bytes,
+                2.0 * s->count / bytes,
+                (double) encode_ns / iterations / s->count,
+                (double) decode_ns / iterations / s->count);
+        total_count += s->count;
+        total_text += text;
+        total_codec += bytes;
+    }
+    if (total_count == 0) {
+        fprintf(stderr, "codec: no readings\n");
+        return 1;
+    }
+    printf("{\"channel\":\"all\",\"readings\":%lu,\"text_bytes\":%lu,"
+            "\"codec_bytes\":%lu,\"ratio_text\":%.2f,\"ratio_binary\":%.2f}\n",
+            (unsigned long) total_count, (unsigned long) total_text,
+            (unsigned long) total_codec, (double) total_text / total_codec,
+            2.0 * total_count / total_codec);
+    return 0;
+}
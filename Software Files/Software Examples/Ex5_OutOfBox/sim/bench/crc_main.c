@@ -0,0 +1,180 @@
+/*
+ * crc_main.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim/sim.h"
+#include "crc/crc_hw.h"
+#include "crc/crc_soft.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// sim_memmap.h renames the firmware's main
+#undef main
+
+// CRC benchmark. Crc_crc16 and Crc_crc32 run on the simulated MSP430 (see
+// ../README.md) with each feed of crc_hw.h, over buffers from a sample log
+// record up to 2 kB: simulated cycles per call and bytes per cycle. The
+// byte wise software CRCs of crc_soft.h, what the receiving side runs, are
+// timed on the host.
+//
+// Every result, also from a buffer at an odd address, is compared with
+// crc_soft.h; a mismatch fails the run. Results are printed as one JSON
+// object per line.
+
+#define CRC_BYTES_MAX       (2048)
+
+typedef struct {
+    const char* name;
+    uint8_t feed;
+} CrcFeed;
+
+static const CrcFeed feeds[] = {
+    { "byte", CRC_FEED_BYTE },
+    { "word", CRC_FEED_WORD },
+    { "dma", CRC_FEED_DMA },
+};
+
+// a sample log record, the deadband configuration, a frame, the largest
+// frame without its CRC, larger buffers
+static const uint16_t sizes[] = { 8, 24, 32, 64, 106, 512, CRC_BYTES_MAX };
+
+// word aligned, data + 1 is at an odd address
+static uint16_t words[CRC_BYTES_MAX / 2 + 1];
+static uint8_t* const data = (uint8_t*) words;
+
+// the call under test and its result, set and read on the host
+static const uint8_t* crc_data;
+static uint16_t crc_length;
+static bool crc_wide;
+static uint32_t crc_result;
+
+static uint64_t Crc_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//*****************************************************************************
+// MSP430 side, runs under the simulator
+//*****************************************************************************
+static void Crc_initBoard(void)
+{
+    WDT_A_hold(WDT_A_BASE);
+    CS_setDCOFreq(CS_DCORSEL_0, CS_DCOFSEL_6);
+    CS_initClockSignal(CS_MCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+    PMM_unlockLPM5();
+}
+
+static void Crc_call(void)
+{
+    if (crc_wide)
+        crc_result = Crc_crc32(crc_data, crc_length);
+    else
+        crc_result = Crc_crc16(crc_data, crc_length);
+}
+
+//*****************************************************************************
+// Host side
+//*****************************************************************************
+static uint32_t Crc_soft(bool wide, const uint8_t* in, uint16_t length)
+{
+    return wide ? CrcSoft_crc32(in, length) : CrcSoft_crc16(in, length);
+}
+
+// Runs one call on the simulator, returns false on a wrong result
+static bool Crc_run(bool wide, const uint8_t* in, uint16_t length,
+        uint64_t* cycles)
+{
+    uint64_t start = Sim_now();
+
+    crc_wide = wide;
+    crc_data = in;
+    crc_length = length;
+    if (!Sim_call(Crc_call, SIM_CYCLES_MS(100)))
+        return false;
+    *cycles = Sim_now() - start;
+    if (crc_result != Crc_soft(wide, in, length)) {
+        fprintf(stderr, "crc: %s of %u bytes at %s address is %lX\n",
+                wide ? "crc32" : "crc16", length,
+                ((uintptr_t) in & 1) ? "an odd" : "an even",
+                (unsigned long) crc_result);
+        return false;
+    }
+    return true;
+}
+
+static bool Crc_hardware(bool wide, const CrcFeed* feed, uint16_t length)
+{
+    uint64_t cycles, odd;
+
+    Crc_setFeed(feed->feed);
+    if (!Crc_run(wide, data, length, &cycles)
+            || !Crc_run(wide, data + 1, length, &odd))
+        return false;
+    printf("{\"crc\":\"%s\",\"feed\":\"%s\",\"bytes\":%u,\"cycles\":%llu,"
+            "\"cycles_per_byte\":%.2f,\"bytes_per_cycle\":%.3f,"
+            "\"cycles_odd_address\":%llu}\n", wide ? "crc32" : "crc16",
+            feed->name, length, (unsigned long long) cycles,
+            (double) cycles / length, (double) length / cycles,
+            (unsigned long long) odd);
+    return true;
+}
+
+static void Crc_software(bool wide, uint16_t length, uint32_t iterations)
+{
+    volatile uint32_t sink;
+    uint64_t start;
+    uint32_t i;
+
+    start = Crc_ns();
+    for (i = 0; i < iterations; i++)
+        sink = Crc_soft(wide, data, length);
+    (void) sink;
+    printf("{\"crc\":\"%s\",\"feed\":\"software\",\"bytes\":%u,"
+            "\"host_ns_per_byte\":%.3f}\n", wide ? "crc32" : "crc16", length,
+            (double) (Crc_ns() - start) / iterations / length);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t iterations = 10000;
+    uint16_t i;
+    uint8_t wide, f, s;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "--iterations") && arg + 1 < argc) {
+            iterations = strtoul(argv[++arg], 0, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    srand(1);
+    for (i = 0; i < sizeof(words); i++)
+        data[i] = rand();
+
+    Sim_init();
+    SimDma_init();
+    SimSystem_init();
+    if (!Sim_call(Crc_initBoard, SIM_CYCLES_MS(100)))
+        return 1;
+
+    for (wide = 0; wide < 2; wide++) {
+        for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            for (f = 0; f < sizeof(feeds) / sizeof(feeds[0]); f++) {
+                if (!Crc_hardware(wide, &feeds[f], sizes[s]))
+                    return 1;
+            }
+            Crc_software(wide, sizes[s], iterations);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Host stand-ins for the parts of the Arduino core and ESP32 SDK the
+// sketch uses, for sim/bench. Serial reads from a buffer the benchmark
+// fills and only counts what is written; millis() and micros() follow a
+// clock the benchmark moves.
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define RTC_DATA_ATTR
+
+class IPAddress {
+public:
+  uint8_t octets[4];
+};
+
+class HardwareSerial {
+public:
+  void begin(unsigned long baud) { this->baud = baud; }
+  void updateBaudRate(unsigned long baud) { this->baud = baud; }
+  int available();
+  int read();
+  size_t readBytes(uint8_t *buffer, size_t length);
+  void flush() {}
+
+  size_t print(const char *text) { return write(text, strlen(text)); }
+  size_t print(char c) { return write(&c, 1); }
+  size_t println() { return write("\r\n", 2); }
+  size_t println(const char *text) { return print(text) + println(); }
+  size_t println(int value) { return printf("%d\r\n", value); }
+  size_t println(unsigned long value) { return printf("%lu\r\n", value); }
+  size_t println(const IPAddress &address);
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  size_t write(const char *data, size_t length);
+
+  // what the sketch wrote, for the benchmark
+  unsigned long baud = 115200;
+  uint32_t written = 0;
+  bool echo = false;
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void randomSeed(unsigned long seed);
+int analogRead(uint8_t pin);
+
+void esp_sleep_enable_timer_wakeup(uint64_t us);
+void esp_deep_sleep_start();
+
+// for the benchmark: bytes for Serial to read, moving the clock
+void ArduinoStub_receive(const uint8_t *data, size_t length);
+void ArduinoStub_advance(unsigned long us);
+
+#endif
@@ -0,0 +1,18 @@
+// Azure IoT SDK types used by the sketch's callbacks, for sim/bench.
+
+#ifndef AZURE_IOT_HUB_H
+#define AZURE_IOT_HUB_H
+
+enum IOTHUB_CLIENT_CONFIRMATION_RESULT {
+  IOTHUB_CLIENT_CONFIRMATION_OK,
+  IOTHUB_CLIENT_CONFIRMATION_ERROR,
+};
+
+enum DEVICE_TWIN_UPDATE_STATE {
+  DEVICE_TWIN_UPDATE_COMPLETE,
+  DEVICE_TWIN_UPDATE_PARTIAL,
+};
+
+#define LogInfo(...) ((void)0)
+
+#endif
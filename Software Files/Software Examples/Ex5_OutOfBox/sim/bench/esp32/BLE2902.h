@@ -0,0 +1,9 @@
+#ifndef BLE2902_H
+#define BLE2902_H
+
+#include "BLEDevice.h"
+
+class BLE2902 : public BLEDescriptor {
+};
+
+#endif
@@ -0,0 +1,72 @@
+// BLE stand-ins for sim/bench: the objects exist, no client ever connects.
+
+#ifndef BLE_DEVICE_H
+#define BLE_DEVICE_H
+
+#include "Arduino.h"
+
+class BLEServer;
+class BLECharacteristic;
+
+class BLEServerCallbacks {
+public:
+  virtual ~BLEServerCallbacks() {}
+  virtual void onConnect(BLEServer *server) {}
+  virtual void onDisconnect(BLEServer *server) {}
+};
+
+class BLECharacteristicCallbacks {
+public:
+  virtual ~BLECharacteristicCallbacks() {}
+  virtual void onWrite(BLECharacteristic *characteristic) {}
+};
+
+class BLEDescriptor {
+public:
+  virtual ~BLEDescriptor() {}
+};
+
+class BLECharacteristic {
+public:
+  static const uint32_t PROPERTY_WRITE = 1 << 3;
+  static const uint32_t PROPERTY_NOTIFY = 1 << 4;
+  void addDescriptor(BLEDescriptor *descriptor) {}
+  void setCallbacks(BLECharacteristicCallbacks *callbacks) {}
+  void setValue(const char *value) { this->value = value; }
+  void setValue(const std::string &value) { this->value = value; }
+  std::string getValue() { return value; }
+  void notify() {}
+
+private:
+  std::string value;
+};
+
+class BLEService {
+public:
+  BLECharacteristic *createCharacteristic(const char *uuid, uint32_t properties) { return new BLECharacteristic(); }
+  void start() {}
+};
+
+class BLEAdvertising {
+public:
+  void start() {}
+};
+
+class BLEServer {
+public:
+  void setCallbacks(BLEServerCallbacks *callbacks) {}
+  BLEService *createService(const char *uuid) { return new BLEService(); }
+  BLEAdvertising *getAdvertising() { return &advertising; }
+  void startAdvertising() {}
+
+private:
+  BLEAdvertising advertising;
+};
+
+class BLEDevice {
+public:
+  static void init(const char *name) {}
+  static BLEServer *createServer() { return new BLEServer(); }
+};
+
+#endif
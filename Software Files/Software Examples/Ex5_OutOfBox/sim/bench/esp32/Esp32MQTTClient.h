@@ -0,0 +1,41 @@
+// Stubbed MQTT client for sim/bench. Every event is accepted and counted
+// instead of being sent.
+
+#ifndef ESP32_MQTT_CLIENT_H
+#define ESP32_MQTT_CLIENT_H
+
+#include "AzureIotHub.h"
+#include <stdint.h>
+
+enum EVENT_TYPE { MESSAGE, STATE };
+enum { OPTION_MINI_SOLUTION_NAME };
+
+struct EVENT_INSTANCE {
+  const char *payload;
+  size_t length;
+};
+
+typedef void (*SEND_CONFIRM_CALLBACK)(IOTHUB_CLIENT_CONFIRMATION_RESULT result);
+typedef void (*MESSAGE_CALLBACK)(const char *payLoad, int size);
+typedef void (*DEVICE_TWIN_CALLBACK)(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned char *payLoad, int size);
+typedef int (*DEVICE_METHOD_CALLBACK)(const char *methodName, const unsigned char *payload, int size, unsigned char **response, int *response_size);
+
+bool Esp32MQTTClient_Init(const uint8_t *deviceConnString, bool hasDeviceTwin);
+void Esp32MQTTClient_SetOption(int option, const char *value);
+void Esp32MQTTClient_Check();
+EVENT_INSTANCE *Esp32MQTTClient_Event_Generate(const char *eventString, EVENT_TYPE type);
+void Esp32MQTTClient_Event_AddProp(EVENT_INSTANCE *event, const char *key, const char *value);
+bool Esp32MQTTClient_SendEventInstance(EVENT_INSTANCE *event);
+void Esp32MQTTClient_SetSendConfirmationCallback(SEND_CONFIRM_CALLBACK callback);
+void Esp32MQTTClient_SetMessageCallback(MESSAGE_CALLBACK callback);
+void Esp32MQTTClient_SetDeviceTwinCallback(DEVICE_TWIN_CALLBACK callback);
+void Esp32MQTTClient_SetDeviceMethodCallback(DEVICE_METHOD_CALLBACK callback);
+
+// what was published, for the benchmark
+struct MqttStubStats {
+  uint32_t messages;
+  uint32_t bytes;
+};
+extern MqttStubStats mqttStubStats;
+
+#endif
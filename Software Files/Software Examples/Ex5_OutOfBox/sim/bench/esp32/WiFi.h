@@ -0,0 +1,37 @@
+// WiFi stand-in for sim/bench: begin() connects at once and reports the
+// address through the event handler.
+
+#ifndef WIFI_H
+#define WIFI_H
+
+#include "Arduino.h"
+
+enum WiFiEvent_t {
+  SYSTEM_EVENT_STA_GOT_IP,
+  SYSTEM_EVENT_STA_DISCONNECTED,
+};
+
+enum wl_status_t {
+  WL_IDLE_STATUS,
+  WL_CONNECTED,
+  WL_DISCONNECTED,
+};
+
+typedef void (*WiFiEventCb)(WiFiEvent_t event);
+
+class WiFiClass {
+public:
+  void begin(const char *ssid, const char *password);
+  void disconnect();
+  wl_status_t status() { return state; }
+  void onEvent(WiFiEventCb handler) { this->handler = handler; }
+  IPAddress localIP() { return IPAddress{ { 192, 168, 1, 2 } }; }
+
+private:
+  wl_status_t state = WL_IDLE_STATUS;
+  WiFiEventCb handler = nullptr;
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,178 @@
+#include "Arduino.h"
+#include "WiFi.h"
+#include "Esp32MQTTClient.h"
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+MqttStubStats mqttStubStats;
+
+#define RX_BUFFER_SIZE 1024
+
+static uint8_t rxBuffer[RX_BUFFER_SIZE];
+static size_t rxHead = 0;
+static size_t rxCount = 0;
+static unsigned long clock_us = 0;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Serial
+int HardwareSerial::available()
+{
+  return rxCount;
+}
+
+int HardwareSerial::read()
+{
+  uint8_t c;
+  if (readBytes(&c, 1) == 0) {
+    return -1;
+  }
+  return c;
+}
+
+size_t HardwareSerial::readBytes(uint8_t *buffer, size_t length)
+{
+  size_t n = 0;
+  while (n < length && rxCount > 0) {
+    buffer[n++] = rxBuffer[rxHead];
+    rxHead = (rxHead + 1) % RX_BUFFER_SIZE;
+    rxCount--;
+  }
+  return n;
+}
+
+size_t HardwareSerial::println(const IPAddress &address)
+{
+  return printf("%u.%u.%u.%u\r\n", address.octets[0], address.octets[1], address.octets[2], address.octets[3]);
+}
+
+size_t HardwareSerial::printf(const char *format, ...)
+{
+  char text[600];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0) {
+    return 0;
+  }
+  return write(text, (size_t)length < sizeof(text) ? length : sizeof(text) - 1);
+}
+
+size_t HardwareSerial::write(const char *data, size_t length)
+{
+  written += length;
+  if (echo) {
+    fwrite(data, 1, length, stdout);
+  }
+  return length;
+}
+
+void ArduinoStub_receive(const uint8_t *data, size_t length)
+{
+  for (size_t i = 0; i < length && rxCount < RX_BUFFER_SIZE; i++) {
+    rxBuffer[(rxHead + rxCount++) % RX_BUFFER_SIZE] = data[i];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Time and the rest of the core
+void ArduinoStub_advance(unsigned long us)
+{
+  clock_us += us;
+}
+
+unsigned long millis()
+{
+  return clock_us / 1000;
+}
+
+unsigned long micros()
+{
+  return clock_us;
+}
+
+void randomSeed(unsigned long seed)
+{
+  srand(seed);
+}
+
+int analogRead(uint8_t pin)
+{
+  return 0;
+}
+
+void esp_sleep_enable_timer_wakeup(uint64_t us)
+{
+}
+
+void esp_deep_sleep_start()
+{
+  fprintf(stderr, "bench: the sketch went to deep sleep\n");
+  exit(1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// WiFi
+void WiFiClass::begin(const char *ssid, const char *password)
+{
+  state = WL_CONNECTED;
+  if (handler) {
+    handler(SYSTEM_EVENT_STA_GOT_IP);
+  }
+}
+
+void WiFiClass::disconnect()
+{
+  state = WL_DISCONNECTED;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MQTT client: every event is accepted, one at a time
+static EVENT_INSTANCE event;
+
+bool Esp32MQTTClient_Init(const uint8_t *deviceConnString, bool hasDeviceTwin)
+{
+  return true;
+}
+
+void Esp32MQTTClient_SetOption(int option, const char *value)
+{
+}
+
+void Esp32MQTTClient_Check()
+{
+}
+
+EVENT_INSTANCE *Esp32MQTTClient_Event_Generate(const char *eventString, EVENT_TYPE type)
+{
+  event.payload = eventString;
+  event.length = strlen(eventString);
+  return &event;
+}
+
+void Esp32MQTTClient_Event_AddProp(EVENT_INSTANCE *event, const char *key, const char *value)
+{
+}
+
+bool Esp32MQTTClient_SendEventInstance(EVENT_INSTANCE *event)
+{
+  mqttStubStats.messages++;
+  mqttStubStats.bytes += event->length;
+  return true;
+}
+
+void Esp32MQTTClient_SetSendConfirmationCallback(SEND_CONFIRM_CALLBACK callback)
+{
+}
+
+void Esp32MQTTClient_SetMessageCallback(MESSAGE_CALLBACK callback)
+{
+}
+
+void Esp32MQTTClient_SetDeviceTwinCallback(DEVICE_TWIN_CALLBACK callback)
+{
+}
+
+void Esp32MQTTClient_SetDeviceMethodCallback(DEVICE_METHOD_CALLBACK callback)
+{
+}
@@ -0,0 +1,200 @@
+/*
+ * format_main.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "format/format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Format_fixed test and benchmark, on the host (format/format.c has no
+// driverlib dependency):
+//
+//   exhaustive  every 16 bit input, signed and unsigned (-32768..65535),
+//               with 0..FORMAT_FRACTION_MAX fraction digits, plus the 32
+//               bit limits and every power of ten, against snprintf. Each
+//               case is also formatted into every buffer size from 0 up:
+//               too small gives 0 and an empty string, and nothing is
+//               written past size.
+//   time        host CPU time per call of Format_fixed and of what it
+//               replaced, sprintf("%d") and moving the digits to insert
+//               the point
+//
+// A failed check fails the run. Results are printed as one JSON object
+// per line.
+
+// bytes after the buffer that must stay untouched
+#define FORMAT_GUARD        (8)
+#define FORMAT_GUARD_BYTE   (0xA5)
+
+static uint64_t Format_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// The expected text, with 64 bit arithmetic and snprintf
+static int Format_reference(char text[], int32_t value, uint8_t fraction)
+{
+    int64_t magnitude = value < 0 ? -(int64_t) value : value;
+    int64_t scale = 1;
+    uint8_t i;
+
+    for (i = 0; i < fraction; i++)
+        scale *= 10;
+    if (fraction == 0)
+        return sprintf(text, "%s%lld", value < 0 ? "-" : "",
+                (long long) magnitude);
+    return sprintf(text, "%s%lld.%0*lld", value < 0 ? "-" : "",
+            (long long) (magnitude / scale), fraction,
+            (long long) (magnitude % scale));
+}
+
+static bool Format_check(int32_t value, uint8_t fraction, uint32_t* cases)
+{
+    uint8_t buffer[FORMAT_SIZE + FORMAT_GUARD];
+    char expected[32];
+    uint8_t length, size, i;
+    int n = Format_reference(expected, value, fraction);
+
+    for (size = 0; size <= FORMAT_SIZE; size++) {
+        memset(buffer, FORMAT_GUARD_BYTE, sizeof(buffer));
+        length = Format_fixed(buffer, size, value, fraction);
+        for (i = size; i < sizeof(buffer); i++) {
+            if (buffer[i] != FORMAT_GUARD_BYTE) {
+                fprintf(stderr, "format: %ld, %u digits, size %u: wrote "
+                        "past the buffer\n", (long) value, fraction, size);
+                return false;
+            }
+        }
+        if (n < size ? length != n || strcmp((char*) buffer, expected)
+                : length != 0 || (size > 0 && buffer[0] != '\0')) {
+            fprintf(stderr, "format: %ld, %u digits, size %u: \"%.*s\" (%u),"
+                    " expected \"%s\"\n", (long) value, fraction, size,
+                    size, size > 0 ? (char*) buffer : "", length,
+                    n < size ? expected : "");
+            return false;
+        }
+        (*cases)++;
+    }
+    return true;
+}
+
+static bool Format_exhaustive(void)
+{
+    static const int32_t limits[] = { INT32_MIN, INT32_MIN + 1, -1, 0, 1,
+            INT32_MAX - 1, INT32_MAX };
+    uint32_t cases = 0;
+    int32_t value, power;
+    uint8_t fraction, i;
+
+    for (fraction = 0; fraction <= FORMAT_FRACTION_MAX; fraction++) {
+        for (value = -32768; value <= 65535; value++) {
+            if (!Format_check(value, fraction, &cases))
+                return false;
+        }
+        for (i = 0; i < sizeof(limits) / sizeof(limits[0]); i++) {
+            if (!Format_check(limits[i], fraction, &cases))
+                return false;
+        }
+        // the digit boundaries
+        for (power = 1; power <= 1000000000; power *= 10) {
+            if (!Format_check(power, fraction, &cases)
+                    || !Format_check(power - 1, fraction, &cases)
+                    || !Format_check(-power, fraction, &cases)
+                    || !Format_check(1 - power, fraction, &cases))
+                return false;
+            if (power == 1000000000)
+                break;
+        }
+    }
+    // more fraction digits than supported are cut to FORMAT_FRACTION_MAX
+    {
+        uint8_t a[FORMAT_SIZE], b[FORMAT_SIZE];
+        Format_fixed(a, sizeof(a), -123456789, FORMAT_FRACTION_MAX + 3);
+        Format_fixed(b, sizeof(b), -123456789, FORMAT_FRACTION_MAX);
+        if (strcmp((char*) a, (char*) b)) {
+            fprintf(stderr, "format: %u fraction digits are not cut to %u\n",
+                    FORMAT_FRACTION_MAX + 3, FORMAT_FRACTION_MAX);
+            return false;
+        }
+        cases++;
+    }
+    printf("{\"test\":\"exhaustive\",\"result\":\"pass\",\"cases\":%lu}\n",
+            (unsigned long) cases);
+    return true;
+}
+
+// What the conversions did before Format_fixed: sprintf, then move the
+// last fraction digits up by one to make room for the point
+static uint8_t Format_sprintf(uint8_t buffer[], int32_t value,
+        uint8_t fraction)
+{
+    int length = sprintf((char*) buffer, "%ld", (long) value);
+    int i;
+
+    for (i = length; i > length - fraction; i--)
+        buffer[i] = buffer[i - 1];
+    buffer[length - fraction] = '.';
+    buffer[++length] = '\0';
+    return length;
+}
+
+// Readings as the conversions see them: temperature, humidity and the
+// moisture and light percentages, all in hundredths
+static void Format_time(uint32_t iterations)
+{
+    static const int32_t values[] = { 2531, -705, 4820, 10000, 3150, 99 };
+    static const uint8_t fractions[] = { 2, 2, 2, 2, 2, 2 };
+    const uint8_t count = sizeof(values) / sizeof(values[0]);
+    volatile uint8_t sink = 0;
+    uint8_t buffer[32];
+    uint64_t t, fixed_ns, sprintf_ns;
+    uint32_t i;
+    uint8_t v;
+
+    t = Format_ns();
+    for (i = 0; i < iterations; i++) {
+        for (v = 0; v < count; v++)
+            sink += Format_fixed(buffer, FORMAT_SIZE, values[v], fractions[v]);
+    }
+    fixed_ns = Format_ns() - t;
+    t = Format_ns();
+    for (i = 0; i < iterations; i++) {
+        for (v = 0; v < count; v++)
+            sink += Format_sprintf(buffer, values[v], fractions[v]);
+    }
+    sprintf_ns = Format_ns() - t;
+    (void) sink;
+    printf("{\"test\":\"time\",\"calls\":%lu,\"format_fixed_ns\":%.1f,"
+            "\"sprintf_ns\":%.1f,\"speedup\":%.2f}\n",
+            (unsigned long) iterations * count,
+            (double) fixed_ns / iterations / count,
+            (double) sprintf_ns / iterations / count,
+            (double) sprintf_ns / fixed_ns);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t iterations = 1000000;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "--iterations") && arg + 1 < argc) {
+            iterations = strtoul(argv[++arg], 0, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    if (!Format_exhaustive())
+        return 1;
+    Format_time(iterations);
+    return 0;
+}
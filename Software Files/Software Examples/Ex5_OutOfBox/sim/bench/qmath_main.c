@@ -0,0 +1,271 @@
+/*
+ * qmath_main.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "qmath/qmath.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// qmath test, on the host. Off the MSP430 qmath.c builds its C reference
+// model; this checks that model against MPY32 as the user's guide
+// describes it: fractional mode shifts the product left by one, saturation
+// mode clamps the 32 or 64 bit result, and the Q result is the upper half.
+//
+//   q15_mul   every pair of Q15 operands
+//   q31_mul   the edges crossed with each other, then random pairs
+//   q15_dot   lengths 0, 1 and the maximum, 65535, with -1 * -1 and
+//             -1 * MAX everywhere, then random vectors
+//   q_scale   every 16 bit value for the ratios the firmware uses, then
+//             random ratios; all against floor(value * num / den)
+//
+// A failed check fails the run. Results are printed as one JSON object
+// per test.
+
+// longest Q15_dot, the length is a uint16_t
+#define QMATH_DOT_MAX       (0xFFFF)
+
+static uint64_t qmath_random = 1;
+
+static uint32_t Qmath_random(void)
+{
+    qmath_random = qmath_random * 6364136223846793005ULL
+            + 1442695040888963407ULL;
+    return qmath_random >> 32;
+}
+
+//*****************************************************************************
+// MPY32 in fractional and saturation mode
+//*****************************************************************************
+static q15_t Mpy_q15(q15_t a, q15_t b)
+{
+    int64_t result = (int64_t) a * b * 2;
+
+    if (result > INT32_MAX)
+        result = INT32_MAX;
+    // RES1, the upper word of the 32 bit result
+    return (q15_t) (result >> 16);
+}
+
+static q31_t Mpy_q31(q31_t a, q31_t b)
+{
+    __int128 result = (__int128) a * b * 2;
+
+    if (result > INT64_MAX)
+        result = INT64_MAX;
+    // RES3:RES2, the upper half of the 64 bit result
+    return (q31_t) (result >> 32);
+}
+
+// Sum of the Q30 products in double, exact below 2^53, as Q31
+static q31_t Mpy_dot(const q15_t a[], const q15_t b[], uint16_t length)
+{
+    double sum = 0;
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+        sum += (double) a[i] * b[i];
+    sum *= 2;
+    if (sum >= 2147483648.0)
+        return Q31_MAX;
+    if (sum < -2147483648.0)
+        return Q31_MIN;
+    return (q31_t) sum;
+}
+
+//*****************************************************************************
+// Checks
+//*****************************************************************************
+static bool Qmath_q15Mul(void)
+{
+    int32_t a, b;
+    q15_t expected, result;
+
+    for (a = Q15_MIN; a <= Q15_MAX; a++) {
+        for (b = Q15_MIN; b <= Q15_MAX; b++) {
+            expected = Mpy_q15(a, b);
+            result = Q15_mul(a, b);
+            if (result != expected) {
+                fprintf(stderr, "qmath: Q15_mul(%ld, %ld) = %d, expected %d\n",
+                        (long) a, (long) b, result, expected);
+                return false;
+            }
+        }
+    }
+    if (Q15_mul(Q15_MIN, Q15_MIN) != Q15_MAX) {
+        fprintf(stderr, "qmath: Q15_mul(-1, -1) does not saturate\n");
+        return false;
+    }
+    printf("{\"test\":\"q15_mul\",\"result\":\"pass\",\"cases\":%lu}\n",
+            65536UL * 65536UL);
+    return true;
+}
+
+static bool Qmath_q31Mul(uint32_t count)
+{
+    static const q31_t edges[] = { Q31_MIN, Q31_MIN + 1, -0x40000000, -2, -1,
+            0, 1, 2, 0x40000000, 0x7FFF, 0x8000, 0xFFFF, 0x10000, Q31_MAX - 1,
+            Q31_MAX };
+    const uint8_t edge_count = sizeof(edges) / sizeof(edges[0]);
+    uint32_t cases = 0, n;
+    q31_t a, b;
+    uint8_t i, j;
+
+    for (n = 0; n < (uint32_t) edge_count * edge_count + count; n++) {
+        if (n < (uint32_t) edge_count * edge_count) {
+            i = n / edge_count;
+            j = n % edge_count;
+            a = edges[i];
+            b = edges[j];
+        } else {
+            a = (q31_t) Qmath_random();
+            b = (q31_t) Qmath_random();
+        }
+        if (Q31_mul(a, b) != Mpy_q31(a, b)) {
+            fprintf(stderr, "qmath: Q31_mul(%ld, %ld) = %ld, expected %ld\n",
+                    (long) a, (long) b, (long) Q31_mul(a, b),
+                    (long) Mpy_q31(a, b));
+            return false;
+        }
+        cases++;
+    }
+    if (Q31_mul(Q31_MIN, Q31_MIN) != Q31_MAX) {
+        fprintf(stderr, "qmath: Q31_mul(-1, -1) does not saturate\n");
+        return false;
+    }
+    printf("{\"test\":\"q31_mul\",\"result\":\"pass\",\"cases\":%lu}\n",
+            (unsigned long) cases);
+    return true;
+}
+
+static bool Qmath_dotCase(const q15_t a[], const q15_t b[], uint16_t length,
+        const char* what)
+{
+    q31_t result = Q15_dot(a, b, length);
+    q31_t expected = Mpy_dot(a, b, length);
+
+    if (result != expected) {
+        fprintf(stderr, "qmath: Q15_dot, %s, length %u: %ld, expected %ld\n",
+                what, length, (long) result, (long) expected);
+        return false;
+    }
+    return true;
+}
+
+static bool Qmath_q15Dot(uint32_t count)
+{
+    static q15_t a[QMATH_DOT_MAX], b[QMATH_DOT_MAX];
+    uint32_t cases = 0, n, i;
+    uint16_t length;
+
+    // -1 * -1 is +1: one product already saturates, so do all of them
+    for (i = 0; i < QMATH_DOT_MAX; i++) {
+        a[i] = Q15_MIN;
+        b[i] = Q15_MIN;
+    }
+    if (!Qmath_dotCase(a, b, 0, "empty") || Q15_dot(a, b, 0) != 0
+            || !Qmath_dotCase(a, b, 1, "-1 * -1")
+            || Q15_dot(a, b, 1) != Q31_MAX
+            || !Qmath_dotCase(a, b, QMATH_DOT_MAX, "-1 * -1")
+            || Q15_dot(a, b, QMATH_DOT_MAX) != Q31_MAX)
+        return false;
+    // and the most negative sum
+    for (i = 0; i < QMATH_DOT_MAX; i++)
+        b[i] = Q15_MAX;
+    if (!Qmath_dotCase(a, b, QMATH_DOT_MAX, "-1 * MAX")
+            || Q15_dot(a, b, QMATH_DOT_MAX) != Q31_MIN)
+        return false;
+    cases += 4;
+
+    // random vectors: long ones saturate, short ones mostly do not
+    for (n = 0; n < count; n++) {
+        length = n % 4 == 0 ? QMATH_DOT_MAX : Qmath_random() % 64;
+        for (i = 0; i < length; i++) {
+            a[i] = (q15_t) Qmath_random();
+            b[i] = (q15_t) (n % 2 ? Qmath_random() >> 20 : Qmath_random());
+        }
+        if (!Qmath_dotCase(a, b, length, "random"))
+            return false;
+        cases++;
+    }
+    printf("{\"test\":\"q15_dot\",\"result\":\"pass\",\"cases\":%lu}\n",
+            (unsigned long) cases);
+    return true;
+}
+
+static bool Qmath_scaleRatio(uint32_t num, uint32_t den, uint32_t* cases)
+{
+    uint32_t ratio = Q_RATIO(num, den);
+    uint32_t value;
+    uint16_t result, expected;
+
+    for (value = 0; value <= 0xFFFF; value++) {
+        result = Q_scale(value, ratio);
+        expected = (uint64_t) value * num / den;
+        if (result != expected) {
+            fprintf(stderr, "qmath: Q_scale(%lu, %lu / %lu) = %u, "
+                    "expected %u\n", (unsigned long) value,
+                    (unsigned long) num, (unsigned long) den, result,
+                    expected);
+            return false;
+        }
+    }
+    *cases += 0x10000;
+    return true;
+}
+
+static bool Qmath_qScale(uint32_t count)
+{
+    // SHT35 temperature and humidity, ADC soil moisture and light
+    static const uint32_t used[][2] = { { 31500, 65535 }, { 10000, 65535 },
+            { 10000, 1100 << 4 }, { 10000, 3000 << 4 } };
+    uint32_t cases = 0, n, num, den;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(used) / sizeof(used[0]); i++) {
+        if (!Qmath_scaleRatio(used[i][0], used[i][1], &cases))
+            return false;
+    }
+    // num < den <= 65536, and the edges of that range
+    if (!Qmath_scaleRatio(0, 65536, &cases)
+            || !Qmath_scaleRatio(1, 65536, &cases)
+            || !Qmath_scaleRatio(65535, 65536, &cases)
+            || !Qmath_scaleRatio(1, 2, &cases)
+            || !Qmath_scaleRatio(65534, 65535, &cases))
+        return false;
+    for (n = 0; n < count; n++) {
+        den = Qmath_random() % 65536 + 1;
+        if (den == 1)
+            continue;
+        num = Qmath_random() % den;
+        if (!Qmath_scaleRatio(num, den, &cases))
+            return false;
+    }
+    printf("{\"test\":\"q_scale\",\"result\":\"pass\",\"cases\":%lu}\n",
+            (unsigned long) cases);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t count = 1000;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "--random") && arg + 1 < argc) {
+            count = strtoul(argv[++arg], 0, 10);
+        } else if (!strcmp(argv[arg], "--seed") && arg + 1 < argc) {
+            qmath_random = strtoul(argv[++arg], 0, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--random N] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!Qmath_q15Mul() || !Qmath_q31Mul(count * 10000)
+            || !Qmath_q15Dot(count) || !Qmath_qScale(count))
+        return 1;
+    return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * ringbuffer_main.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "uart/ringbuffer.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+// Ring buffer test and benchmark, on the host (uart/ringbuffer.c has no
+// driverlib dependency):
+//
+//   empty, full   get on an empty ring and put on a full one fail and
+//                 leave it unchanged, count and space add up
+//   wrap          bytes come out in order while the masked indexes and
+//                 the free running 16 bit ones wrap
+//   interleave    a timer signal stands in for the UART ISR and preempts
+//                 main at any instruction: main puts and the handler gets
+//                 (the TX path), then the other way round. Every byte has
+//                 to arrive once and in order.
+//   put_get       host CPU time per byte through the ring
+//
+// A failed check fails the run. Results are printed as one JSON object
+// per line and test.
+
+// interval of the timer signal
+#define RING_TICK_US        (20)
+
+static RingBuffer ring;
+
+static uint64_t Ring_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static bool Ring_fail(const char* test, const char* what)
+{
+    fprintf(stderr, "ringbuffer: %s: %s\n", test, what);
+    return false;
+}
+
+//*****************************************************************************
+// Single threaded checks
+//*****************************************************************************
+static bool Ring_empty(void)
+{
+    uint8_t byte = 0xA5;
+
+    RingBuffer_init(&ring);
+    if (RingBuffer_count(&ring) != 0
+            || RingBuffer_space(&ring) != RINGBUFFER_SIZE)
+        return Ring_fail("empty", "a new ring is not empty");
+    if (RingBuffer_get(&ring, &byte) || byte != 0xA5)
+        return Ring_fail("empty", "get on an empty ring");
+    if (!RingBuffer_put(&ring, 1) || !RingBuffer_get(&ring, &byte)
+            || byte != 1 || RingBuffer_get(&ring, &byte))
+        return Ring_fail("empty", "get after the last byte");
+    printf("{\"test\":\"empty\",\"result\":\"pass\"}\n");
+    return true;
+}
+
+static bool Ring_full(void)
+{
+    uint8_t byte;
+    uint16_t i;
+
+    RingBuffer_init(&ring);
+    for (i = 0; i < RINGBUFFER_SIZE; i++) {
+        if (RingBuffer_count(&ring) + RingBuffer_space(&ring)
+                != RINGBUFFER_SIZE || !RingBuffer_put(&ring, i))
+            return Ring_fail("full", "put below the size");
+    }
+    if (RingBuffer_space(&ring) != 0 || RingBuffer_put(&ring, 0xFF)
+            || RingBuffer_count(&ring) != RINGBUFFER_SIZE)
+        return Ring_fail("full", "put on a full ring");
+    // one byte out makes room for exactly one
+    if (!RingBuffer_get(&ring, &byte) || byte != 0
+            || !RingBuffer_put(&ring, 0xFF) || RingBuffer_put(&ring, 0xFF))
+        return Ring_fail("full", "put after a get");
+    for (i = 1; i <= RINGBUFFER_SIZE; i++) {
+        if (!RingBuffer_get(&ring, &byte)
+                || byte != (i < RINGBUFFER_SIZE ? i : 0xFF))
+            return Ring_fail("full", "bytes out of a full ring");
+    }
+    printf("{\"test\":\"full\",\"result\":\"pass\"}\n");
+    return true;
+}
+
+// Starts the free running indexes at start and moves bytes through the
+// ring in bursts of 7..RINGBUFFER_SIZE + 6 until both have passed 0xFFFF
+static bool Ring_wrapFrom(uint16_t start, uint32_t* moved)
+{
+    uint8_t next_in = 0, next_out = 0, byte;
+    uint32_t total = 0;
+    uint16_t burst = 1, i;
+
+    RingBuffer_init(&ring);
+    ring.head = start;
+    ring.tail = start;
+    while (total < 0x10000UL + 3 * RINGBUFFER_SIZE) {
+        for (i = 0; i < burst && RingBuffer_put(&ring, next_in); i++)
+            next_in++;
+        if (RingBuffer_count(&ring) != (uint8_t) (next_in - next_out))
+            return Ring_fail("wrap", "count does not match");
+        while (RingBuffer_get(&ring, &byte)) {
+            if (byte != next_out++)
+                return Ring_fail("wrap", "byte out of order");
+            total++;
+        }
+        burst = burst % RINGBUFFER_SIZE + 7;
+    }
+    *moved += total;
+    return true;
+}
+
+static bool Ring_wrap(void)
+{
+    uint32_t moved = 0;
+
+    if (!Ring_wrapFrom(0, &moved)
+            || !Ring_wrapFrom(0xFFFF - RINGBUFFER_SIZE / 2, &moved)
+            || !Ring_wrapFrom(0xFFFF, &moved))
+        return false;
+    printf("{\"test\":\"wrap\",\"result\":\"pass\",\"bytes\":%lu}\n",
+            (unsigned long) moved);
+    return true;
+}
+
+//*****************************************************************************
+// Main against a signal handler, as main against an ISR on the MSP430
+//*****************************************************************************
+static volatile sig_atomic_t isr_produces;
+static volatile sig_atomic_t isr_failed;
+static volatile uint32_t isr_calls;
+static volatile uint32_t isr_bytes;
+static uint8_t isr_next;
+static uint32_t isr_random = 1;
+
+static void Ring_isr(int signal)
+{
+    uint16_t burst, i;
+    uint8_t byte;
+
+    (void) signal;
+    isr_calls++;
+    isr_random = isr_random * 1103515245 + 12345;
+    burst = (isr_random >> 16) % (RINGBUFFER_SIZE + RINGBUFFER_SIZE / 2);
+    for (i = 0; i < burst; i++) {
+        if (isr_produces) {
+            if (!RingBuffer_put(&ring, isr_next))
+                break;
+        } else {
+            if (!RingBuffer_get(&ring, &byte))
+                break;
+            if (byte != isr_next)
+                isr_failed = 1;
+        }
+        isr_next++;
+        isr_bytes++;
+    }
+}
+
+static void Ring_timer(long us)
+{
+    struct itimerval timer;
+
+    memset(&timer, 0, sizeof(timer));
+    timer.it_interval.tv_usec = us;
+    timer.it_value.tv_usec = us;
+    setitimer(ITIMER_REAL, &timer, 0);
+}
+
+static bool Ring_interleave(bool produces, uint32_t bytes)
+{
+    const char* name = produces ? "isr_put_main_get" : "main_put_isr_get";
+    struct sigaction action;
+    uint8_t next = 0, byte;
+    uint32_t done = 0;
+    uint32_t misses = 0;
+
+    RingBuffer_init(&ring);
+    isr_produces = produces;
+    isr_failed = 0;
+    isr_calls = 0;
+    isr_bytes = 0;
+    isr_next = 0;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = Ring_isr;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, 0);
+    Ring_timer(RING_TICK_US);
+
+    while (done < bytes && !isr_failed) {
+        if (produces) {
+            if (!RingBuffer_get(&ring, &byte)) {
+                misses++;
+                continue;
+            }
+            if (byte != next)
+                break;
+        } else if (!RingBuffer_put(&ring, next)) {
+            misses++;
+            continue;
+        }
+        next++;
+        done++;
+    }
+    Ring_timer(0);
+    signal(SIGALRM, SIG_DFL);
+
+    if (isr_failed || done < bytes)
+        return Ring_fail(name, "byte out of order");
+    // what main put and the handler did not take yet is still there
+    if (!produces && isr_bytes + RingBuffer_count(&ring) != done)
+        return Ring_fail(name, "bytes lost");
+    printf("{\"test\":\"interleave\",\"mode\":\"%s\",\"result\":\"pass\","
+            "\"bytes\":%lu,\"interrupts\":%lu,\"main_retries\":%lu}\n", name,
+            (unsigned long) done, (unsigned long) isr_calls,
+            (unsigned long) misses);
+    return true;
+}
+
+//*****************************************************************************
+// Benchmark
+//*****************************************************************************
+// Fills the ring to fill bytes and drains it again, iterations times
+static void Ring_putGet(uint16_t fill, uint32_t iterations)
+{
+    volatile uint8_t sink;
+    uint64_t put_ns = 0, get_ns = 0, t;
+    uint32_t i;
+    uint16_t j;
+    uint8_t byte;
+
+    RingBuffer_init(&ring);
+    for (i = 0; i < iterations; i++) {
+        t = Ring_ns();
+        for (j = 0; j < fill; j++)
+            RingBuffer_put(&ring, j);
+        put_ns += Ring_ns() - t;
+        t = Ring_ns();
+        for (j = 0; j < fill; j++) {
+            RingBuffer_get(&ring, &byte);
+            sink = byte;
+        }
+        get_ns += Ring_ns() - t;
+    }
+    (void) sink;
+    printf("{\"test\":\"put_get\",\"fill\":%u,\"put_ns_per_byte\":%.2f,"
+            "\"get_ns_per_byte\":%.2f}\n", fill,
+            (double) put_ns / iterations / fill,
+            (double) get_ns / iterations / fill);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t iterations = 100000;
+    uint32_t bytes = 2000000;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "--iterations") && arg + 1 < argc) {
+            iterations = strtoul(argv[++arg], 0, 10);
+        } else if (!strcmp(argv[arg], "--bytes") && arg + 1 < argc) {
+            bytes = strtoul(argv[++arg], 0, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--bytes N]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    if (!Ring_empty() || !Ring_full() || !Ring_wrap()
+            || !Ring_interleave(false, bytes) || !Ring_interleave(true, bytes))
+        return 1;
+    // one telemetry line, a full ring
+    Ring_putGet(40, iterations);
+    Ring_putGet(RINGBUFFER_SIZE, iterations);
+    return 0;
+}
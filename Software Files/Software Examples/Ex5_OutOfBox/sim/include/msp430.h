@@ -0,0 +1,701 @@
+/*
+ * msp430.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef SIM_MSP430_H_
+#define SIM_MSP430_H_
+
+// Stand-in for the MSP430FR5994 device header in the host build. Only the
+// modules the firmware and its driverlib files use are here, with the
+// addresses and bit values of the real part. Registers are reached through
+// HWREG8/16 (sim_memmap.h), so every access ends up in the simulator.
+
+#define __MSP430FR5994__
+
+//*****************************************************************************
+// Modules
+//*****************************************************************************
+#define __MSP430_HAS_SFR__
+#define __MSP430_HAS_PMM_FRAM__
+#define __MSP430_HAS_FRAM__
+#define __MSP430_HAS_CRC__
+#define __MSP430_HAS_WDT_A__
+#define __MSP430_HAS_CS__
+#define __MSP430_HAS_PORT1_R__
+#define __MSP430_HAS_PORT2_R__
+#define __MSP430_HAS_PORT3_R__
+#define __MSP430_HAS_PORT4_R__
+#define __MSP430_HAS_PORT5_R__
+#define __MSP430_HAS_PORT6_R__
+#define __MSP430_HAS_PORT7_R__
+#define __MSP430_HAS_PORT8_R__
+#define __MSP430_HAS_PORTA_R__
+#define __MSP430_HAS_PORTJ_R__
+#define __MSP430_HAS_TxA7__
+#define __MSP430_HAS_TxB7__
+#define __MSP430_HAS_RTC_C__
+#define __MSP430_HAS_DMAX_6__
+#define __MSP430_HAS_EUSCI_Ax__
+#define __MSP430_HAS_EUSCI_Bx__
+#define __MSP430_HAS_ADC12_B__
+#define __MSP430_HAS_CRC32__
+#define __MSP430_HAS_AES256__
+
+#define SFR_BASE                            (0x0100)
+#define PMM_BASE                            (0x0120)
+#define FRAM_BASE                           (0x0140)
+#define CRC_BASE                            (0x0150)
+#define WDT_A_BASE                          (0x0150)
+#define CS_BASE                             (0x0160)
+#define __MSP430_BASEADDRESS_PORT1_R__      (0x0200)
+#define __MSP430_BASEADDRESS_PORT2_R__      (0x0200)
+#define __MSP430_BASEADDRESS_PORT3_R__      (0x0220)
+#define __MSP430_BASEADDRESS_PORT4_R__      (0x0220)
+#define __MSP430_BASEADDRESS_PORT5_R__      (0x0240)
+#define __MSP430_BASEADDRESS_PORT6_R__      (0x0240)
+#define __MSP430_BASEADDRESS_PORT7_R__      (0x0260)
+#define __MSP430_BASEADDRESS_PORT8_R__      (0x0260)
+#define __MSP430_BASEADDRESS_PORTA_R__      (0x0200)
+#define __MSP430_BASEADDRESS_PORTJ_R__      (0x0320)
+#define TIMER_A0_BASE                       (0x0340)
+#define TIMER_B0_BASE                       (0x03C0)
+#define RTC_C_BASE                          (0x04A0)
+#define MPY32_BASE                          (0x04C0)
+#define DMA_BASE                            (0x0500)
+#define EUSCI_A0_BASE                       (0x05C0)
+#define EUSCI_A3_BASE                       (0x0620)
+#define EUSCI_B2_BASE                       (0x06C0)
+#define ADC12_B_BASE                        (0x0800)
+#define CRC32_BASE                          (0x0980)
+#define AES256_BASE                         (0x09C0)
+
+//*****************************************************************************
+// Status register, low power modes
+//*****************************************************************************
+#define C                       (0x0001)
+#define Z                       (0x0002)
+#define N                       (0x0004)
+#define V                       (0x0100)
+#define GIE                     (0x0008)
+#define CPUOFF                  (0x0010)
+#define OSCOFF                  (0x0020)
+#define SCG0                    (0x0040)
+#define SCG1                    (0x0080)
+
+#define LPM0_bits               (CPUOFF)
+#define LPM1_bits               (SCG0 + CPUOFF)
+#define LPM2_bits               (SCG1 + CPUOFF)
+#define LPM3_bits               (SCG1 + SCG0 + CPUOFF)
+#define LPM4_bits               (SCG1 + SCG0 + OSCOFF + CPUOFF)
+
+//*****************************************************************************
+// SFR
+//*****************************************************************************
+#define OFS_SFRIE1              (0x0000)
+#define OFS_SFRIE1_L            OFS_SFRIE1
+#define OFS_SFRIFG1             (0x0002)
+#define OFS_SFRIFG1_L           OFS_SFRIFG1
+#define OFS_SFRRPCR             (0x0004)
+#define OFS_SFRRPCR_L           OFS_SFRRPCR
+
+#define OFIFG                   (0x0002)
+#define SYSNMI                  (0x0001)
+#define SYSNMIIES               (0x0002)
+#define SYSRSTUP                (0x0004)
+#define SYSRSTRE                (0x0008)
+
+//*****************************************************************************
+// PMM
+//*****************************************************************************
+#define OFS_PMMCTL0             (0x0000)
+#define OFS_PMMCTL0_L           OFS_PMMCTL0
+#define OFS_PMMCTL0_H           OFS_PMMCTL0+1
+#define OFS_PMMIFG              (0x000A)
+#define OFS_PM5CTL0             (0x0010)
+
+#define PMMPW                   (0xA500)
+#define PMMPW_H                 (0xA5)
+#define PMMSWBOR                (0x0004)
+#define PMMSWPOR                (0x0008)
+#define PMMREGOFF               (0x0010)
+#define SVSHE                   (0x0040)
+#define LOCKLPM5                (0x0001)
+
+//*****************************************************************************
+// FRAM controller
+//*****************************************************************************
+#define OFS_FRCTL0              (0x0000)
+#define OFS_FRCTL0_L            OFS_FRCTL0
+#define OFS_GCCTL0              (0x0004)
+#define OFS_GCCTL1              (0x0006)
+
+#define FRCTLPW                 (0xA500)
+#define FWPW                    (0xA500)
+#define NWAITS_7                (0x0070)
+
+//*****************************************************************************
+// CRC16
+//*****************************************************************************
+#define OFS_CRCDI               (0x0000)
+#define OFS_CRCDI_L             OFS_CRCDI
+#define OFS_CRCDIRB             (0x0002)
+#define OFS_CRCDIRB_L           OFS_CRCDIRB
+#define OFS_CRCINIRES           (0x0004)
+#define OFS_CRCRESR             (0x0006)
+
+//*****************************************************************************
+// WDT_A
+//*****************************************************************************
+#define OFS_WDTCTL              (0x000C)
+
+#define WDTPW                   (0x5A00)
+#define WDTHOLD                 (0x0080)
+#define WDTTMSEL                (0x0010)
+#define WDTCNTCL                (0x0008)
+
+//*****************************************************************************
+// CS
+//*****************************************************************************
+#define OFS_CSCTL0              (0x0000)
+#define OFS_CSCTL0_H            OFS_CSCTL0+1
+#define OFS_CSCTL1              (0x0002)
+#define OFS_CSCTL2              (0x0004)
+#define OFS_CSCTL3              (0x0006)
+#define OFS_CSCTL4              (0x0008)
+#define OFS_CSCTL4_L            OFS_CSCTL4
+#define OFS_CSCTL5              (0x000A)
+#define OFS_CSCTL6              (0x000C)
+
+#define CSKEY                   (0xA500)
+#define CSKEY_H                 (0xA5)
+
+#define DCORSEL                 (0x0040)
+#define DCOFSEL_0               (0x0000)
+#define DCOFSEL_1               (0x0002)
+#define DCOFSEL_2               (0x0004)
+#define DCOFSEL_3               (0x0006)
+#define DCOFSEL_4               (0x0008)
+#define DCOFSEL_5               (0x000A)
+#define DCOFSEL_6               (0x000C)
+#define DCOFSEL_7               (0x000E)
+
+#define SELM_7                  (0x0007)
+#define SELM__LFXTCLK           (0x0000)
+#define SELM__VLOCLK            (0x0001)
+#define SELM__LFMODOSC          (0x0002)
+#define SELM__DCOCLK            (0x0003)
+#define SELM__MODOSC            (0x0004)
+#define SELM__HFXTCLK           (0x0005)
+#define SELS_7                  (0x0070)
+#define SELA_7                  (0x0700)
+
+#define DIVM0                   (0x0001)
+#define DIVM1                   (0x0002)
+#define DIVM2                   (0x0004)
+#define DIVM__1                 (0x0000)
+#define DIVS0                   (0x0010)
+#define DIVS1                   (0x0020)
+#define DIVS2                   (0x0040)
+#define DIVA0                   (0x0100)
+#define DIVA1                   (0x0200)
+#define DIVA2                   (0x0400)
+
+#define LFXTOFF                 (0x0001)
+#define SMCLKOFF                (0x0002)
+#define VLOOFF                  (0x0008)
+#define LFXTBYPASS              (0x0010)
+#define LFXTDRIVE_0             (0x0000)
+#define LFXTDRIVE_3             (0x00C0)
+#define LFXTDRIVE0_L            (0x0040)
+#define LFXTDRIVE1_L            (0x0080)
+#define HFXTOFF                 (0x0100)
+#define HFFREQ_1                (0x0400)
+#define HFFREQ_2                (0x0800)
+#define HFFREQ_3                (0x0C00)
+#define HFXTBYPASS              (0x1000)
+#define HFXTDRIVE_3             (0xC000)
+
+#define LFXTOFFG                (0x0001)
+#define HFXTOFFG                (0x0002)
+
+//*****************************************************************************
+// Digital I/O, port A (P1/P2) layout, odd ports in the low byte
+//*****************************************************************************
+#define OFS_PAIN                (0x0000)
+#define OFS_PAOUT               (0x0002)
+#define OFS_PADIR               (0x0004)
+#define OFS_PAREN               (0x0006)
+#define OFS_PASEL0              (0x000A)
+#define OFS_PASEL1              (0x000C)
+#define OFS_PASELC              (0x0016)
+#define OFS_PAIES               (0x0018)
+#define OFS_PAIE                (0x001A)
+#define OFS_PAIFG               (0x001C)
+#define OFS_PAIFG_H             OFS_PAIFG+1
+
+#define P8IN                    HWREG8(__MSP430_BASEADDRESS_PORT8_R__ + OFS_PAIN + 1)
+#define P8OUT                   HWREG8(__MSP430_BASEADDRESS_PORT8_R__ + OFS_PAOUT + 1)
+#define P8DIR                   HWREG8(__MSP430_BASEADDRESS_PORT8_R__ + OFS_PADIR + 1)
+#define P8SEL0                  HWREG8(__MSP430_BASEADDRESS_PORT8_R__ + OFS_PASEL0 + 1)
+#define P8SEL1                  HWREG8(__MSP430_BASEADDRESS_PORT8_R__ + OFS_PASEL1 + 1)
+#define PM5CTL0                 HWREG16(PMM_BASE + OFS_PM5CTL0)
+
+//*****************************************************************************
+// Timer_A / Timer_B
+//*****************************************************************************
+#define OFS_TAxCTL              (0x0000)
+#define OFS_TAxCCTL0            (0x0002)
+#define OFS_TAxR                (0x0010)
+#define OFS_TAxCCR0             (0x0012)
+#define OFS_TAxEX0              (0x0020)
+#define OFS_TAxIV               (0x002E)
+#define OFS_TBxCTL              OFS_TAxCTL
+#define OFS_TBxCCTL0            OFS_TAxCCTL0
+#define OFS_TBxR                OFS_TAxR
+#define OFS_TBxCCR0             OFS_TAxCCR0
+#define OFS_TBxEX0              OFS_TAxEX0
+#define OFS_TBxIV               OFS_TAxIV
+
+#define TAIFG                   (0x0001)
+#define TAIE                    (0x0002)
+#define TACLR                   (0x0004)
+#define MC_0                    (0x0000)
+#define MC_1                    (0x0010)
+#define MC_2                    (0x0020)
+#define MC_3                    (0x0030)
+#define MC__STOP                MC_0
+#define MC__UP                  MC_1
+#define MC__CONTINUOUS          MC_2
+#define MC__UPDOWN              MC_3
+#define ID__1                   (0x0000)
+#define ID__2                   (0x0040)
+#define ID__4                   (0x0080)
+#define ID__8                   (0x00C0)
+#define TASSEL__TACLK           (0x0000)
+#define TASSEL__ACLK            (0x0100)
+#define TASSEL__SMCLK           (0x0200)
+#define TASSEL__INCLK           (0x0300)
+#define TAIDEX_7                (0x0007)
+
+#define TBIFG                   TAIFG
+#define TBIE                    TAIE
+#define TBCLR                   TACLR
+#define TBSSEL__TBCLK           TASSEL__TACLK
+#define TBSSEL__ACLK            TASSEL__ACLK
+#define TBSSEL__SMCLK           TASSEL__SMCLK
+#define TBSSEL__INCLK           TASSEL__INCLK
+#define CNTL_3                  (0x1800)
+#define TBCLGRP_3               (0x6000)
+#define TBIDEX_7                TAIDEX_7
+
+#define CCIFG                   (0x0001)
+#define COV                     (0x0002)
+#define OUT                     (0x0004)
+#define CCI                     (0x0008)
+#define CCIE                    (0x0010)
+#define OUTMOD_0                (0x0000)
+#define OUTMOD_7                (0x00E0)
+#define CAP                     (0x0100)
+#define CLLD_3                  (0x0600)
+#define SCS                     (0x0800)
+#define CCIS_3                  (0x3000)
+#define CM_3                    (0xC000)
+
+#define TAIV__NONE              (0x0000)
+#define TAIV__TACCR1            (0x0002)
+#define TAIV__TACCR2            (0x0004)
+#define TAIV__TAIFG             (0x000E)
+#define TBIV__TBIFG             TAIV__TAIFG
+
+#define TA0IV                   HWREG16(TIMER_A0_BASE + OFS_TAxIV)
+#define TB0CTL                  HWREG16(TIMER_B0_BASE + OFS_TBxCTL)
+#define TB0R                    HWREG16(TIMER_B0_BASE + OFS_TBxR)
+#define TB0IV                   HWREG16(TIMER_B0_BASE + OFS_TBxIV)
+
+//*****************************************************************************
+// RTC_C, counter mode uses RTCTIM0/1 as RTCCNT1..4
+//*****************************************************************************
+#define OFS_RTCCTL0_L           (0x0000)
+#define OFS_RTCCTL0_H           (0x0001)
+#define OFS_RTCCTL13            (0x0002)
+#define OFS_RTCCTL13_L          OFS_RTCCTL13
+#define OFS_RTCOCAL             (0x0004)
+#define OFS_RTCTCMP             (0x0006)
+#define OFS_RTCTCMP_H           OFS_RTCTCMP+1
+#define OFS_RTCPS0CTL           (0x0008)
+#define OFS_RTCPS0CTL_L         OFS_RTCPS0CTL
+#define OFS_RTCPS0CTL_H         OFS_RTCPS0CTL+1
+#define OFS_RTCPS1CTL           (0x000A)
+#define OFS_RTCPS1CTL_L         OFS_RTCPS1CTL
+#define OFS_RTCPS_L             (0x000C)
+#define OFS_RTCPS_H             (0x000D)
+#define OFS_RTCIV               (0x000E)
+#define OFS_RTCTIM0             (0x0010)
+#define OFS_RTCTIM0_L           OFS_RTCTIM0
+#define OFS_RTCTIM0_H           OFS_RTCTIM0+1
+#define OFS_RTCTIM1             (0x0012)
+#define OFS_RTCTIM1_L           OFS_RTCTIM1
+#define OFS_RTCTIM1_H           OFS_RTCTIM1+1
+#define OFS_RTCDATE_L           (0x0014)
+#define OFS_RTCDATE_H           (0x0015)
+#define OFS_RTCYEAR             (0x0016)
+#define OFS_RTCAMINHR_L         (0x0018)
+#define OFS_RTCAMINHR_H         (0x0019)
+#define OFS_RTCADOWDAY_L        (0x001A)
+#define OFS_RTCADOWDAY_H        (0x001B)
+#define OFS_BIN2BCD             (0x001C)
+#define OFS_BCD2BIN             (0x001E)
+
+#define RTCKEY_H                (0xA5)
+#define RTCRDYIFG               (0x0001)
+#define RTCAIFG                 (0x0002)
+#define RTCTEVIFG               (0x0004)
+#define RTCOFIFG                (0x0008)
+#define RTCRDYIE                (0x0010)
+#define RTCAIE                  (0x0020)
+#define RTCTEVIE                (0x0040)
+#define RTCOFIE                 (0x0080)
+#define RTCTEV_0                (0x0000)
+#define RTCTEV_1                (0x0001)
+#define RTCTEV_2                (0x0002)
+#define RTCTEV_3                (0x0003)
+#define RTCSSEL_2               (0x0008)
+#define RTCSSEL_3               (0x000C)
+#define RTCRDY                  (0x0010)
+#define RTCMODE                 (0x0020)
+#define RTCHOLD                 (0x0040)
+#define RTCBCD                  (0x0080)
+#define RTCCALF_3               (0x0300)
+#define RTCTCRDY_H              (0x40)
+#define RTCTCOK_H               (0x20)
+
+#define RT0PSIFG                (0x0001)
+#define RT0PSIE                 (0x0002)
+#define RT0IP_7                 (0x001C)
+#define RT0PSHOLD_H             (0x01)
+#define RT0PSDIV_6              (0x3000)
+#define RT0PSDIV_7              (0x3800)
+#define RT1PSIFG                (0x0001)
+#define RT1PSIE                 (0x0002)
+#define RT1PSHOLD               (0x0100)
+#define RT1SSEL_0               (0x0000)
+#define RT1SSEL_2               (0x8000)
+
+//*****************************************************************************
+// MPY32 (unused on the host, qmath takes its reference path)
+//*****************************************************************************
+#define OFS_MPY                 (0x0000)
+#define OFS_OP2                 (0x0008)
+#define OFS_RES0                (0x000A)
+#define OFS_RES1                (0x000C)
+#define OFS_RES2                (0x000E)
+#define OFS_RES3                (0x0010)
+#define OFS_MPY32L              (0x0010)
+
+//*****************************************************************************
+// DMA
+//*****************************************************************************
+#define OFS_DMACTL0             (0x0000)
+#define OFS_DMACTL1             (0x0002)
+#define OFS_DMACTL2             (0x0004)
+#define OFS_DMACTL4             (0x0008)
+#define OFS_DMAIV               (0x000E)
+#define OFS_DMA0CTL             (0x0010)
+#define OFS_DMA0SA              (0x0012)
+#define OFS_DMA0DA              (0x0016)
+#define OFS_DMA0SZ              (0x001A)
+
+#define ENNMI                   (0x0001)
+#define ROUNDROBIN              (0x0002)
+#define DMARMWDIS               (0x0004)
+
+#define DMAREQ                  (0x0001)
+#define DMAABORT                (0x0002)
+#define DMAIE                   (0x0004)
+#define DMAIFG                  (0x0008)
+#define DMAEN                   (0x0010)
+#define DMALEVEL                (0x0020)
+#define DMASRCBYTE              (0x0040)
+#define DMADSTBYTE              (0x0080)
+#define DMASRCINCR_0            (0x0000)
+#define DMASRCINCR_3            (0x0300)
+#define DMADSTINCR_3            (0x0C00)
+#define DMADT_0                 (0x0000)
+#define DMADT_1                 (0x1000)
+#define DMADT_7                 (0x7000)
+
+#define DMAIV                   HWREG16(DMA_BASE + OFS_DMAIV)
+
+//*****************************************************************************
+// eUSCI_A, UART mode
+//*****************************************************************************
+#define OFS_UCAxCTLW0           (0x0000)
+#define OFS_UCAxCTLW1           (0x0002)
+#define OFS_UCAxBRW             (0x0006)
+#define OFS_UCAxMCTLW           (0x0008)
+#define OFS_UCAxSTATW           (0x000A)
+#define OFS_UCAxRXBUF           (0x000C)
+#define OFS_UCAxTXBUF           (0x000E)
+#define OFS_UCAxABCTL           (0x0010)
+#define OFS_UCAxIRCTL           (0x0012)
+#define OFS_UCAxIE              (0x001A)
+#define OFS_UCAxIFG             (0x001C)
+#define OFS_UCAxIV              (0x001E)
+
+#define UCSWRST                 (0x0001)
+#define UCTXBRK                 (0x0002)
+#define UCTXADDR                (0x0004)
+#define UCDORM                  (0x0008)
+#define UCBRKIE                 (0x0010)
+#define UCRXEIE                 (0x0020)
+#define UCSSEL_3                (0x00C0)
+#define UCSSEL__UCLK            (0x0000)
+#define UCSSEL__ACLK            (0x0040)
+#define UCSSEL__SMCLK           (0x0080)
+#define UCSYNC                  (0x0100)
+#define UCMODE_0                (0x0000)
+#define UCMODE_3                (0x0600)
+#define UCSPB                   (0x0800)
+#define UC7BIT                  (0x1000)
+#define UCMSB                   (0x2000)
+#define UCPAR                   (0x4000)
+#define UCPEN                   (0x8000)
+
+#define UCOS16                  (0x0001)
+
+#define UCBUSY                  (0x0001)
+#define UCOE                    (0x0020)
+
+#define UCRXIE                  (0x0001)
+#define UCTXIE                  (0x0002)
+#define UCSTTIE                 (0x0004)
+#define UCTXCPTIE               (0x0008)
+#define UCRXIFG                 (0x0001)
+#define UCTXIFG                 (0x0002)
+#define UCSTTIFG                (0x0004)
+#define UCTXCPTIFG              (0x0008)
+
+#define USCI_NONE               (0x0000)
+#define USCI_UART_UCRXIFG       (0x0002)
+#define USCI_UART_UCTXIFG       (0x0004)
+#define USCI_UART_UCSTTIFG      (0x0006)
+#define USCI_UART_UCTXCPTIFG    (0x0008)
+
+#define UCA0IV                  HWREG16(EUSCI_A0_BASE + OFS_UCAxIV)
+#define UCA3IV                  HWREG16(EUSCI_A3_BASE + OFS_UCAxIV)
+
+//*****************************************************************************
+// eUSCI_B, I2C mode
+//*****************************************************************************
+#define OFS_UCBxCTLW0           (0x0000)
+#define OFS_UCBxCTLW1           (0x0002)
+#define OFS_UCBxBRW             (0x0006)
+#define OFS_UCBxSTATW           (0x0008)
+#define OFS_UCBxTBCNT           (0x000A)
+#define OFS_UCBxRXBUF           (0x000C)
+#define OFS_UCBxTXBUF           (0x000E)
+#define OFS_UCBxI2COA0          (0x0014)
+#define OFS_UCBxI2CSA           (0x0020)
+#define OFS_UCBxIE              (0x002A)
+#define OFS_UCBxIFG             (0x002C)
+#define OFS_UCBxIV              (0x002E)
+
+#define UCTXSTT                 (0x0002)
+#define UCTXSTP                 (0x0004)
+#define UCTXNACK                (0x0008)
+#define UCTR                    (0x0010)
+#define UCMST                   (0x0800)
+#define UCMM                    (0x2000)
+
+#define UCGLIT0                 (0x0001)
+#define UCGLIT1                 (0x0002)
+#define UCASTP_0                (0x0000)
+#define UCASTP_3                (0x000C)
+#define UCCLTO_1                (0x0040)
+#define UCCLTO_3                (0x00C0)
+
+#define UCBBUSY                 (0x0010)
+
+#define UCRXIE0                 (0x0001)
+#define UCTXIE0                 (0x0002)
+#define UCSTTIE                 (0x0004)
+#define UCSTPIE                 (0x0008)
+#define UCALIE                  (0x0010)
+#define UCNACKIE                (0x0020)
+#define UCBCNTIE                (0x0040)
+#define UCCLTOIE                (0x0080)
+#define UCRXIFG0                (0x0001)
+#define UCTXIFG0                (0x0002)
+#define UCSTPIFG                (0x0008)
+#define UCALIFG                 (0x0010)
+#define UCNACKIFG               (0x0020)
+#define UCBCNTIFG               (0x0040)
+#define UCCLTOIFG               (0x0080)
+#define UCBIT9IFG               (0x4000)
+
+#define USCI_I2C_UCALIFG        (0x0002)
+#define USCI_I2C_UCNACKIFG      (0x0004)
+#define USCI_I2C_UCSTTIFG       (0x0006)
+#define USCI_I2C_UCSTPIFG       (0x0008)
+#define USCI_I2C_UCRXIFG3       (0x000A)
+#define USCI_I2C_UCTXIFG3       (0x000C)
+#define USCI_I2C_UCRXIFG2       (0x000E)
+#define USCI_I2C_UCTXIFG2       (0x0010)
+#define USCI_I2C_UCRXIFG1       (0x0012)
+#define USCI_I2C_UCTXIFG1       (0x0014)
+#define USCI_I2C_UCRXIFG0       (0x0016)
+#define USCI_I2C_UCTXIFG0       (0x0018)
+#define USCI_I2C_UCBCNTIFG      (0x001A)
+#define USCI_I2C_UCCLTOIFG      (0x001C)
+#define USCI_I2C_UCBIT9IFG      (0x001E)
+
+#define UCB2IV                  HWREG16(EUSCI_B2_BASE + OFS_UCBxIV)
+
+//*****************************************************************************
+// ADC12_B
+//*****************************************************************************
+#define OFS_ADC12CTL0           (0x0000)
+#define OFS_ADC12CTL0_L         OFS_ADC12CTL0
+#define OFS_ADC12CTL1           (0x0002)
+#define OFS_ADC12CTL1_L         OFS_ADC12CTL1
+#define OFS_ADC12CTL2           (0x0004)
+#define OFS_ADC12CTL2_L         OFS_ADC12CTL2
+#define OFS_ADC12CTL3           (0x0006)
+#define OFS_ADC12LO             (0x0008)
+#define OFS_ADC12HI             (0x000A)
+#define OFS_ADC12IFGR0          (0x000C)
+#define OFS_ADC12IFGR1          (0x000E)
+#define OFS_ADC12IFGR2          (0x0010)
+#define OFS_ADC12IER0           (0x0012)
+#define OFS_ADC12IER1           (0x0014)
+#define OFS_ADC12IER2           (0x0016)
+#define OFS_ADC12IV             (0x0018)
+#define OFS_ADC12MCTL0          (0x0020)
+#define OFS_ADC12MEM0           (0x0060)
+
+#define ADC12SC                 (0x0001)
+#define ADC12ENC                (0x0002)
+#define ADC12ON                 (0x0010)
+#define ADC12MSC                (0x0080)
+#define ADC12SHT0_0             (0x0000)
+#define ADC12SHT0_4             (0x0400)
+#define ADC12SHT0_15            (0x0F00)
+#define ADC12SHT1_15            (0xF000)
+
+#define ADC12BUSY               (0x0001)
+#define ADC12CONSEQ_3           (0x0006)
+#define ADC12SSEL_0             (0x0000)
+#define ADC12DIV_0              (0x0000)
+#define ADC12DIV_7              (0x00E0)
+#define ADC12ISSH               (0x0100)
+#define ADC12SHP                (0x0200)
+#define ADC12SHS_0              (0x0000)
+#define ADC12PDIV__1            (0x0000)
+#define ADC12PDIV__4            (0x2000)
+#define ADC12PDIV__32           (0x4000)
+#define ADC12PDIV__64           (0x6000)
+
+#define ADC12PWRMD              (0x0001)
+#define ADC12DF                 (0x0008)
+#define ADC12RES_2              (0x0020)
+#define ADC12RES_3              (0x0030)
+
+#define ADC12CSTARTADD_31       (0x001F)
+
+#define ADC12INCH_3             (0x0003)
+#define ADC12INCH_4             (0x0004)
+#define ADC12EOS                (0x0080)
+#define ADC12VRSEL_0            (0x0000)
+#define ADC12DIF                (0x2000)
+#define ADC12WINC               (0x4000)
+
+#define ADC12IFG0               (0x0001)
+#define ADC12IFG1               (0x0002)
+#define ADC12IE0                (0x0001)
+#define ADC12IE1                (0x0002)
+
+#define ADC12IV__NONE           (0x0000)
+#define ADC12IV__ADC12IFG0      (0x000C)
+#define ADC12IV__ADC12RDYIFG    (0x004C)
+
+#define ADC12IV                 HWREG16(ADC12_B_BASE + OFS_ADC12IV)
+
+//*****************************************************************************
+// CRC32 module
+//*****************************************************************************
+#define OFS_CRC32DIW0           (0x0000)
+#define OFS_CRC32DIW0_L         OFS_CRC32DIW0
+#define OFS_CRC32DIW1           (0x0002)
+#define OFS_CRC32DIRBW1         (0x0004)
+#define OFS_CRC32DIRBW1_L       OFS_CRC32DIRBW1
+#define OFS_CRC32DIRBW0         (0x0006)
+#define OFS_CRC32INIRESW0       (0x0008)
+#define OFS_CRC32INIRESW1       (0x000A)
+#define OFS_CRC32RESRW1         (0x000C)
+#define OFS_CRC32RESRW0         (0x000E)
+#define OFS_CRC16DIW0           (0x0010)
+#define OFS_CRC16DIW0_L         OFS_CRC16DIW0
+#define OFS_CRC16DIRBW0         (0x0016)
+#define OFS_CRC16DIRBW0_L       OFS_CRC16DIRBW0
+#define OFS_CRC16INIRESW0       (0x0018)
+#define OFS_CRC16RESRW0         (0x001E)
+
+//*****************************************************************************
+// AES256
+//*****************************************************************************
+#define OFS_AESACTL0            (0x0000)
+#define OFS_AESACTL1            (0x0002)
+#define OFS_AESASTAT            (0x0004)
+#define OFS_AESAKEY             (0x0006)
+#define OFS_AESADIN             (0x0008)
+#define OFS_AESADOUT            (0x000A)
+#define OFS_AESAXDIN            (0x000C)
+#define OFS_AESAXIN             (0x000E)
+
+#define AESOP0                  (0x0001)
+#define AESOP1                  (0x0002)
+#define AESOP_3                 (0x0003)
+#define AESKL_1                 (0x0004)
+#define AESKL_2                 (0x0008)
+#define AESKL__128              (0x0000)
+#define AESKL__192              (0x0004)
+#define AESKL__256              (0x0008)
+#define AESSWRST                (0x0080)
+#define AESRDYIFG               (0x0100)
+#define AESERRFG                (0x0800)
+#define AESRDYIE                (0x1000)
+
+#define AESBUSY                 (0x0001)
+#define AESKEYWR                (0x0002)
+
+//*****************************************************************************
+// Intrinsics, run by the simulator (sim/sim.c)
+//*****************************************************************************
+void Sim_setSR(unsigned short sr);
+unsigned short Sim_getSR(void);
+void Sim_bisSR(unsigned short bits);
+void Sim_bicSR(unsigned short bits);
+void Sim_bicSROnExit(unsigned short bits);
+void Sim_delay(unsigned long cycles);
+void Sim_writeAddress(unsigned short address, unsigned long value);
+
+#define __get_interrupt_state()         Sim_getSR()
+#define __set_interrupt_state(state)    Sim_setSR(state)
+#define __enable_interrupt()            Sim_bisSR(GIE)
+#define __disable_interrupt()           Sim_bicSR(GIE)
+#define __bis_SR_register(bits)         Sim_bisSR(bits)
+#define __bic_SR_register(bits)         Sim_bicSR(bits)
+#define __bic_SR_register_on_exit(bits) Sim_bicSROnExit(bits)
+#define __delay_cycles(cycles)          Sim_delay(cycles)
+#define __no_operation()                Sim_delay(1)
+#define __even_in_range(value, bound)   (value)
+#define __data16_write_addr(address, value) \
+        Sim_writeAddress(address, value)
+
+// The GNU ISR attribute, __attribute__((interrupt(VECTOR))), is emptied.
+// sim.c calls the handlers by name.
+#define interrupt(vector)
+
+#endif /* SIM_MSP430_H_ */
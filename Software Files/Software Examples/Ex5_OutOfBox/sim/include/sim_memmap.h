@@ -0,0 +1,41 @@
+/*
+ * sim_memmap.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef SIM_MEMMAP_H_
+#define SIM_MEMMAP_H_
+
+// Forced into every file of the host build (gcc -include). It takes the
+// place of driverlib's inc/hw_memmap.h, whose include guard it sets, so
+// HWREG8/16/32 go through the simulator instead of absolute addresses.
+
+#define __HW_MEMMAP__
+#define __DRIVERLIB_MSP430FR5XX_6XX_FAMILY__
+#include <msp430.h>
+
+#include "stdint.h"
+#include "stdbool.h"
+
+#define STATUS_SUCCESS  0x01
+#define STATUS_FAIL     0x00
+
+#define NDEBUG
+
+// Returns where the register lives in the simulated address space. The
+// access is settled (write side effects, TXBUF loads) at the next one.
+volatile void* Sim_register(uint16_t address, uint8_t width);
+
+#define HWREG32(x)                                                             \
+        (*((volatile uint32_t *)Sim_register((uint16_t)(x), 4)))
+#define HWREG16(x)                                                             \
+        (*((volatile uint16_t *)Sim_register((uint16_t)(x), 2)))
+#define HWREG8(x)                                                              \
+        (*((volatile uint8_t *)Sim_register((uint16_t)(x), 1)))
+
+// The firmware's void main(void) runs as Firmware_main, sim/sim_main.c
+// has the host entry point.
+#define main Firmware_main
+
+#endif /* SIM_MEMMAP_H_ */
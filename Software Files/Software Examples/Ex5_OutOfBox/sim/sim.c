@@ -0,0 +1,575 @@
+/*
+ * sim.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_MODELS_MAX (16)
+
+SimStats Sim_stats;
+
+static uint8_t memory[0x10000] __attribute__((aligned(4)));
+static SimModel* owner[0x1000 / 2];
+static SimModel* models[SIM_MODELS_MAX];
+static uint8_t model_count = 0;
+
+static uint64_t now = 0;
+static uint64_t smclk = 0;
+static uint64_t limit = SIM_NEVER;
+static jmp_buf stop;
+static bool failed;
+
+static uint16_t sr = 0;
+// SR pushed by the interrupt being served, for __bic_SR_register_on_exit
+static uint16_t* saved_sr = 0;
+
+// the access handed out last, settled at the next one
+static struct {
+    bool active;
+    uint16_t address;
+    uint8_t width;
+    uint16_t old[2];
+    SimModel* model;
+} pending;
+
+//*****************************************************************************
+// Interrupt vectors, highest priority first. Weak: a build without a
+// module (no -DSHT35) has no handler, its flags then never interrupt.
+//*****************************************************************************
+void TIMER0_B1_ISR(void) __attribute__((weak));
+void USCI_A0_ISR(void) __attribute__((weak));
+void ADC12_ISR(void) __attribute__((weak));
+void TIMER0_A0_ISR(void) __attribute__((weak));
+void TIMER0_A1_ISR(void) __attribute__((weak));
+void DMA_ISR(void) __attribute__((weak));
+void AES256_ISR(void) __attribute__((weak));
+void USCI_A3_ISR(void) __attribute__((weak));
+void USCIB2_ISR(void) __attribute__((weak));
+
+typedef struct {
+    const char* name;
+    void (*isr)(void);
+    bool (*pending)(void);
+    uint32_t count;
+    uint64_t cycles;
+} SimVector;
+
+static bool Sim_enabled(uint16_t ie, uint16_t ifg)
+{
+    return (Sim_get16(ie) & Sim_get16(ifg)) != 0;
+}
+
+static bool Sim_ccPending(uint16_t cctl)
+{
+    uint16_t value = Sim_get16(cctl);
+    return (value & CCIE) && (value & CCIFG);
+}
+
+static bool Sim_timer0B1(void)
+{
+    uint16_t ctl = Sim_get16(TIMER_B0_BASE + OFS_TBxCTL);
+    return (ctl & TBIE) && (ctl & TBIFG);
+}
+
+static bool Sim_usciA0(void)
+{
+    return Sim_enabled(EUSCI_A0_BASE + OFS_UCAxIE, EUSCI_A0_BASE + OFS_UCAxIFG);
+}
+
+static bool Sim_adc12(void)
+{
+    return Sim_enabled(ADC12_B_BASE + OFS_ADC12IER0, ADC12_B_BASE + OFS_ADC12IFGR0)
+            || Sim_enabled(ADC12_B_BASE + OFS_ADC12IER1,
+                    ADC12_B_BASE + OFS_ADC12IFGR1)
+            || Sim_enabled(ADC12_B_BASE + OFS_ADC12IER2,
+                    ADC12_B_BASE + OFS_ADC12IFGR2);
+}
+
+static bool Sim_timer0A0(void)
+{
+    return Sim_ccPending(TIMER_A0_BASE + OFS_TAxCCTL0);
+}
+
+static bool Sim_timer0A1(void)
+{
+    uint8_t i;
+    uint16_t ctl = Sim_get16(TIMER_A0_BASE + OFS_TAxCTL);
+
+    if ((ctl & TAIE) && (ctl & TAIFG))
+        return true;
+    for (i = 1; i < 7; i++) {
+        if (Sim_ccPending(TIMER_A0_BASE + OFS_TAxCCTL0 + 2 * i))
+            return true;
+    }
+    return false;
+}
+
+static bool Sim_dma(void)
+{
+    uint8_t i;
+    for (i = 0; i < 6; i++) {
+        uint16_t ctl = Sim_get16(DMA_BASE + OFS_DMA0CTL + 0x10 * i);
+        if ((ctl & DMAIE) && (ctl & DMAIFG))
+            return true;
+    }
+    return false;
+}
+
+static bool Sim_aes256(void)
+{
+    uint16_t ctl = Sim_get16(AES256_BASE + OFS_AESACTL0);
+    return (ctl & AESRDYIE) && (ctl & AESRDYIFG);
+}
+
+static bool Sim_usciA3(void)
+{
+    return Sim_enabled(EUSCI_A3_BASE + OFS_UCAxIE, EUSCI_A3_BASE + OFS_UCAxIFG);
+}
+
+static bool Sim_usciB2(void)
+{
+    return Sim_enabled(EUSCI_B2_BASE + OFS_UCBxIE, EUSCI_B2_BASE + OFS_UCBxIFG);
+}
+
+static SimVector vectors[] = {
+    { .name = "TIMER0_B1", .isr = TIMER0_B1_ISR, .pending = Sim_timer0B1 },
+    { .name = "USCI_A0", .isr = USCI_A0_ISR, .pending = Sim_usciA0 },
+    { .name = "ADC12", .isr = ADC12_ISR, .pending = Sim_adc12 },
+    { .name = "TIMER0_A0", .isr = TIMER0_A0_ISR, .pending = Sim_timer0A0 },
+    { .name = "TIMER0_A1", .isr = TIMER0_A1_ISR, .pending = Sim_timer0A1 },
+    { .name = "DMA", .isr = DMA_ISR, .pending = Sim_dma },
+    { .name = "AES256", .isr = AES256_ISR, .pending = Sim_aes256 },
+    { .name = "USCI_A3", .isr = USCI_A3_ISR, .pending = Sim_usciA3 },
+    { .name = "USCI_B2", .isr = USCIB2_ISR, .pending = Sim_usciB2 },
+};
+
+#define SIM_VECTORS (sizeof(vectors) / sizeof(vectors[0]))
+
+//*****************************************************************************
+// Clock
+//*****************************************************************************
+static uint8_t Sim_lpm(void)
+{
+    if (sr & OSCOFF)
+        return 4;
+    switch (sr & (SCG1 | SCG0)) {
+    case 0:
+        return 0;
+    case SCG0:
+        return 1;
+    case SCG1:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+// Moves the clock to time, nothing may be scheduled before it
+static void Sim_elapse(uint64_t time)
+{
+    uint64_t delta = time - now;
+
+    if (time <= now)
+        return;
+    if (sr & CPUOFF) {
+        Sim_stats.sleep[Sim_lpm()] += delta;
+        if (!(sr & SCG1))
+            smclk += delta;
+    } else {
+        Sim_stats.active += delta;
+        smclk += delta;
+    }
+    now = time;
+}
+
+static SimModel* Sim_earliest(void)
+{
+    SimModel* first = 0;
+    uint8_t i;
+
+    for (i = 0; i < model_count; i++) {
+        if (models[i]->next != SIM_NEVER
+                && (first == 0 || models[i]->next < first->next))
+            first = models[i];
+    }
+    return first;
+}
+
+// Runs the model events up to time and moves the clock there. Ends the
+// run once the limit is reached.
+static void Sim_advance(uint64_t time)
+{
+    for (;;) {
+        SimModel* model = Sim_earliest();
+        bool due = model != 0 && model->next <= time;
+        uint64_t at = due ? model->next : time;
+
+        if (at >= limit) {
+            Sim_elapse(limit);
+            longjmp(stop, 1);
+        }
+        Sim_elapse(at);
+        if (!due)
+            return;
+        model->next = SIM_NEVER;
+        model->event(model);
+    }
+}
+
+static void Sim_spend(uint64_t cycles)
+{
+    Sim_advance(now + cycles);
+}
+
+uint64_t Sim_now(void)
+{
+    return now;
+}
+
+uint64_t Sim_smclk(void)
+{
+    return smclk;
+}
+
+uint32_t Sim_aclkHz(void)
+{
+    uint32_t hz;
+
+    switch ((Sim_get16(CS_BASE + OFS_CSCTL2) & SELA_7) >> 8) {
+    case SELM__LFXTCLK:
+        hz = 32768;
+        break;
+    case SELM__VLOCLK:
+        hz = 9400;
+        break;
+    case SELM__LFMODOSC:
+        hz = 39062;
+        break;
+    default:
+        return 0;
+    }
+    return hz >> ((Sim_get16(CS_BASE + OFS_CSCTL3) >> 8) & 0x7);
+}
+
+void Sim_schedule(SimModel* model, uint64_t time)
+{
+    model->next = time < now ? now : time;
+}
+
+//*****************************************************************************
+// Register space
+//*****************************************************************************
+uint16_t Sim_get16(uint16_t address)
+{
+    return *(uint16_t*) &memory[address & ~1];
+}
+
+void Sim_set16(uint16_t address, uint16_t value)
+{
+    *(uint16_t*) &memory[address & ~1] = value;
+}
+
+void Sim_setBits(uint16_t address, uint16_t bits)
+{
+    Sim_set16(address, Sim_get16(address) | bits);
+}
+
+void Sim_clearBits(uint16_t address, uint16_t bits)
+{
+    Sim_set16(address, Sim_get16(address) & ~bits);
+}
+
+static SimModel* Sim_owner(uint16_t address)
+{
+    return address < 0x1000 ? owner[address >> 1] : 0;
+}
+
+uint8_t Sim_load8(uint32_t address)
+{
+    if (address > 0xFFFF)
+        return *(uint8_t*) (uintptr_t) address;
+    return memory[address];
+}
+
+void Sim_store8(uint32_t address, uint8_t value)
+{
+    SimModel* model;
+    uint16_t old;
+
+    if (address > 0xFFFF) {
+        *(uint8_t*) (uintptr_t) address = value;
+        return;
+    }
+    model = Sim_owner(address);
+    old = Sim_get16(address);
+    memory[address] = value;
+    if (model && model->write)
+        model->write(model, (address & ~1) - model->base, old, 1);
+}
+
+uint16_t Sim_load16(uint32_t address)
+{
+    if (address > 0xFFFF)
+        return *(uint16_t*) (uintptr_t) address;
+    return Sim_get16(address);
+}
+
+void Sim_store16(uint32_t address, uint16_t value)
+{
+    SimModel* model;
+    uint16_t old;
+
+    if (address > 0xFFFF) {
+        *(uint16_t*) (uintptr_t) address = value;
+        return;
+    }
+    model = Sim_owner(address);
+    old = Sim_get16(address);
+    Sim_set16(address, value);
+    if (model && model->write)
+        model->write(model, (address & ~1) - model->base, old, 2);
+}
+
+void Sim_addModel(SimModel* model)
+{
+    uint16_t address;
+
+    if (model_count == SIM_MODELS_MAX)
+        Sim_fail("too many models");
+    model->next = SIM_NEVER;
+    models[model_count++] = model;
+    for (address = model->base; address < model->base + model->size;
+            address += 2)
+        owner[address >> 1] = model;
+}
+
+// Finishes the access handed out last: the firmware has read or written
+// it by now.
+static void Sim_settle(void)
+{
+    uint16_t address;
+
+    if (!pending.active)
+        return;
+    pending.active = false;
+    if (!pending.model || !pending.model->write)
+        return;
+    address = pending.address & ~1;
+    pending.model->write(pending.model, address - pending.model->base,
+            pending.old[0], pending.width > 2 ? 2 : pending.width);
+    if (pending.width == 4)
+        pending.model->write(pending.model, address + 2 - pending.model->base,
+                pending.old[1], 2);
+}
+
+//*****************************************************************************
+// Interrupts and low power modes
+//*****************************************************************************
+static SimVector* Sim_pendingVector(void)
+{
+    uint8_t i;
+    for (i = 0; i < SIM_VECTORS; i++) {
+        if (vectors[i].isr && vectors[i].pending())
+            return &vectors[i];
+    }
+    return 0;
+}
+
+// Serves interrupts while GIE is set, like the CPU between instructions
+static void Sim_dispatch(void)
+{
+    SimVector* vector;
+
+    while ((sr & GIE) && (vector = Sim_pendingVector()) != 0) {
+        uint16_t saved = sr;
+        uint16_t* outer = saved_sr;
+        uint64_t start = now;
+
+        saved_sr = &saved;
+        sr = 0;
+        Sim_spend(SIM_ISR_ENTRY_CYCLES);
+        vector->isr();
+        Sim_settle();
+        Sim_spend(SIM_RETI_CYCLES);
+        vector->count++;
+        vector->cycles += now - start;
+        saved_sr = outer;
+        sr = saved;
+    }
+}
+
+// Sleeps while CPUOFF is set, the clock jumps from event to event
+static void Sim_sleep(void)
+{
+    if (!(sr & CPUOFF))
+        return;
+    Sim_stats.sleeps++;
+    while (sr & CPUOFF) {
+        SimModel* model;
+
+        if (!(sr & GIE))
+            Sim_fail("CPU off with interrupts disabled");
+        model = Sim_earliest();
+        if (model == 0)
+            Sim_fail("asleep with nothing left to wake the CPU");
+        Sim_advance(model->next);
+        Sim_dispatch();
+    }
+}
+
+volatile void* Sim_register(uint16_t address, uint8_t width)
+{
+    SimModel* model;
+
+    Sim_settle();
+    Sim_spend(SIM_ACCESS_CYCLES);
+    Sim_dispatch();
+    Sim_stats.accesses++;
+    model = Sim_owner(address);
+    if (model) {
+        model->accesses++;
+        if (model->read)
+            model->read(model, (address & ~1) - model->base);
+    }
+    pending.active = true;
+    pending.address = address;
+    pending.width = width;
+    pending.old[0] = Sim_get16(address);
+    pending.old[1] = Sim_get16(address + 2);
+    pending.model = model;
+    return &memory[address];
+}
+
+unsigned short Sim_getSR(void)
+{
+    return sr;
+}
+
+void Sim_setSR(unsigned short value)
+{
+    Sim_settle();
+    sr = value;
+    Sim_spend(1);
+    Sim_dispatch();
+    Sim_sleep();
+}
+
+void Sim_bisSR(unsigned short bits)
+{
+    Sim_settle();
+    sr |= bits;
+    Sim_spend(1);
+    Sim_dispatch();
+    Sim_sleep();
+}
+
+void Sim_bicSR(unsigned short bits)
+{
+    Sim_settle();
+    sr &= ~bits;
+    Sim_spend(1);
+}
+
+void Sim_bicSROnExit(unsigned short bits)
+{
+    if (saved_sr == 0)
+        Sim_fail("__bic_SR_register_on_exit outside an interrupt");
+    *saved_sr &= ~bits;
+}
+
+void Sim_delay(unsigned long cycles)
+{
+    Sim_settle();
+    Sim_spend(cycles);
+    Sim_dispatch();
+}
+
+// __data16_write_addr: a 20 bit address register written in one access
+void Sim_writeAddress(unsigned short address, unsigned long value)
+{
+    volatile uint32_t* reg = Sim_register(address, 4);
+    *reg = (uint32_t) value;
+    Sim_settle();
+}
+
+//*****************************************************************************
+// Run control
+//*****************************************************************************
+void Sim_init(void)
+{
+    memset(memory, 0, sizeof(memory));
+    // CS reset state: DCO 8 MHz, ACLK from LFXT, MCLK and SMCLK DCO / 8
+    Sim_set16(CS_BASE + OFS_CSCTL1, DCOFSEL_6);
+    Sim_set16(CS_BASE + OFS_CSCTL2, 0x0033);
+    Sim_set16(CS_BASE + OFS_CSCTL3, 0x0033);
+    Sim_set16(CS_BASE + OFS_CSCTL4, 0xCDC9);
+    Sim_set16(PMM_BASE + OFS_PM5CTL0, LOCKLPM5);
+}
+
+bool Sim_call(void (*function)(void), uint64_t cycles)
+{
+    limit = now + cycles;
+    failed = false;
+    if (setjmp(stop) == 0) {
+        function();
+        Sim_settle();
+    }
+    limit = SIM_NEVER;
+    return !failed;
+}
+
+bool Sim_run(uint64_t cycles)
+{
+    return Sim_call(Firmware_main, cycles);
+}
+
+void Sim_fail(const char* format, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "sim: %.6f s: ", (double) now / SIM_MCLK_HZ);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    failed = true;
+    longjmp(stop, 1);
+}
+
+void Sim_report(void)
+{
+    uint8_t i;
+    uint64_t total = now ? now : 1;
+
+    printf("time        %.3f s, %llu cycles at %lu Hz\n",
+            (double) now / SIM_MCLK_HZ, (unsigned long long) now,
+            SIM_MCLK_HZ);
+    printf("cpu active  %llu cycles (%.3f%%)\n",
+            (unsigned long long) Sim_stats.active,
+            100.0 * Sim_stats.active / total);
+    for (i = 0; i < 5; i++) {
+        if (Sim_stats.sleep[i])
+            printf("LPM%u        %llu cycles (%.3f%%)\n", i,
+                    (unsigned long long) Sim_stats.sleep[i],
+                    100.0 * Sim_stats.sleep[i] / total);
+    }
+    printf("sleeps      %lu\n", (unsigned long) Sim_stats.sleeps);
+    printf("accesses    %lu\n", (unsigned long) Sim_stats.accesses);
+    for (i = 0; i < model_count; i++) {
+        if (models[i]->accesses)
+            printf("  %-10s %lu\n", models[i]->name,
+                    (unsigned long) models[i]->accesses);
+    }
+    printf("interrupts\n");
+    for (i = 0; i < SIM_VECTORS; i++) {
+        if (vectors[i].count)
+            printf("  %-10s %lu, %.1f cycles each\n", vectors[i].name,
+                    (unsigned long) vectors[i].count,
+                    (double) vectors[i].cycles / vectors[i].count);
+    }
+}
@@ -0,0 +1,136 @@
+/*
+ * sim.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifndef SIM_H_
+#define SIM_H_
+
+// Host simulation of the out-of-box firmware.
+//
+// The application and its driverlib files are compiled with gcc against
+// sim/include: every HWREG access lands in Sim_register, which keeps a 64k
+// byte register space, advances a cycle clock and calls the peripheral
+// model that owns the address. Models schedule their own events (a byte
+// shifted out, a conversion done) and raise the same flags the hardware
+// would; the firmware's ISRs are then called by name in vector priority
+// order whenever GIE is set. Sleeping (__bis_SR_register with CPUOFF)
+// jumps the clock to the next model event.
+//
+// Cycle counts are estimates: register accesses, interrupt entry/exit and
+// __delay_cycles cost time, plain C code between accesses does not.
+
+#define SIM_MCLK_HZ             (8000000UL)
+#define SIM_NEVER               (UINT64_MAX)
+
+// MCLK cycles charged per register access, interrupt entry and RETI
+#define SIM_ACCESS_CYCLES       (3)
+#define SIM_ISR_ENTRY_CYCLES    (6)
+#define SIM_RETI_CYCLES         (5)
+
+#define SIM_CYCLES_MS(ms)       ((uint64_t)(ms) * (SIM_MCLK_HZ / 1000))
+
+// A peripheral model owns the registers base..base + size - 1. read runs
+// before an access, write after it (with the aligned 16 bit value from
+// before, for every access: strobes such as TXBUF have the same value
+// twice). event runs once the clock reaches next.
+typedef struct SimModel {
+    const char* name;
+    uint16_t base;
+    uint16_t size;
+    void (*read)(struct SimModel* model, uint16_t offset);
+    void (*write)(struct SimModel* model, uint16_t offset, uint16_t old,
+            uint8_t width);
+    void (*event)(struct SimModel* model);
+    uint64_t next;
+    uint32_t accesses;
+} SimModel;
+
+typedef struct {
+    uint64_t active;            // MCLK cycles with the CPU on
+    uint64_t sleep[5];          // cycles in LPM0..LPM4
+    uint32_t sleeps;            // __bis_SR_register calls that slept
+    uint32_t accesses;          // register accesses by the firmware
+} SimStats;
+
+extern SimStats Sim_stats;
+
+void Sim_init(void);
+void Sim_addModel(SimModel* model);
+// Runs Firmware_main for cycles, returns false if the run was stopped by
+// Sim_fail.
+bool Sim_run(uint64_t cycles);
+// Same for any firmware function; returns true when it comes back or
+// the cycles are used up
+bool Sim_call(void (*function)(void), uint64_t cycles);
+void Sim_fail(const char* format, ...);
+void Sim_report(void);
+
+uint64_t Sim_now(void);
+// SMCLK cycles so far, SMCLK stops in LPM2..4 (SCG1)
+uint64_t Sim_smclk(void);
+uint32_t Sim_aclkHz(void);
+void Sim_schedule(SimModel* model, uint64_t time);
+
+// Register space as seen by the models, no side effects
+uint16_t Sim_get16(uint16_t address);
+void Sim_set16(uint16_t address, uint16_t value);
+void Sim_setBits(uint16_t address, uint16_t bits);
+void Sim_clearBits(uint16_t address, uint16_t bits);
+// Bus master access (DMA): addresses past 0xFFFF are host pointers, word
+// addresses are even
+uint8_t Sim_load8(uint32_t address);
+void Sim_store8(uint32_t address, uint8_t value);
+uint16_t Sim_load16(uint32_t address);
+void Sim_store16(uint32_t address, uint16_t value);
+
+// Peripheral models
+typedef struct SimUart SimUart;
+typedef void (*SimUartOutput)(SimUart* uart, uint8_t data);
+
+void SimTimer_init(void);
+SimUart* SimUart_init(uint16_t base, const char* name, SimUartOutput output);
+void SimUart_input(SimUart* uart, const uint8_t data[], uint16_t length,
+        uint64_t delay);
+void SimUart_report(SimUart* uart);
+void SimDma_init(void);
+void SimDma_trigger(uint8_t trigger);
+void SimAdc_init(void);
+void SimAdc_setInput(uint8_t input, uint16_t value, uint16_t noise);
+void SimAdc_report(void);
+void SimI2c_init(void);
+void SimI2c_report(void);
+void SimSht35_set(double temperature, double humidity);
+void SimSystem_init(void);
+#define SIM_AES_KEY_SIZE        (32)
+#define SIM_AES_BLOCK_SIZE      (16)
+void SimAes_init(void);
+// The same cipher in software
+void SimAes_encrypt(const uint8_t key[SIM_AES_KEY_SIZE],
+        const uint8_t in[SIM_AES_BLOCK_SIZE], uint8_t out[SIM_AES_BLOCK_SIZE]);
+// The key last loaded into AESAKEY, false if there is none
+bool SimAes_key(uint8_t key[SIM_AES_KEY_SIZE]);
+void SimAes_report(void);
+// UCA3 peer; the link is down from offline_from to offline_until (cycles)
+void SimEsp32_init(uint64_t offline_from, uint64_t offline_until, bool echo);
+// line is sent, without its CR LF, after one of the next answers
+void SimEsp32_config(const char* line);
+// readings the ESP32 accepted go to trace, may be NULL
+void SimEsp32_trace(FILE* trace);
+// garble every corrupt-th frame and lose the answer to every drop-th, 0
+// for none
+void SimEsp32_loss(uint32_t corrupt, uint32_t drop);
+void SimEsp32_report(void);
+
+// DMA trigger sources of channels 3..5
+#define SIM_DMA_UCA3RXIFG       (16)
+#define SIM_DMA_UCA3TXIFG       (17)
+
+// the firmware
+void Firmware_main(void);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,197 @@
+/*
+ * sim_adc.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// ADC12_B started by ADC12SC, all four conversion sequence modes, with
+// multiple sample and conversion (back to back conversions). A conversion
+// takes the sample and hold time plus 14 ADC12CLK cycles; ADC12CLK is
+// MODOSC (4.8 MHz) or SMCLK. Results come from the injected inputs:
+// value +- noise, right aligned 12 bit.
+
+#define SIM_ADC_INPUTS (32)
+#define SIM_ADC_MODOSC_HZ (4800000UL)
+
+static struct {
+    SimModel model;
+    bool busy;
+    uint8_t index;              // ADC12MCTLx/MEMx being converted
+    uint16_t value[SIM_ADC_INPUTS];
+    uint16_t noise[SIM_ADC_INPUTS];
+    uint32_t conversions;
+    uint32_t overflows;
+} adc;
+
+static const uint16_t sample_cycles[16] = {
+    4, 8, 16, 32, 64, 96, 128, 192, 256, 384, 512, 512, 512, 512, 512, 512
+};
+
+static uint16_t SimAdc_get(uint16_t offset)
+{
+    return Sim_get16(ADC12_B_BASE + offset);
+}
+
+static uint64_t SimAdc_conversionCycles(uint8_t index)
+{
+    uint16_t ctl0 = SimAdc_get(OFS_ADC12CTL0);
+    uint16_t ctl1 = SimAdc_get(OFS_ADC12CTL1);
+    static const uint8_t predivider[4] = { 1, 4, 32, 64 };
+    uint32_t clock = ((ctl1 >> 3) & 0x3) == 0 ? SIM_ADC_MODOSC_HZ :
+            ((ctl1 >> 3) & 0x3) == 1 ? Sim_aclkHz() : SIM_MCLK_HZ;
+    uint32_t divider = predivider[(ctl1 >> 13) & 0x3] * (((ctl1 >> 5) & 0x7) + 1);
+    uint16_t sht = (index < 8 || index > 23) ? (ctl0 >> 8) & 0xF :
+            (ctl0 >> 12) & 0xF;
+    uint64_t adcclk = sample_cycles[sht] + 14;
+
+    if (clock == 0)
+        Sim_fail("ADC12: no clock");
+    return adcclk * divider * SIM_MCLK_HZ / clock;
+}
+
+static void SimAdc_start(uint8_t index)
+{
+    adc.busy = true;
+    adc.index = index;
+    Sim_setBits(ADC12_B_BASE + OFS_ADC12CTL1, ADC12BUSY);
+    Sim_schedule(&adc.model, Sim_now() + SimAdc_conversionCycles(index));
+}
+
+static void SimAdc_stop(void)
+{
+    adc.busy = false;
+    Sim_clearBits(ADC12_B_BASE + OFS_ADC12CTL1, ADC12BUSY);
+    Sim_schedule(&adc.model, SIM_NEVER);
+}
+
+static uint16_t SimAdc_sample(uint8_t input)
+{
+    int32_t value = adc.value[input];
+    if (adc.noise[input])
+        value += rand() % (2 * adc.noise[input] + 1) - adc.noise[input];
+    if (value < 0)
+        value = 0;
+    if (value > 0x0FFF)
+        value = 0x0FFF;
+    return value;
+}
+
+static void SimAdc_event(SimModel* model)
+{
+    uint8_t index = adc.index;
+    uint16_t mctl = SimAdc_get(OFS_ADC12MCTL0 + 2 * index);
+    uint16_t ifg = ADC12_B_BASE + OFS_ADC12IFGR0 + 2 * (index / 16);
+    uint8_t sequence = (SimAdc_get(OFS_ADC12CTL1) >> 1) & 0x3;
+    bool enabled = SimAdc_get(OFS_ADC12CTL0) & ADC12ENC;
+
+    (void) model;
+    if (Sim_get16(ifg) & (1 << (index % 16)))
+        adc.overflows++;
+    Sim_set16(ADC12_B_BASE + OFS_ADC12MEM0 + 2 * index,
+            SimAdc_sample(mctl & 0x1F));
+    Sim_setBits(ifg, 1 << (index % 16));
+    adc.conversions++;
+
+    switch (sequence) {
+    case 0:
+        SimAdc_stop();
+        break;
+    case 1:
+        if (mctl & ADC12EOS)
+            SimAdc_stop();
+        else
+            SimAdc_start((index + 1) % 32);
+        break;
+    case 2:
+        if (enabled)
+            SimAdc_start(index);
+        else
+            SimAdc_stop();
+        break;
+    default:
+        if (!(mctl & ADC12EOS))
+            SimAdc_start((index + 1) % 32);
+        else if (enabled)
+            SimAdc_start(SimAdc_get(OFS_ADC12CTL3) & ADC12CSTARTADD_31);
+        else
+            SimAdc_stop();
+        break;
+    }
+}
+
+static void SimAdc_read(SimModel* model, uint16_t offset)
+{
+    uint8_t i;
+
+    (void) model;
+    if (offset >= OFS_ADC12MEM0 && offset < OFS_ADC12MEM0 + 64) {
+        // reading a result clears its flag
+        i = (offset - OFS_ADC12MEM0) / 2;
+        Sim_clearBits(ADC12_B_BASE + OFS_ADC12IFGR0 + 2 * (i / 16),
+                1 << (i % 16));
+    } else if (offset == OFS_ADC12IV) {
+        for (i = 0; i < 32; i++) {
+            uint16_t ifg = ADC12_B_BASE + OFS_ADC12IFGR0 + 2 * (i / 16);
+            uint16_t ie = ADC12_B_BASE + OFS_ADC12IER0 + 2 * (i / 16);
+            uint16_t bit = 1 << (i % 16);
+            if (Sim_get16(ifg) & Sim_get16(ie) & bit) {
+                Sim_clearBits(ifg, bit);
+                Sim_set16(ADC12_B_BASE + OFS_ADC12IV,
+                        ADC12IV__ADC12IFG0 + 2 * i);
+                return;
+            }
+        }
+        Sim_set16(ADC12_B_BASE + OFS_ADC12IV, ADC12IV__NONE);
+    }
+}
+
+static void SimAdc_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    uint16_t ctl0 = SimAdc_get(OFS_ADC12CTL0);
+
+    (void) model;
+    (void) width;
+    if (offset != OFS_ADC12CTL0 && offset != OFS_ADC12CTL1)
+        return;
+    if (offset == OFS_ADC12CTL0 && (ctl0 & ADC12SC)) {
+        // SC clears itself once the conversion starts (pulse sample mode)
+        Sim_clearBits(ADC12_B_BASE + OFS_ADC12CTL0, ADC12SC);
+        if ((ctl0 & ADC12ENC) && (ctl0 & ADC12ON) && !adc.busy)
+            SimAdc_start(SimAdc_get(OFS_ADC12CTL3) & ADC12CSTARTADD_31);
+    }
+    // clearing ENC in single conversion mode aborts right away
+    if (adc.busy && !(ctl0 & ADC12ENC)
+            && (((SimAdc_get(OFS_ADC12CTL1) >> 1) & 0x3) == 0
+                    || !(ctl0 & ADC12ON)))
+        SimAdc_stop();
+    (void) old;
+}
+
+void SimAdc_setInput(uint8_t input, uint16_t value, uint16_t noise)
+{
+    if (input < SIM_ADC_INPUTS) {
+        adc.value[input] = value;
+        adc.noise[input] = noise;
+    }
+}
+
+void SimAdc_report(void)
+{
+    printf("ADC12 %lu conversions, %lu overwritten unread\n",
+            (unsigned long) adc.conversions, (unsigned long) adc.overflows);
+}
+
+void SimAdc_init(void)
+{
+    adc.model.name = "ADC12_B";
+    adc.model.base = ADC12_B_BASE;
+    adc.model.size = 0xA0;
+    adc.model.read = SimAdc_read;
+    adc.model.write = SimAdc_write;
+    adc.model.event = SimAdc_event;
+    Sim_addModel(&adc.model);
+}
@@ -0,0 +1,254 @@
+/*
+ * sim_aes.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+#include <string.h>
+
+// AES256 accelerator, encryption with 256 bit keys only. The key goes to
+// AESAKEY in 16 words and sets AESKEYWR, the block to AESADIN in 8. With
+// AESKEYWR set, the 8th word or setting AESKEYWR after it starts the
+// module: AESBUSY for SIM_AES_CYCLES, then the result can be read from
+// AESADOUT in 8 words and AESRDYIFG is set. Writing AESAKEY or AESADIN or
+// reading AESADOUT clears AESRDYIFG.
+//
+// SimAes_encrypt is the same cipher in software, the ESP32 model and the
+// benchmarks use it to check what the firmware sends. SimAes_init tests
+// it against the FIPS-197 example first.
+
+// AES-256 encryption, MSP430FR599x datasheet
+#define SIM_AES_CYCLES      (234)
+#define SIM_AES_ROUNDS      (14)
+
+static const uint8_t sbox[256] = {
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B,
+    0xFE, 0xD7, 0xAB, 0x76, 0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0,
+    0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0, 0xB7, 0xFD, 0x93, 0x26,
+    0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2,
+    0xEB, 0x27, 0xB2, 0x75, 0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0,
+    0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84, 0x53, 0xD1, 0x00, 0xED,
+    0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F,
+    0x50, 0x3C, 0x9F, 0xA8, 0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5,
+    0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2, 0xCD, 0x0C, 0x13, 0xEC,
+    0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14,
+    0xDE, 0x5E, 0x0B, 0xDB, 0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C,
+    0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79, 0xE7, 0xC8, 0x37, 0x6D,
+    0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F,
+    0x4B, 0xBD, 0x8B, 0x8A, 0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E,
+    0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E, 0xE1, 0xF8, 0x98, 0x11,
+    0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F,
+    0xB0, 0x54, 0xBB, 0x16
+};
+
+static struct {
+    SimModel model;
+    uint8_t key[SIM_AES_KEY_SIZE];
+    uint8_t key_words;
+    bool key_loaded;
+    uint8_t in[SIM_AES_BLOCK_SIZE];
+    uint8_t in_words;
+    uint8_t out[SIM_AES_BLOCK_SIZE];
+    uint8_t out_words;
+    uint32_t blocks;
+} aes;
+
+//*****************************************************************************
+// Cipher
+//*****************************************************************************
+static uint8_t SimAes_xtime(uint8_t x)
+{
+    return (x << 1) ^ ((x & 0x80) ? 0x1B : 0);
+}
+
+void SimAes_encrypt(const uint8_t key[SIM_AES_KEY_SIZE],
+        const uint8_t in[SIM_AES_BLOCK_SIZE], uint8_t out[SIM_AES_BLOCK_SIZE])
+{
+    uint8_t w[SIM_AES_BLOCK_SIZE * (SIM_AES_ROUNDS + 1)];
+    uint8_t s[SIM_AES_BLOCK_SIZE];
+    uint8_t t[SIM_AES_BLOCK_SIZE];
+    uint8_t k[4];
+    uint8_t rcon = 1;
+    uint8_t all, first;
+    uint16_t i;
+    uint8_t r, c;
+
+    // key expansion
+    memcpy(w, key, SIM_AES_KEY_SIZE);
+    for (i = SIM_AES_KEY_SIZE; i < sizeof(w); i += 4) {
+        memcpy(k, w + i - 4, 4);
+        if (i % SIM_AES_KEY_SIZE == 0) {
+            first = k[0];
+            k[0] = sbox[k[1]] ^ rcon;
+            k[1] = sbox[k[2]];
+            k[2] = sbox[k[3]];
+            k[3] = sbox[first];
+            rcon = SimAes_xtime(rcon);
+        } else if (i % SIM_AES_KEY_SIZE == 16) {
+            for (c = 0; c < 4; c++)
+                k[c] = sbox[k[c]];
+        }
+        for (c = 0; c < 4; c++)
+            w[i + c] = w[i - SIM_AES_KEY_SIZE + c] ^ k[c];
+    }
+
+    // the state is column major, byte 4 * column + row
+    for (i = 0; i < SIM_AES_BLOCK_SIZE; i++)
+        s[i] = in[i] ^ w[i];
+    for (r = 1; r <= SIM_AES_ROUNDS; r++) {
+        // SubBytes and ShiftRows
+        for (c = 0; c < 4; c++)
+            for (i = 0; i < 4; i++)
+                t[4 * c + i] = sbox[s[4 * ((c + i) % 4) + i]];
+        // MixColumns, all rounds but the last
+        for (c = 0; r < SIM_AES_ROUNDS && c < 4; c++) {
+            uint8_t* a = t + 4 * c;
+            all = a[0] ^ a[1] ^ a[2] ^ a[3];
+            first = a[0];
+            a[0] ^= all ^ SimAes_xtime(a[0] ^ a[1]);
+            a[1] ^= all ^ SimAes_xtime(a[1] ^ a[2]);
+            a[2] ^= all ^ SimAes_xtime(a[2] ^ a[3]);
+            a[3] ^= all ^ SimAes_xtime(a[3] ^ first);
+        }
+        for (i = 0; i < SIM_AES_BLOCK_SIZE; i++)
+            s[i] = t[i] ^ w[SIM_AES_BLOCK_SIZE * r + i];
+    }
+    memcpy(out, s, SIM_AES_BLOCK_SIZE);
+}
+
+//*****************************************************************************
+// Module
+//*****************************************************************************
+static void SimAes_start(void)
+{
+    uint16_t ctl = Sim_get16(AES256_BASE + OFS_AESACTL0);
+
+    if (ctl & AESOP_3)
+        Sim_fail("AES256: only encryption is modelled");
+    if ((ctl & (AESKL_1 | AESKL_2)) != AESKL__256)
+        Sim_fail("AES256: only 256 bit keys are modelled");
+    aes.in_words = 0;
+    Sim_setBits(AES256_BASE + OFS_AESASTAT, AESBUSY);
+    Sim_schedule(&aes.model, Sim_now() + SIM_AES_CYCLES);
+}
+
+static void SimAes_event(SimModel* model)
+{
+    (void) model;
+    SimAes_encrypt(aes.key, aes.in, aes.out);
+    aes.out_words = 0;
+    aes.blocks++;
+    Sim_clearBits(AES256_BASE + OFS_AESASTAT, AESBUSY);
+    Sim_setBits(AES256_BASE + OFS_AESACTL0, AESRDYIFG);
+}
+
+static void SimAes_read(SimModel* model, uint16_t offset)
+{
+    uint8_t* out = aes.out + 2 * aes.out_words;
+
+    (void) model;
+    if (offset != OFS_AESADOUT)
+        return;
+    Sim_set16(AES256_BASE + OFS_AESADOUT, out[0] | (out[1] << 8));
+    aes.out_words = (aes.out_words + 1) % (SIM_AES_BLOCK_SIZE / 2);
+    Sim_clearBits(AES256_BASE + OFS_AESACTL0, AESRDYIFG);
+}
+
+static void SimAes_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    uint16_t value = Sim_get16(AES256_BASE + offset);
+    uint16_t status;
+
+    (void) model;
+    (void) width;
+    switch (offset) {
+    case OFS_AESACTL0:
+        if (value & AESSWRST) {
+            aes.key_words = 0;
+            aes.in_words = 0;
+            aes.out_words = 0;
+            aes.model.next = SIM_NEVER;
+            Sim_set16(AES256_BASE + OFS_AESACTL0, 0);
+            Sim_set16(AES256_BASE + OFS_AESASTAT, 0);
+        }
+        break;
+    case OFS_AESASTAT:
+        // only AESKEYWR is writable
+        status = (old & ~AESKEYWR) | (value & AESKEYWR);
+        Sim_set16(AES256_BASE + OFS_AESASTAT, status);
+        if ((status & AESKEYWR) && !(status & AESBUSY)
+                && aes.in_words == SIM_AES_BLOCK_SIZE / 2)
+            SimAes_start();
+        break;
+    case OFS_AESAKEY:
+        if (aes.key_words == 0)
+            Sim_clearBits(AES256_BASE + OFS_AESASTAT, AESKEYWR);
+        aes.key[2 * aes.key_words] = value & 0xFF;
+        aes.key[2 * aes.key_words + 1] = value >> 8;
+        Sim_clearBits(AES256_BASE + OFS_AESACTL0, AESRDYIFG);
+        if (++aes.key_words == SIM_AES_KEY_SIZE / 2) {
+            aes.key_words = 0;
+            aes.key_loaded = true;
+            Sim_setBits(AES256_BASE + OFS_AESASTAT, AESKEYWR);
+        }
+        break;
+    case OFS_AESADIN:
+        if (Sim_get16(AES256_BASE + OFS_AESASTAT) & AESBUSY)
+            Sim_fail("AES256: AESADIN written while busy");
+        aes.in[2 * aes.in_words] = value & 0xFF;
+        aes.in[2 * aes.in_words + 1] = value >> 8;
+        aes.in_words++;
+        Sim_clearBits(AES256_BASE + OFS_AESACTL0, AESRDYIFG);
+        if (aes.in_words == SIM_AES_BLOCK_SIZE / 2
+                && (Sim_get16(AES256_BASE + OFS_AESASTAT) & AESKEYWR))
+            SimAes_start();
+        break;
+    }
+}
+
+bool SimAes_key(uint8_t key[SIM_AES_KEY_SIZE])
+{
+    memcpy(key, aes.key, SIM_AES_KEY_SIZE);
+    return aes.key_loaded;
+}
+
+void SimAes_init(void)
+{
+    // FIPS-197 appendix C.3
+    static const uint8_t expected[SIM_AES_BLOCK_SIZE] = {
+        0x8E, 0xA2, 0xB7, 0xCA, 0x51, 0x67, 0x45, 0xBF,
+        0xEA, 0xFC, 0x49, 0x90, 0x4B, 0x49, 0x60, 0x89
+    };
+    uint8_t key[SIM_AES_KEY_SIZE];
+    uint8_t in[SIM_AES_BLOCK_SIZE];
+    uint8_t out[SIM_AES_BLOCK_SIZE];
+    uint8_t i;
+
+    for (i = 0; i < SIM_AES_KEY_SIZE; i++)
+        key[i] = i;
+    for (i = 0; i < SIM_AES_BLOCK_SIZE; i++)
+        in[i] = 0x11 * i;
+    SimAes_encrypt(key, in, out);
+    if (memcmp(out, expected, SIM_AES_BLOCK_SIZE))
+        Sim_fail("AES256: software cipher fails FIPS-197 C.3");
+
+    aes.model.name = "AES256";
+    aes.model.base = AES256_BASE;
+    aes.model.size = 0x10;
+    aes.model.read = SimAes_read;
+    aes.model.write = SimAes_write;
+    aes.model.event = SimAes_event;
+    Sim_addModel(&aes.model);
+}
+
+void SimAes_report(void)
+{
+    if (aes.blocks)
+        printf("AES256 %lu blocks encrypted\n", (unsigned long) aes.blocks);
+}
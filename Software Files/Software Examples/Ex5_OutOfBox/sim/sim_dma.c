@@ -0,0 +1,189 @@
+/*
+ * sim_dma.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+
+// DMA controller, single and block transfer mode with edge triggers, byte
+// or word units. A trigger, or DMAREQ, queues one transfer on each enabled
+// channel that selects it, in block mode the whole block; each transfer
+// takes SIM_DMA_CYCLES. The CPU is not halted during a block, it has to
+// wait for DMAIFG. Source and destination may be host pointers (see
+// Sim_load8), so the build has to keep static data below 4 GB (-no-pie).
+
+#define SIM_DMA_CHANNELS (6)
+#define SIM_DMA_CYCLES (2)
+
+typedef struct {
+    uint32_t source;
+    uint32_t destination;
+    uint16_t size;
+    uint16_t requests;
+} SimDmaChannel;
+
+static struct {
+    SimModel model;
+    SimDmaChannel channel[SIM_DMA_CHANNELS];
+    uint32_t transfers;
+} dma;
+
+static uint16_t SimDma_ctl(uint8_t channel)
+{
+    return DMA_BASE + OFS_DMA0CTL + 0x10 * channel;
+}
+
+static uint32_t SimDma_get32(uint16_t address)
+{
+    return Sim_get16(address) | ((uint32_t) Sim_get16(address + 2) << 16);
+}
+
+static uint8_t SimDma_triggerSelect(uint8_t channel)
+{
+    uint16_t ctl = Sim_get16(DMA_BASE + OFS_DMACTL0 + 2 * (channel / 2));
+    return ((channel & 1) ? ctl >> 8 : ctl) & 0x1F;
+}
+
+static uint32_t SimDma_step(uint32_t address, uint16_t increment,
+        bool byte)
+{
+    switch (increment & DMASRCINCR_3) {
+    case 0x0200:
+        return address - (byte ? 1 : 2);
+    case DMASRCINCR_3:
+        return address + (byte ? 1 : 2);
+    default:
+        return address;
+    }
+}
+
+// Queues one trigger on channel i
+static void SimDma_request(uint8_t i)
+{
+    if ((Sim_get16(SimDma_ctl(i)) & DMADT_7) == DMADT_1)
+        dma.channel[i].requests += dma.channel[i].size;
+    else
+        dma.channel[i].requests++;
+}
+
+static void SimDma_reschedule(void)
+{
+    uint8_t i;
+    for (i = 0; i < SIM_DMA_CHANNELS; i++) {
+        if (dma.channel[i].requests) {
+            if (dma.model.next == SIM_NEVER)
+                Sim_schedule(&dma.model, Sim_now() + SIM_DMA_CYCLES);
+            return;
+        }
+    }
+}
+
+static void SimDma_event(SimModel* model)
+{
+    uint8_t i;
+
+    (void) model;
+    for (i = 0; i < SIM_DMA_CHANNELS; i++) {
+        SimDmaChannel* channel = &dma.channel[i];
+        uint16_t ctl = SimDma_ctl(i);
+        uint16_t value, data;
+
+        if (channel->requests == 0)
+            continue;
+        channel->requests--;
+        value = Sim_get16(ctl);
+        if (!(value & DMAEN))
+            continue;
+        data = (value & DMASRCBYTE) ? Sim_load8(channel->source)
+                : Sim_load16(channel->source);
+        if (value & DMADSTBYTE)
+            Sim_store8(channel->destination, data & 0xFF);
+        else
+            Sim_store16(channel->destination, data);
+        dma.transfers++;
+        channel->source = SimDma_step(channel->source, value,
+                value & DMASRCBYTE);
+        channel->destination = SimDma_step(channel->destination, value >> 2,
+                value & DMADSTBYTE);
+        if (--channel->size == 0) {
+            // single and block transfer mode: reload the size, stop,
+            // interrupt
+            channel->size = Sim_get16(ctl + OFS_DMA0SZ - OFS_DMA0CTL);
+            channel->requests = 0;
+            Sim_clearBits(ctl, DMAEN);
+            Sim_setBits(ctl, DMAIFG);
+        }
+        break;
+    }
+    SimDma_reschedule();
+}
+
+static void SimDma_read(SimModel* model, uint16_t offset)
+{
+    uint8_t i;
+
+    (void) model;
+    if (offset != OFS_DMAIV)
+        return;
+    for (i = 0; i < SIM_DMA_CHANNELS; i++) {
+        uint16_t ctl = SimDma_ctl(i);
+        if ((Sim_get16(ctl) & DMAIE) && (Sim_get16(ctl) & DMAIFG)) {
+            Sim_clearBits(ctl, DMAIFG);
+            Sim_set16(DMA_BASE + OFS_DMAIV, 2 * (i + 1));
+            return;
+        }
+    }
+    Sim_set16(DMA_BASE + OFS_DMAIV, 0);
+}
+
+static void SimDma_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    uint16_t value = Sim_get16(DMA_BASE + offset);
+    uint8_t i;
+
+    (void) model;
+    (void) width;
+    if (offset < OFS_DMA0CTL || ((offset - OFS_DMA0CTL) & 0xF) != 0)
+        return;
+    i = (offset - OFS_DMA0CTL) >> 4;
+    if (i >= SIM_DMA_CHANNELS)
+        return;
+    if ((value & DMAEN) && !(old & DMAEN)) {
+        // enabling copies the addresses and size into the working registers
+        uint16_t ctl = SimDma_ctl(i);
+        dma.channel[i].source = SimDma_get32(ctl + OFS_DMA0SA - OFS_DMA0CTL);
+        dma.channel[i].destination = SimDma_get32(ctl + OFS_DMA0DA
+                - OFS_DMA0CTL);
+        dma.channel[i].size = Sim_get16(ctl + OFS_DMA0SZ - OFS_DMA0CTL);
+        dma.channel[i].requests = 0;
+    }
+    if (value & DMAREQ) {
+        Sim_clearBits(SimDma_ctl(i), DMAREQ);
+        SimDma_request(i);
+        SimDma_reschedule();
+    }
+}
+
+void SimDma_trigger(uint8_t trigger)
+{
+    uint8_t i;
+
+    for (i = 3; i < SIM_DMA_CHANNELS; i++) {
+        if ((Sim_get16(SimDma_ctl(i)) & DMAEN)
+                && SimDma_triggerSelect(i) == trigger)
+            SimDma_request(i);
+    }
+    SimDma_reschedule();
+}
+
+void SimDma_init(void)
+{
+    dma.model.name = "DMA";
+    dma.model.base = DMA_BASE;
+    dma.model.size = 0x70;
+    dma.model.read = SimDma_read;
+    dma.model.write = SimDma_write;
+    dma.model.event = SimDma_event;
+    Sim_addModel(&dma.model);
+}
@@ -0,0 +1,413 @@
+/*
+ * sim_esp32.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+#include "codec/delta.h"
+#include "crc/crc_soft.h"
+#include <stdio.h>
+#include <string.h>
+
+// The ESP32 on UCA3 and the terminal on UCA0, as far as the firmware can
+// tell. AT lines are echoed and answered "OK"; binary frames are checked
+// like ESP32Firmware/frame.cpp and answered "OK <seq>", "ERR <seq>: Bad
+// frame" or, while the link is down, "ERR <seq>: No wifi". A frame sent
+// again after its answer was lost is answered "OK <seq>" and not counted
+// twice. Answers go out after SIM_ESP32_LATENCY. Configuration lines set with SimEsp32_config follow
+// answers, like settings the ESP32 forwards from the cloud. They are
+// SIM_CONFIG_GAP apart since the firmware takes one per report cycle.
+//
+// Encrypted frames (-DAES_CTR) are decrypted with the key the firmware
+// loaded into the AES256 module, standing in for the cloud side, and then
+// checked like plain ones.
+//
+// With a trace file every reading the ESP32 accepts is written to it as
+// "seconds,channel,value", seconds being when the reading was taken.
+//
+// SimEsp32_loss garbles one byte of every corrupt-th frame on the wire and
+// loses the answer to every drop-th frame, for the firmware's
+// retransmissions.
+
+#define SIM_ESP32_LATENCY   SIM_CYCLES_MS(2)
+#define SIM_ESP32_LINE_MAX  (128)
+#define SIM_FRAME_SYNC      (0xA5)
+#define SIM_FRAME_MIN       (2 + 4 + 2)
+#define SIM_FRAME_AGED      (2 + 4 + 4 + 2)
+#define SIM_FRAME_SUMMARY   (2 + 4 + 10 + 2)
+#define SIM_FRAME_BLOCK     (0x80)
+#define SIM_FRAME_ENCRYPTED (0x40)
+#define SIM_FRAME_MAX       (2 + 3 + 96 + 2 + 5)
+#define SIM_BLOCK_MAX       (32)
+#define SIM_CHANNELS        (4)
+#define SIM_CONFIG_MAX      (8)
+#define SIM_CONFIG_GAP      SIM_CYCLES_MS(5000)
+// frames accepted last, for telling retransmissions apart
+#define SIM_RECENT          (16)
+
+static struct {
+    SimUart* uart;
+    SimUart* console;
+    uint64_t offline_from;
+    uint64_t offline_until;
+    bool echo;
+    char line[SIM_ESP32_LINE_MAX];
+    uint8_t line_length;
+    const char* config[SIM_CONFIG_MAX];
+    uint8_t config_count;
+    uint8_t config_sent;
+    uint64_t config_time;
+    FILE* trace;
+    uint8_t frame[SIM_FRAME_MAX];
+    uint8_t frame_length;
+    uint16_t recent[SIM_RECENT];   // SEQ << 8 | CRC_L of accepted frames
+    bool recent_valid[SIM_RECENT];
+    uint8_t recent_next;
+    uint32_t corrupt;
+    uint32_t drop;
+    uint32_t received;
+    // statistics
+    uint32_t commands;
+    uint32_t frames;
+    uint32_t aged;
+    uint32_t summaries;
+    uint32_t blocks;
+    uint32_t encrypted;
+    uint32_t bad_frames;
+    uint32_t refused;
+    uint32_t duplicates;
+    uint32_t corrupted;
+    uint32_t dropped;
+    uint32_t channel[SIM_CHANNELS];
+    uint32_t console_bytes;
+} esp32;
+
+static void SimEsp32_reply(const char* text)
+{
+    const char* config;
+
+    SimUart_input(esp32.uart, (const uint8_t*) text, strlen(text),
+            SIM_ESP32_LATENCY);
+    if (esp32.config_sent == esp32.config_count
+            || (esp32.config_sent > 0
+                    && Sim_now() - esp32.config_time < SIM_CONFIG_GAP))
+        return;
+    config = esp32.config[esp32.config_sent++];
+    esp32.config_time = Sim_now();
+    SimUart_input(esp32.uart, (const uint8_t*) config, strlen(config),
+            SIM_ESP32_LATENCY);
+    SimUart_input(esp32.uart, (const uint8_t*) "\r\n", 2, SIM_ESP32_LATENCY);
+}
+
+// The answer to the frame in esp32.frame, "OK" or "ERR: <reason>" with the
+// SEQ put in
+static void SimEsp32_answer(const char* text)
+{
+    char reply[48];
+
+    if (esp32.drop && esp32.received % esp32.drop == 0) {
+        esp32.dropped++;
+        return;
+    }
+    if (text[0] == 'O')
+        snprintf(reply, sizeof(reply), "OK %u\r\n", esp32.frame[3]);
+    else
+        snprintf(reply, sizeof(reply), "ERR %u%s\r\n", esp32.frame[3],
+                text + 3);
+    SimEsp32_reply(reply);
+}
+
+// true if the frame was accepted before, its answer must have been lost
+static bool SimEsp32_duplicate(uint16_t id)
+{
+    uint8_t i;
+
+    for (i = 0; i < SIM_RECENT; i++) {
+        if (esp32.recent_valid[i] && esp32.recent[i] == id)
+            return true;
+    }
+    return false;
+}
+
+static bool SimEsp32_online(void)
+{
+    uint64_t now = Sim_now();
+    return now < esp32.offline_from || now >= esp32.offline_until;
+}
+
+static uint32_t SimEsp32_read32(const uint8_t data[])
+{
+    return data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16)
+            | ((uint32_t) data[3] << 24);
+}
+
+// One accepted reading, age seconds old
+static void SimEsp32_reading(uint8_t channel, uint16_t value, uint32_t age)
+{
+    double now = (double) Sim_now() / SIM_MCLK_HZ;
+
+    esp32.channel[channel]++;
+    if (age)
+        esp32.aged++;
+    if (esp32.trace)
+        fprintf(esp32.trace, "%.3f,%u,%u\n", now - age, channel, value);
+}
+
+// Decodes the records of a block frame like ESP32Firmware/frame.cpp.
+// Returns the number of records, -1 if the block is malformed.
+static int SimEsp32_block(const uint8_t frame[], uint8_t channels[],
+        uint16_t values[], uint32_t ages[])
+{
+    DeltaState value[SIM_CHANNELS];
+    DeltaState age;
+    uint16_t end = esp32.frame_length - 2;
+    uint16_t position = 5;
+    uint32_t decoded;
+    uint8_t i;
+
+    if (frame[4] > SIM_BLOCK_MAX)
+        return -1;
+    for (i = 0; i < SIM_CHANNELS; i++)
+        Delta_init(&value[i]);
+    Delta_init(&age);
+    for (i = 0; i < frame[4]; i++) {
+        if (position >= end || frame[position] >= SIM_CHANNELS)
+            return -1;
+        channels[i] = frame[position++];
+        if (!Delta_get(&value[channels[i]], &decoded, frame, &position, end))
+            return -1;
+        values[i] = decoded;
+        if (!Delta_get(&age, &ages[i], frame, &position, end))
+            return -1;
+    }
+    return position == end ? frame[4] : -1;
+}
+
+// Decrypts the frame in place and moves it back to the plain layout, see
+// uart/frame.h. Returns false if the firmware has not loaded a key.
+static bool SimEsp32_decrypt(void)
+{
+    uint8_t* frame = esp32.frame;
+    uint32_t position = SimEsp32_read32(frame + 4);
+    uint8_t length = esp32.frame_length - 8 - 2;
+    uint8_t key[SIM_AES_KEY_SIZE];
+    uint8_t counter[SIM_AES_BLOCK_SIZE];
+    uint8_t stream[SIM_AES_BLOCK_SIZE];
+    uint32_t index;
+    uint8_t i;
+
+    if (!SimAes_key(key))
+        return false;
+    for (i = 0; i < length; i++, position++) {
+        if (i == 0 || position % SIM_AES_BLOCK_SIZE == 0) {
+            index = position / SIM_AES_BLOCK_SIZE;
+            memset(counter, 0, sizeof(counter));
+            counter[12] = index >> 24;
+            counter[13] = index >> 16;
+            counter[14] = index >> 8;
+            counter[15] = index;
+            SimAes_encrypt(key, counter, stream);
+        }
+        frame[8 + i] ^= stream[position % SIM_AES_BLOCK_SIZE];
+    }
+    frame[2] = frame[8];
+    memmove(frame + 4, frame + 9, length - 1);
+    esp32.frame_length -= 5;
+    esp32.encrypted++;
+    return true;
+}
+
+static void SimEsp32_frame(void)
+{
+    uint8_t* frame = esp32.frame;
+    uint8_t crc_offset = esp32.frame_length - 2;
+    double now = (double) Sim_now() / SIM_MCLK_HZ;
+    uint8_t channels[SIM_BLOCK_MAX];
+    uint16_t values[SIM_BLOCK_MAX];
+    uint32_t ages[SIM_BLOCK_MAX];
+    uint16_t id = frame[3] << 8 | frame[crc_offset];
+    int count = 1;
+    int i;
+
+    esp32.received++;
+    if (esp32.corrupt && esp32.received % esp32.corrupt == 0) {
+        esp32.corrupted++;
+        frame[crc_offset - 1] ^= 0x10;
+    }
+    if (CrcSoft_crc16(frame, crc_offset)
+            != (frame[crc_offset] | (frame[crc_offset + 1] << 8))) {
+        esp32.bad_frames++;
+        SimEsp32_answer("ERR: Bad frame");
+        return;
+    }
+    if (SimEsp32_duplicate(id)) {
+        esp32.duplicates++;
+        SimEsp32_answer("OK");
+        return;
+    }
+    if (frame[2] == SIM_FRAME_ENCRYPTED && !SimEsp32_decrypt()) {
+        esp32.bad_frames++;
+        SimEsp32_answer("ERR: Bad frame");
+        return;
+    }
+    if (frame[2] == SIM_FRAME_BLOCK) {
+        count = SimEsp32_block(frame, channels, values, ages);
+        if (count < 0) {
+            esp32.bad_frames++;
+            SimEsp32_answer("ERR: Bad frame");
+            return;
+        }
+    } else if (frame[2] >= SIM_CHANNELS) {
+        SimEsp32_answer("ERR: Unknown channel");
+        return;
+    } else {
+        channels[0] = frame[2];
+        values[0] = frame[4] | (frame[5] << 8);
+        ages[0] = 0;
+        if (esp32.frame_length == SIM_FRAME_AGED)
+            ages[0] = SimEsp32_read32(frame + 6);
+    }
+    if (esp32.echo && esp32.frame_length == SIM_FRAME_SUMMARY)
+        printf("[%.3f] summary channel %u seq %u mean %u min %u max %u"
+                " count %u variance %lu\n", now, frame[2], frame[3],
+                values[0], frame[6] | (frame[7] << 8),
+                frame[8] | (frame[9] << 8), frame[10] | (frame[11] << 8),
+                (unsigned long) SimEsp32_read32(frame + 12));
+    else if (esp32.echo && frame[2] == SIM_FRAME_BLOCK)
+        printf("[%.3f] block seq %u, %d readings in %u bytes\n", now,
+                frame[3], count, esp32.frame_length);
+    if (esp32.echo && esp32.frame_length != SIM_FRAME_SUMMARY) {
+        for (i = 0; i < count; i++)
+            printf("[%.3f] frame channel %u seq %u value %u age %lu\n", now,
+                    channels[i], frame[3], values[i], (unsigned long) ages[i]);
+    }
+    if (!SimEsp32_online()) {
+        esp32.refused++;
+        SimEsp32_answer("ERR: No wifi");
+        return;
+    }
+    esp32.recent[esp32.recent_next] = id;
+    esp32.recent_valid[esp32.recent_next] = true;
+    esp32.recent_next = (esp32.recent_next + 1) % SIM_RECENT;
+    esp32.frames++;
+    if (esp32.frame_length == SIM_FRAME_SUMMARY)
+        esp32.summaries++;
+    if (frame[2] == SIM_FRAME_BLOCK)
+        esp32.blocks++;
+    for (i = 0; i < count; i++)
+        SimEsp32_reading(channels[i], values[i], ages[i]);
+    SimEsp32_answer("OK");
+}
+
+static void SimEsp32_command(void)
+{
+    char reply[SIM_ESP32_LINE_MAX + 16];
+
+    esp32.line[esp32.line_length] = '\0';
+    esp32.line_length = 0;
+    esp32.commands++;
+    if (esp32.echo)
+        printf("[%.3f] %s\n", (double) Sim_now() / SIM_MCLK_HZ, esp32.line);
+    if (!strncmp(esp32.line, "AT+telemetry=", 13)
+            || !strncmp(esp32.line, "AT+batch=", 9)) {
+        if (!SimEsp32_online()) {
+            esp32.refused++;
+            snprintf(reply, sizeof(reply), "%s\r\nERR: No wifi\r\n",
+                    esp32.line);
+            SimEsp32_reply(reply);
+            return;
+        }
+    }
+    snprintf(reply, sizeof(reply), "%s\r\nOK\r\n", esp32.line);
+    SimEsp32_reply(reply);
+}
+
+// UCA3 transmit: one byte from the MSP430
+static void SimEsp32_receive(SimUart* uart, uint8_t data)
+{
+    (void) uart;
+    // a sync byte between commands starts a binary frame
+    if (esp32.frame_length > 0
+            || (data == SIM_FRAME_SYNC && esp32.line_length == 0)) {
+        esp32.frame[esp32.frame_length++] = data;
+        if (esp32.frame_length == 2 && (data < SIM_FRAME_MIN - 2
+                || data > SIM_FRAME_MAX - 2)) {
+            // not a frame header, resynchronize on the next sync byte
+            esp32.frame_length = 0;
+        } else if (esp32.frame_length > 2
+                && esp32.frame_length == 2 + esp32.frame[1]) {
+            SimEsp32_frame();
+            esp32.frame_length = 0;
+        }
+        return;
+    }
+    if (data == '\r') {
+        SimEsp32_command();
+    } else if (data == '\n' && esp32.line_length == 0) {
+        // line feed left over from a CR LF terminator
+    } else if (esp32.line_length < SIM_ESP32_LINE_MAX - 1) {
+        esp32.line[esp32.line_length++] = data;
+    }
+}
+
+// UCA0 transmit: the terminal
+static void SimEsp32_console(SimUart* uart, uint8_t data)
+{
+    (void) uart;
+    esp32.console_bytes++;
+    if (esp32.echo)
+        putchar(data);
+}
+
+void SimEsp32_init(uint64_t offline_from, uint64_t offline_until, bool echo)
+{
+    esp32.offline_from = offline_from;
+    esp32.offline_until = offline_until;
+    esp32.echo = echo;
+    esp32.console = SimUart_init(EUSCI_A0_BASE, "UCA0", SimEsp32_console);
+    esp32.uart = SimUart_init(EUSCI_A3_BASE, "UCA3", SimEsp32_receive);
+}
+
+void SimEsp32_config(const char* line)
+{
+    if (esp32.config_count < SIM_CONFIG_MAX)
+        esp32.config[esp32.config_count++] = line;
+}
+
+void SimEsp32_trace(FILE* trace)
+{
+    esp32.trace = trace;
+}
+
+void SimEsp32_loss(uint32_t corrupt, uint32_t drop)
+{
+    esp32.corrupt = corrupt;
+    esp32.drop = drop;
+}
+
+void SimEsp32_report(void)
+{
+    uint8_t i;
+
+    printf("ESP32 %lu AT lines, %lu frames (%lu blocks, %lu summaries),"
+            " %lu replayed readings, %lu bad, %lu refused offline\n",
+            (unsigned long) esp32.commands, (unsigned long) esp32.frames,
+            (unsigned long) esp32.blocks, (unsigned long) esp32.summaries,
+            (unsigned long) esp32.aged,
+            (unsigned long) esp32.bad_frames, (unsigned long) esp32.refused);
+    if (esp32.corrupt || esp32.drop || esp32.duplicates)
+        printf("ESP32 %lu frames garbled, %lu answers lost, %lu frames"
+                " received again\n", (unsigned long) esp32.corrupted,
+                (unsigned long) esp32.dropped,
+                (unsigned long) esp32.duplicates);
+    if (esp32.encrypted)
+        printf("ESP32 %lu frames decrypted\n",
+                (unsigned long) esp32.encrypted);
+    printf("ESP32 readings per channel:");
+    for (i = 0; i < SIM_CHANNELS; i++)
+        printf(" %lu", (unsigned long) esp32.channel[i]);
+    printf("\n");
+    SimUart_report(esp32.uart);
+    SimUart_report(esp32.console);
+    printf("console %lu bytes\n", (unsigned long) esp32.console_bytes);
+}
@@ -0,0 +1,390 @@
+/*
+ * sim_i2c.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+#include <stdio.h>
+
+// eUSCI_B2 as I2C master with one slave on the bus, an SHT35 at 0x45.
+//
+// A START sends the address (9 bit times); the slave ACKs or the master
+// sets NACKIFG and waits for UCTXSTP. Transmit: TXIFG0 comes up with the
+// START and whenever TXBUF moves into the shift register; with nothing to
+// send the master holds SCL until TXBUF, UCTXSTP or UCTXSTT is written.
+// Receive: each byte sets RXIFG0, the next one is only clocked in once
+// RXBUF was read, and UCTXSTP set by then makes it the last (NACK, STOP).
+
+#define SIM_SHT35_ADDRESS (0x45)
+
+typedef enum {
+    I2C_IDLE,
+    I2C_ADDRESS,                // START and address going out
+    I2C_TRANSMIT,               // byte shifting out
+    I2C_TRANSMIT_HOLD,          // waiting for TXBUF, STOP or START
+    I2C_RECEIVE,                // byte shifting in
+    I2C_RECEIVE_HOLD,           // waiting for RXBUF to be read
+    I2C_NACK,                   // waiting for STOP after a NACK
+    I2C_STOP                    // STOP going out
+} SimI2cState;
+
+static struct {
+    SimModel model;
+    SimI2cState state;
+    bool loaded;                // TXBUF written, not shifted yet
+    uint8_t shift;
+    uint32_t transactions;
+    uint32_t nacks;
+    uint32_t bytes;
+} i2c;
+
+// SHT35: single shot and periodic measurements, fetch, no clock stretching
+static struct {
+    double temperature;
+    double humidity;
+    uint8_t command[2];
+    uint8_t command_length;
+    uint64_t ready;             // single shot result time, SIM_NEVER if none
+    uint64_t period;            // periodic mode, 0 when off
+    uint64_t periodic_start;
+    uint64_t fetched;           // measurement number last fetched
+    bool fetch;
+    uint8_t data[6];
+    uint8_t data_index;
+    bool reading;
+    uint32_t measurements;
+} sht35 = { .temperature = 25.0, .humidity = 50.0 };
+
+static uint16_t SimI2c_reg(uint16_t offset)
+{
+    return EUSCI_B2_BASE + offset;
+}
+
+//*****************************************************************************
+// SHT35
+//*****************************************************************************
+static uint8_t SimSht35_crc(const uint8_t data[2])
+{
+    uint8_t crc = 0xFF;
+    uint8_t i, bit;
+
+    for (i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+static void SimSht35_measure(void)
+{
+    double t = (sht35.temperature + 45.0) / 175.0 * 65535.0;
+    double rh = sht35.humidity / 100.0 * 65535.0;
+    uint16_t raw_t = t < 0 ? 0 : t > 65535 ? 65535 : (uint16_t) (t + 0.5);
+    uint16_t raw_rh = rh < 0 ? 0 : rh > 65535 ? 65535 : (uint16_t) (rh + 0.5);
+
+    sht35.data[0] = raw_t >> 8;
+    sht35.data[1] = raw_t & 0xFF;
+    sht35.data[2] = SimSht35_crc(&sht35.data[0]);
+    sht35.data[3] = raw_rh >> 8;
+    sht35.data[4] = raw_rh & 0xFF;
+    sht35.data[5] = SimSht35_crc(&sht35.data[3]);
+    sht35.measurements++;
+}
+
+// Datasheet maximum measurement time for the repeatability code
+static uint64_t SimSht35_duration(uint8_t lsb)
+{
+    switch (lsb) {
+    case 0x00: case 0x06: case 0x32: case 0x30: case 0x34: case 0x37:
+    case 0x36: case 0x0D: case 0x1D: case 0x27: case 0x26: case 0x2B:
+        return SIM_CYCLES_MS(16);
+    case 0x0B: case 0x10: case 0x24: case 0x21: case 0x2F: case 0x23:
+        return SIM_CYCLES_MS(7);
+    default:
+        return SIM_CYCLES_MS(5);
+    }
+}
+
+static void SimSht35_command(void)
+{
+    uint8_t msb = sht35.command[0];
+    uint8_t lsb = sht35.command[1];
+    static const uint32_t periods_ms[8] = {
+        2000, 1000, 500, 250, 0, 0, 0, 100
+    };
+
+    if (sht35.command_length != 2)
+        return;
+    sht35.command_length = 0;
+    if (msb == 0x24 || msb == 0x2C) {
+        sht35.period = 0;
+        sht35.ready = Sim_now() + SimSht35_duration(lsb);
+        sht35.fetch = false;
+    } else if (msb >= 0x20 && msb <= 0x27 && periods_ms[msb - 0x20]) {
+        sht35.period = SIM_CYCLES_MS(periods_ms[msb - 0x20]);
+        sht35.periodic_start = Sim_now() + SimSht35_duration(lsb);
+        sht35.fetched = 0;
+        sht35.ready = SIM_NEVER;
+    } else if (msb == 0xE0 && lsb == 0x00) {
+        sht35.fetch = true;
+    } else if ((msb == 0x30 && lsb == 0x93) || (msb == 0x30 && lsb == 0xA2)) {
+        // break, soft reset
+        sht35.period = 0;
+        sht35.ready = SIM_NEVER;
+    }
+}
+
+// Address phase of a read, true if the sensor has data (ACK)
+static bool SimSht35_startRead(void)
+{
+    uint64_t now = Sim_now();
+
+    sht35.reading = false;
+    if (sht35.period) {
+        uint64_t count;
+        if (!sht35.fetch || now < sht35.periodic_start)
+            return false;
+        count = (now - sht35.periodic_start) / sht35.period + 1;
+        if (count == sht35.fetched)
+            return false;
+        sht35.fetched = count;
+        sht35.fetch = false;
+    } else {
+        if (sht35.ready == SIM_NEVER || now < sht35.ready)
+            return false;
+        sht35.ready = SIM_NEVER;
+    }
+    SimSht35_measure();
+    sht35.data_index = 0;
+    sht35.reading = true;
+    return true;
+}
+
+void SimSht35_set(double temperature, double humidity)
+{
+    sht35.temperature = temperature;
+    sht35.humidity = humidity;
+}
+
+//*****************************************************************************
+// eUSCI_B2
+//*****************************************************************************
+static uint64_t SimI2c_bit(void)
+{
+    uint16_t brw = Sim_get16(SimI2c_reg(OFS_UCBxBRW));
+    return brw ? brw : 1;
+}
+
+static void SimI2c_after(SimI2cState state, uint16_t bits)
+{
+    i2c.state = state;
+    Sim_schedule(&i2c.model, Sim_now() + bits * SimI2c_bit());
+}
+
+static void SimI2c_hold(SimI2cState state)
+{
+    i2c.state = state;
+    Sim_schedule(&i2c.model, SIM_NEVER);
+}
+
+static void SimI2c_start(void)
+{
+    uint16_t ctl = Sim_get16(SimI2c_reg(OFS_UCBxCTLW0));
+
+    if (i2c.state == I2C_IDLE)
+        i2c.transactions++;
+    else
+        sht35.command_length == 2 ? SimSht35_command() : (void) 0;
+    Sim_setBits(SimI2c_reg(OFS_UCBxSTATW), UCBBUSY);
+    if (ctl & UCTR)
+        Sim_setBits(SimI2c_reg(OFS_UCBxIFG), UCTXIFG0);
+    // START plus address and ACK
+    SimI2c_after(I2C_ADDRESS, 10);
+}
+
+static void SimI2c_sendNext(void)
+{
+    i2c.shift = Sim_get16(SimI2c_reg(OFS_UCBxTXBUF));
+    i2c.loaded = false;
+    Sim_setBits(SimI2c_reg(OFS_UCBxIFG), UCTXIFG0);
+    SimI2c_after(I2C_TRANSMIT, 9);
+}
+
+// What the master does once a byte or the address is through and nothing
+// is in flight
+static void SimI2c_continue(void)
+{
+    uint16_t ctl = Sim_get16(SimI2c_reg(OFS_UCBxCTLW0));
+
+    if (ctl & UCTXSTT) {
+        SimI2c_start();
+    } else if (ctl & UCTXSTP) {
+        SimI2c_after(I2C_STOP, 1);
+    } else if (ctl & UCTR) {
+        if (i2c.loaded)
+            SimI2c_sendNext();
+        else
+            SimI2c_hold(I2C_TRANSMIT_HOLD);
+    } else if (Sim_get16(SimI2c_reg(OFS_UCBxIFG)) & UCRXIFG0) {
+        SimI2c_hold(I2C_RECEIVE_HOLD);
+    } else {
+        SimI2c_after(I2C_RECEIVE, 9);
+    }
+}
+
+static void SimI2c_event(SimModel* model)
+{
+    uint16_t ctlw0 = SimI2c_reg(OFS_UCBxCTLW0);
+    uint16_t ifg = SimI2c_reg(OFS_UCBxIFG);
+    uint16_t ctl = Sim_get16(ctlw0);
+    uint8_t address = Sim_get16(SimI2c_reg(OFS_UCBxI2CSA)) & 0x7F;
+    bool ack;
+
+    (void) model;
+    switch (i2c.state) {
+    case I2C_ADDRESS:
+        Sim_clearBits(ctlw0, UCTXSTT);
+        if (address != SIM_SHT35_ADDRESS)
+            ack = false;
+        else if (ctl & UCTR)
+            ack = true;
+        else
+            ack = SimSht35_startRead();
+        sht35.command_length = 0;
+        if (!ack) {
+            i2c.nacks++;
+            Sim_clearBits(ifg, UCTXIFG0);
+            Sim_setBits(ifg, UCNACKIFG);
+            if (ctl & UCTXSTP)
+                SimI2c_after(I2C_STOP, 1);
+            else
+                SimI2c_hold(I2C_NACK);
+        } else if (ctl & UCTR) {
+            // the first byte may already be waiting
+            if (i2c.loaded)
+                SimI2c_sendNext();
+            else
+                SimI2c_continue();
+        } else {
+            SimI2c_after(I2C_RECEIVE, 9);
+        }
+        break;
+    case I2C_TRANSMIT:
+        i2c.bytes++;
+        if (sht35.command_length < 2)
+            sht35.command[sht35.command_length++] = i2c.shift;
+        if (i2c.loaded)
+            SimI2c_sendNext();
+        else
+            SimI2c_continue();
+        break;
+    case I2C_RECEIVE:
+        i2c.bytes++;
+        Sim_set16(SimI2c_reg(OFS_UCBxRXBUF),
+                sht35.reading && sht35.data_index < 6 ?
+                        sht35.data[sht35.data_index++] : 0xFF);
+        Sim_setBits(ifg, UCRXIFG0);
+        if (ctl & UCTXSTP)
+            SimI2c_after(I2C_STOP, 1);
+        else
+            SimI2c_hold(I2C_RECEIVE_HOLD);
+        break;
+    case I2C_STOP:
+        SimSht35_command();
+        sht35.reading = false;
+        Sim_clearBits(ctlw0, UCTXSTP);
+        Sim_clearBits(SimI2c_reg(OFS_UCBxSTATW), UCBBUSY);
+        Sim_setBits(ifg, UCSTPIFG);
+        i2c.state = I2C_IDLE;
+        break;
+    default:
+        break;
+    }
+}
+
+static void SimI2c_read(SimModel* model, uint16_t offset)
+{
+    uint16_t ifg = SimI2c_reg(OFS_UCBxIFG);
+    uint16_t pending;
+    static const uint16_t order[] = {
+        UCALIFG, UCNACKIFG, 0x0004, UCSTPIFG, 0x1000, 0x2000, 0x0400, 0x0800,
+        0x0100, 0x0200, UCRXIFG0, UCTXIFG0, UCBCNTIFG, UCCLTOIFG, UCBIT9IFG
+    };
+    uint8_t i;
+
+    (void) model;
+    if (offset == OFS_UCBxRXBUF) {
+        Sim_clearBits(ifg, UCRXIFG0);
+        if (i2c.state == I2C_RECEIVE_HOLD)
+            SimI2c_continue();
+    } else if (offset == OFS_UCBxIV) {
+        pending = Sim_get16(ifg) & Sim_get16(SimI2c_reg(OFS_UCBxIE));
+        for (i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+            if (pending & order[i]) {
+                Sim_clearBits(ifg, order[i]);
+                Sim_set16(SimI2c_reg(OFS_UCBxIV), 2 * (i + 1));
+                return;
+            }
+        }
+        Sim_set16(SimI2c_reg(OFS_UCBxIV), USCI_NONE);
+    }
+}
+
+static void SimI2c_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    uint16_t ctl = Sim_get16(SimI2c_reg(OFS_UCBxCTLW0));
+
+    (void) model;
+    (void) width;
+    switch (offset) {
+    case OFS_UCBxCTLW0:
+        if (ctl & UCSWRST) {
+            if (!(old & UCSWRST)) {
+                // reset: bus released, flags and enables cleared
+                i2c.state = I2C_IDLE;
+                i2c.loaded = false;
+                Sim_schedule(&i2c.model, SIM_NEVER);
+                Sim_set16(SimI2c_reg(OFS_UCBxIE), 0);
+                Sim_set16(SimI2c_reg(OFS_UCBxIFG), 0);
+                Sim_clearBits(SimI2c_reg(OFS_UCBxSTATW), UCBBUSY);
+            }
+            Sim_clearBits(SimI2c_reg(OFS_UCBxCTLW0), UCTXSTT | UCTXSTP);
+            break;
+        }
+        if ((ctl & UCTXSTT) && !(old & UCTXSTT) && i2c.state == I2C_IDLE)
+            SimI2c_start();
+        else if ((ctl & (UCTXSTT | UCTXSTP)) && (i2c.state == I2C_TRANSMIT_HOLD
+                || i2c.state == I2C_NACK))
+            SimI2c_continue();
+        break;
+    case OFS_UCBxTXBUF:
+        i2c.loaded = true;
+        Sim_clearBits(SimI2c_reg(OFS_UCBxIFG), UCTXIFG0);
+        if (i2c.state == I2C_TRANSMIT_HOLD)
+            SimI2c_sendNext();
+        break;
+    }
+}
+
+void SimI2c_report(void)
+{
+    printf("I2C %lu transactions, %lu bytes, %lu NACKs; SHT35 %lu"
+            " measurements read\n", (unsigned long) i2c.transactions,
+            (unsigned long) i2c.bytes, (unsigned long) i2c.nacks,
+            (unsigned long) sht35.measurements);
+}
+
+void SimI2c_init(void)
+{
+    i2c.model.name = "eUSCI_B2";
+    i2c.model.base = EUSCI_B2_BASE;
+    i2c.model.size = 0x30;
+    i2c.model.read = SimI2c_read;
+    i2c.model.write = SimI2c_write;
+    i2c.model.event = SimI2c_event;
+    Sim_addModel(&i2c.model);
+    Sim_set16(EUSCI_B2_BASE + OFS_UCBxCTLW0, UCSWRST);
+    sht35.ready = SIM_NEVER;
+}
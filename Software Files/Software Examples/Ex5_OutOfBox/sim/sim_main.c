@@ -0,0 +1,117 @@
+/*
+ * sim_main.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// sim_memmap.h renames the firmware's main
+#undef main
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [options]\n"
+            "  --seconds S        simulated run time (default 60)\n"
+            "  --temp C           SHT35 temperature in degrees C (25)\n"
+            "  --humidity RH      SHT35 relative humidity in %% (50)\n"
+            "  --a3 N, --a4 N     ADC input A3 / A4, 12 bit (2000, 1500)\n"
+            "  --noise N          +- noise on the ADC inputs (8)\n"
+            "  --offline A:B      ESP32 link down from A to B seconds\n"
+            "  --config LINE      configuration line the ESP32 sends, e.g.\n"
+            "                     CFG+deadband=2,0,0,0, may be repeated\n"
+            "  --trace FILE       write the readings the ESP32 accepted\n"
+            "  --corrupt N        garble every Nth frame to the ESP32\n"
+            "  --drop N           lose the ESP32's answer to every Nth frame\n"
+            "  --echo             print the UART traffic\n", program);
+    exit(2);
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = 60;
+    double temperature = 25;
+    double humidity = 50;
+    long a3 = 2000;
+    long a4 = 1500;
+    long noise = 8;
+    double offline_from = 0;
+    double offline_until = 0;
+    FILE* trace = 0;
+    long corrupt = 0;
+    long drop = 0;
+    bool echo = false;
+    bool ok;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : 0;
+
+        if (!strcmp(option, "--echo")) {
+            echo = true;
+            continue;
+        }
+        if (value == 0)
+            usage(argv[0]);
+        i++;
+        if (!strcmp(option, "--seconds"))
+            seconds = atof(value);
+        else if (!strcmp(option, "--temp"))
+            temperature = atof(value);
+        else if (!strcmp(option, "--humidity"))
+            humidity = atof(value);
+        else if (!strcmp(option, "--a3"))
+            a3 = atol(value);
+        else if (!strcmp(option, "--a4"))
+            a4 = atol(value);
+        else if (!strcmp(option, "--noise"))
+            noise = atol(value);
+        else if (!strcmp(option, "--offline")
+                && sscanf(value, "%lf:%lf", &offline_from, &offline_until) == 2)
+            ;
+        else if (!strcmp(option, "--corrupt"))
+            corrupt = atol(value);
+        else if (!strcmp(option, "--drop"))
+            drop = atol(value);
+        else if (!strcmp(option, "--config"))
+            SimEsp32_config(value);
+        else if (!strcmp(option, "--trace")) {
+            trace = fopen(value, "w");
+            if (trace == 0) {
+                perror(value);
+                return 1;
+            }
+        }
+        else
+            usage(argv[0]);
+    }
+
+    Sim_init();
+    SimTimer_init();
+    SimDma_init();
+    SimAdc_init();
+    SimI2c_init();
+    SimSystem_init();
+    SimAes_init();
+    SimEsp32_init(offline_from * SIM_MCLK_HZ, offline_until * SIM_MCLK_HZ,
+            echo);
+    SimEsp32_trace(trace);
+    SimEsp32_loss(corrupt, drop);
+    SimAdc_setInput(3, a3, noise);
+    SimAdc_setInput(4, a4, noise);
+    SimSht35_set(temperature, humidity);
+
+    ok = Sim_run(seconds * SIM_MCLK_HZ);
+
+    Sim_report();
+    SimEsp32_report();
+    SimAdc_report();
+    SimI2c_report();
+    SimAes_report();
+    if (trace)
+        fclose(trace);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+/*
+ * sim_system.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+
+// The small modules the firmware only uses synchronously: the CRC16 and
+// CRC32 modules (results are ready right after the data write) and RTC_C
+// as a 32 bit counter clocked at ACLK / 32768.
+
+static SimModel crc16;
+static SimModel crc32;
+static SimModel rtc;
+
+//*****************************************************************************
+// CRC16, CRC-CCITT polynomial 0x1021
+//*****************************************************************************
+static uint16_t SimCrc16_byte(uint16_t crc, uint8_t data)
+{
+    uint8_t bit;
+
+    crc ^= (uint16_t) data << 8;
+    for (bit = 0; bit < 8; bit++)
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    return crc;
+}
+
+static uint8_t SimCrc_reverse8(uint8_t data)
+{
+    uint8_t result = 0;
+    uint8_t bit;
+
+    for (bit = 0; bit < 8; bit++)
+        if (data & (1 << bit))
+            result |= 0x80 >> bit;
+    return result;
+}
+
+static uint16_t SimCrc_reverse16(uint16_t data)
+{
+    return ((uint16_t) SimCrc_reverse8(data & 0xFF) << 8)
+            | SimCrc_reverse8(data >> 8);
+}
+
+static void SimCrc16_feed(uint8_t data)
+{
+    uint16_t crc = SimCrc16_byte(Sim_get16(CRC_BASE + OFS_CRCINIRES), data);
+
+    Sim_set16(CRC_BASE + OFS_CRCINIRES, crc);
+    Sim_set16(CRC_BASE + OFS_CRCRESR, SimCrc_reverse16(crc));
+}
+
+static void SimCrc16_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    uint16_t value = Sim_get16(CRC_BASE + offset);
+
+    (void) model;
+    (void) old;
+    switch (offset) {
+    case OFS_CRCDIRB:
+        // bit reversed input: the byte goes in MSB first
+        SimCrc16_feed(value & 0xFF);
+        if (width == 2)
+            SimCrc16_feed(value >> 8);
+        break;
+    case OFS_CRCDI:
+        // CRCDI takes the data LSB first
+        SimCrc16_feed(SimCrc_reverse8(value & 0xFF));
+        if (width == 2)
+            SimCrc16_feed(SimCrc_reverse8(value >> 8));
+        break;
+    case OFS_CRCINIRES:
+        Sim_set16(CRC_BASE + OFS_CRCRESR, SimCrc_reverse16(value));
+        break;
+    }
+}
+
+//*****************************************************************************
+// CRC32, ISO 3309 polynomial, reflected
+//*****************************************************************************
+static void SimCrc32_feed(uint16_t data, uint8_t bits)
+{
+    uint32_t crc = Sim_get16(CRC32_BASE + OFS_CRC32INIRESW0)
+            | ((uint32_t) Sim_get16(CRC32_BASE + OFS_CRC32INIRESW1) << 16);
+    uint8_t bit;
+
+    crc ^= data;
+    for (bit = 0; bit < bits; bit++)
+        crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
+    Sim_set16(CRC32_BASE + OFS_CRC32INIRESW0, crc & 0xFFFF);
+    Sim_set16(CRC32_BASE + OFS_CRC32INIRESW1, crc >> 16);
+}
+
+static void SimCrc32_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    uint16_t value = Sim_get16(CRC32_BASE + offset);
+
+    (void) model;
+    (void) old;
+    // a byte write to the low byte takes 8 bits
+    if (offset == OFS_CRC32DIW0 || offset == OFS_CRC32DIW1)
+        SimCrc32_feed(width == 1 ? value & 0xFF : value, 8 * width);
+}
+
+//*****************************************************************************
+// RTC_C counter mode
+//*****************************************************************************
+static struct {
+    uint32_t count;             // counter value at anchor
+    uint64_t anchor;
+} counter;
+
+static bool SimRtc_running(void)
+{
+    return !(Sim_get16(RTC_C_BASE + OFS_RTCCTL13) & RTCHOLD)
+            && !(Sim_get16(RTC_C_BASE + OFS_RTCPS1CTL) & RT1PSHOLD);
+}
+
+static uint32_t SimRtc_count(void)
+{
+    uint32_t hz = Sim_aclkHz();
+
+    if (!SimRtc_running() || hz == 0)
+        return counter.count;
+    return counter.count + (Sim_now() - counter.anchor) * hz
+            / ((uint64_t) SIM_MCLK_HZ * 32768);
+}
+
+static void SimRtc_anchor(uint32_t count)
+{
+    counter.count = count;
+    counter.anchor = Sim_now();
+}
+
+static void SimRtc_read(SimModel* model, uint16_t offset)
+{
+    uint32_t count;
+
+    (void) model;
+    if (offset != OFS_RTCTIM0 && offset != OFS_RTCTIM1)
+        return;
+    count = SimRtc_count();
+    Sim_set16(RTC_C_BASE + OFS_RTCTIM0, count & 0xFFFF);
+    Sim_set16(RTC_C_BASE + OFS_RTCTIM1, count >> 16);
+}
+
+static void SimRtc_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    uint16_t address = RTC_C_BASE + offset;
+    uint16_t value = Sim_get16(address);
+
+    (void) model;
+    (void) width;
+    switch (offset) {
+    case OFS_RTCTIM0:
+    case OFS_RTCTIM1:
+        SimRtc_anchor(Sim_get16(RTC_C_BASE + OFS_RTCTIM0)
+                | ((uint32_t) Sim_get16(RTC_C_BASE + OFS_RTCTIM1) << 16));
+        break;
+    case OFS_RTCCTL13:
+    case OFS_RTCPS1CTL:
+        if (value == old)
+            break;
+        // the count up to here runs with the old hold bits
+        Sim_set16(address, old);
+        SimRtc_anchor(SimRtc_count());
+        Sim_set16(address, value);
+        break;
+    }
+}
+
+void SimSystem_init(void)
+{
+    crc16.name = "CRC16";
+    crc16.base = CRC_BASE;
+    crc16.size = 0x8;
+    crc16.write = SimCrc16_write;
+    Sim_addModel(&crc16);
+
+    crc32.name = "CRC32";
+    crc32.base = CRC32_BASE;
+    crc32.size = 0x20;
+    crc32.write = SimCrc32_write;
+    Sim_addModel(&crc32);
+
+    rtc.name = "RTC_C";
+    rtc.base = RTC_C_BASE;
+    rtc.size = 0x20;
+    rtc.read = SimRtc_read;
+    rtc.write = SimRtc_write;
+    Sim_addModel(&rtc);
+    Sim_set16(RTC_C_BASE + OFS_RTCCTL13, RTCHOLD);
+}
@@ -0,0 +1,219 @@
+/*
+ * sim_timer.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+
+// Timer_A / Timer_B in up and continuous mode, compare only. The count is
+// worked out from the clock when it is read, events are the next compare
+// with CCIE set and the next wrap (TAIFG).
+
+#define SIM_TIMER_CCRS (7)
+
+typedef struct {
+    SimModel model;
+    uint8_t ccrs;
+    // set at the last reconfiguration: input clock after ID and IDEX, 0
+    // when stopped; clock position and count at that point
+    uint32_t hz;
+    bool smclk;
+    uint64_t base;
+    uint16_t base_count;
+} SimTimer;
+
+static SimTimer ta0;
+static SimTimer tb0;
+
+static uint64_t SimTimer_clock(SimTimer* timer)
+{
+    return timer->smclk ? Sim_smclk() : Sim_now();
+}
+
+static uint64_t SimTimer_ticks(SimTimer* timer)
+{
+    if (timer->hz == 0)
+        return 0;
+    return (SimTimer_clock(timer) - timer->base) * timer->hz / SIM_MCLK_HZ;
+}
+
+static uint32_t SimTimer_period(SimTimer* timer)
+{
+    uint16_t ctl = Sim_get16(timer->model.base + OFS_TAxCTL);
+    if ((ctl & MC_3) == MC_1)
+        return (uint32_t) Sim_get16(timer->model.base + OFS_TAxCCR0) + 1;
+    return 0x10000;
+}
+
+static uint16_t SimTimer_count(SimTimer* timer, uint64_t ticks)
+{
+    return (timer->base_count + ticks) % SimTimer_period(timer);
+}
+
+// Latches the count, then the clock configuration now in the registers
+static void SimTimer_configure(SimTimer* timer)
+{
+    uint16_t base = timer->model.base;
+    uint16_t ctl = Sim_get16(base + OFS_TAxCTL);
+    uint32_t hz;
+
+    timer->base_count = SimTimer_count(timer, SimTimer_ticks(timer));
+    timer->smclk = false;
+    switch (ctl & TASSEL__INCLK) {
+    case TASSEL__ACLK:
+        hz = Sim_aclkHz();
+        break;
+    case TASSEL__SMCLK:
+        hz = SIM_MCLK_HZ;
+        timer->smclk = true;
+        break;
+    default:
+        hz = 0;
+        break;
+    }
+    if ((ctl & MC_3) == MC_0 || (ctl & MC_3) == MC_3)
+        hz = 0;
+    hz >>= (ctl >> 6) & 0x3;
+    hz /= (Sim_get16(base + OFS_TAxEX0) & TAIDEX_7) + 1;
+    timer->hz = hz;
+    timer->base = SimTimer_clock(timer);
+}
+
+// MCLK cycle at which the count reaches target
+static uint64_t SimTimer_when(SimTimer* timer, uint16_t target)
+{
+    uint64_t ticks = SimTimer_ticks(timer);
+    uint32_t period = SimTimer_period(timer);
+    uint32_t distance;
+    uint64_t position;
+
+    if (target >= period)
+        return SIM_NEVER;
+    distance = (target + period - SimTimer_count(timer, ticks)) % period;
+    if (distance == 0)
+        distance = period;
+    ticks += distance;
+    position = timer->base
+            + (ticks * SIM_MCLK_HZ + timer->hz - 1) / timer->hz;
+    // SMCLK may stop on the way, the event is then early and looks again
+    return Sim_now() + (position - SimTimer_clock(timer));
+}
+
+static void SimTimer_reschedule(SimTimer* timer)
+{
+    uint16_t base = timer->model.base;
+    uint64_t next;
+    uint64_t when;
+    uint8_t i;
+
+    if (timer->hz == 0) {
+        Sim_schedule(&timer->model, SIM_NEVER);
+        return;
+    }
+    next = SimTimer_when(timer, 0);
+    for (i = 0; i < timer->ccrs; i++) {
+        if (Sim_get16(base + OFS_TAxCCTL0 + 2 * i) & CCIE) {
+            when = SimTimer_when(timer,
+                    Sim_get16(base + OFS_TAxCCR0 + 2 * i));
+            if (when < next)
+                next = when;
+        }
+    }
+    Sim_schedule(&timer->model, next);
+}
+
+static void SimTimer_event(SimModel* model)
+{
+    SimTimer* timer = (SimTimer*) model;
+    uint16_t base = model->base;
+    uint16_t count = SimTimer_count(timer, SimTimer_ticks(timer));
+    uint8_t i;
+
+    if (count == 0)
+        Sim_setBits(base + OFS_TAxCTL, TAIFG);
+    for (i = 0; i < timer->ccrs; i++) {
+        uint16_t cctl = base + OFS_TAxCCTL0 + 2 * i;
+        if ((Sim_get16(cctl) & CCIE)
+                && Sim_get16(base + OFS_TAxCCR0 + 2 * i) == count)
+            Sim_setBits(cctl, CCIFG);
+    }
+    SimTimer_reschedule(timer);
+}
+
+static void SimTimer_read(SimModel* model, uint16_t offset)
+{
+    SimTimer* timer = (SimTimer*) model;
+    uint16_t base = model->base;
+    uint8_t i;
+
+    if (offset == OFS_TAxR) {
+        Sim_set16(base + OFS_TAxR,
+                SimTimer_count(timer, SimTimer_ticks(timer)));
+    } else if (offset == OFS_TAxIV) {
+        // highest pending of CCR1..6 and the wrap, reading clears it
+        uint16_t ctl = Sim_get16(base + OFS_TAxCTL);
+        uint16_t iv = 0;
+        for (i = 1; i < timer->ccrs && iv == 0; i++) {
+            uint16_t cctl = base + OFS_TAxCCTL0 + 2 * i;
+            if ((Sim_get16(cctl) & CCIE) && (Sim_get16(cctl) & CCIFG)) {
+                Sim_clearBits(cctl, CCIFG);
+                iv = 2 * i;
+            }
+        }
+        if (iv == 0 && (ctl & TAIE) && (ctl & TAIFG)) {
+            Sim_clearBits(base + OFS_TAxCTL, TAIFG);
+            iv = TAIV__TAIFG;
+        }
+        Sim_set16(base + OFS_TAxIV, iv);
+    }
+}
+
+static void SimTimer_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    SimTimer* timer = (SimTimer*) model;
+    uint16_t base = model->base;
+    uint16_t value = Sim_get16(base + offset);
+
+    (void) width;
+    if (offset == OFS_TAxCTL || offset == OFS_TAxEX0) {
+        if (value == old)
+            return;
+        // the count runs on with the old setting up to here
+        Sim_set16(base + offset, old);
+        SimTimer_configure(timer);
+        Sim_set16(base + offset, value);
+        if (value & TACLR) {
+            timer->base_count = 0;
+            Sim_clearBits(base + OFS_TAxCTL, TACLR);
+        }
+        SimTimer_configure(timer);
+    } else if (offset == OFS_TAxR) {
+        if (value == old)
+            return;
+        SimTimer_configure(timer);
+        timer->base_count = value;
+    } else if (offset == OFS_TAxIV) {
+        return;
+    }
+    SimTimer_reschedule(timer);
+}
+
+static void SimTimer_add(SimTimer* timer, const char* name, uint16_t base,
+        uint8_t ccrs)
+{
+    timer->model.name = name;
+    timer->model.base = base;
+    timer->model.size = 0x30;
+    timer->model.read = SimTimer_read;
+    timer->model.write = SimTimer_write;
+    timer->model.event = SimTimer_event;
+    timer->ccrs = ccrs;
+    Sim_addModel(&timer->model);
+}
+
+void SimTimer_init(void)
+{
+    SimTimer_add(&ta0, "TA0", TIMER_A0_BASE, 3);
+    SimTimer_add(&tb0, "TB0", TIMER_B0_BASE, SIM_TIMER_CCRS);
+}
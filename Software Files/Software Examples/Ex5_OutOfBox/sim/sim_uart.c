@@ -0,0 +1,275 @@
+/*
+ * sim_uart.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "sim.h"
+#include <stdio.h>
+
+// eUSCI_A in UART mode. Bytes take their frame time at the configured baud
+// rate in both directions. TXIFG is set when TXBUF moves into the shift
+// register, TXCPTIFG when the line goes idle. Received bytes come from
+// SimUart_input; one that arrives with RXIFG still set overruns (UCOE).
+
+#define SIM_UART_FIFO_SIZE (512)
+
+struct SimUart {
+    SimModel model;
+    SimUartOutput output;
+    // transmit
+    bool shifting;
+    bool loaded;                // TXBUF written, not in the shifter yet
+    uint8_t shift;
+    uint64_t tx_done;
+    uint64_t tx_start;
+    // receive, bytes waiting at the peer
+    uint8_t fifo[SIM_UART_FIFO_SIZE];
+    uint16_t fifo_head;
+    uint16_t fifo_count;
+    uint64_t rx_ready;          // the peer does not send before this
+    uint64_t rx_done;
+    // statistics
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint32_t overruns;
+    uint32_t dropped;
+    uint64_t tx_busy;
+};
+
+static SimUart a0;
+static SimUart a3;
+
+static uint16_t SimUart_reg(SimUart* uart, uint16_t offset)
+{
+    return uart->model.base + offset;
+}
+
+// MCLK cycles per character from UCAxBRW/MCTLW and the frame format
+static uint64_t SimUart_byteCycles(SimUart* uart)
+{
+    uint16_t ctl = Sim_get16(SimUart_reg(uart, OFS_UCAxCTLW0));
+    uint16_t mctl = Sim_get16(SimUart_reg(uart, OFS_UCAxMCTLW));
+    uint32_t brw = Sim_get16(SimUart_reg(uart, OFS_UCAxBRW));
+    uint32_t clock = (ctl & UCSSEL_3) == UCSSEL__ACLK ?
+            Sim_aclkHz() : SIM_MCLK_HZ;
+    uint32_t bits = 1 + ((ctl & UC7BIT) ? 7 : 8) + ((ctl & UCPEN) ? 1 : 0)
+            + ((ctl & UCSPB) ? 2 : 1);
+    uint32_t bit;
+
+    if (mctl & UCOS16)
+        bit = 16 * brw + ((mctl >> 4) & 0xF);
+    else
+        bit = brw;
+    if (bit == 0 || clock == 0)
+        Sim_fail("%s: no baud rate", uart->model.name);
+    return (uint64_t) bits * bit * SIM_MCLK_HZ / clock;
+}
+
+static void SimUart_reschedule(SimUart* uart)
+{
+    uint64_t next = SIM_NEVER;
+
+    if (uart->shifting)
+        next = uart->tx_done;
+    if (uart->rx_done != SIM_NEVER && uart->rx_done < next)
+        next = uart->rx_done;
+    Sim_schedule(&uart->model, next);
+}
+
+static void SimUart_setTxifg(SimUart* uart)
+{
+    uint16_t ifg = SimUart_reg(uart, OFS_UCAxIFG);
+    if (!(Sim_get16(ifg) & UCTXIFG)) {
+        Sim_setBits(ifg, UCTXIFG);
+        if (uart == &a3)
+            SimDma_trigger(SIM_DMA_UCA3TXIFG);
+    }
+}
+
+// TXBUF into the shift register
+static void SimUart_load(SimUart* uart)
+{
+    uart->shift = Sim_get16(SimUart_reg(uart, OFS_UCAxTXBUF));
+    uart->loaded = false;
+    if (!uart->shifting)
+        uart->tx_start = Sim_now();
+    uart->shifting = true;
+    uart->tx_done = Sim_now() + SimUart_byteCycles(uart);
+    Sim_clearBits(SimUart_reg(uart, OFS_UCAxIFG), UCTXCPTIFG);
+    SimUart_setTxifg(uart);
+}
+
+static void SimUart_startReceive(SimUart* uart)
+{
+    uint64_t start = Sim_now();
+
+    if (uart->rx_done != SIM_NEVER || uart->fifo_count == 0)
+        return;
+    if (Sim_get16(SimUart_reg(uart, OFS_UCAxCTLW0)) & UCSWRST)
+        return;
+    if (uart->rx_ready > start)
+        start = uart->rx_ready;
+    uart->rx_done = start + SimUart_byteCycles(uart);
+}
+
+static void SimUart_event(SimModel* model)
+{
+    SimUart* uart = (SimUart*) model;
+    uint64_t now = Sim_now();
+
+    if (uart->shifting && uart->tx_done <= now) {
+        uart->tx_bytes++;
+        if (uart->output)
+            uart->output(uart, uart->shift);
+        if (uart->loaded) {
+            SimUart_load(uart);
+        } else {
+            uart->shifting = false;
+            uart->tx_busy += now - uart->tx_start;
+            Sim_setBits(SimUart_reg(uart, OFS_UCAxIFG), UCTXCPTIFG);
+        }
+    }
+    if (uart->rx_done != SIM_NEVER && uart->rx_done <= now) {
+        uint16_t ifg = SimUart_reg(uart, OFS_UCAxIFG);
+        if (Sim_get16(ifg) & UCRXIFG) {
+            uart->overruns++;
+            Sim_setBits(SimUart_reg(uart, OFS_UCAxSTATW), UCOE);
+        }
+        Sim_set16(SimUart_reg(uart, OFS_UCAxRXBUF),
+                uart->fifo[uart->fifo_head]);
+        uart->fifo_head = (uart->fifo_head + 1) % SIM_UART_FIFO_SIZE;
+        uart->fifo_count--;
+        uart->rx_bytes++;
+        Sim_setBits(ifg, UCRXIFG);
+        uart->rx_done = SIM_NEVER;
+        SimUart_startReceive(uart);
+    }
+    SimUart_reschedule(uart);
+}
+
+static void SimUart_read(SimModel* model, uint16_t offset)
+{
+    SimUart* uart = (SimUart*) model;
+    uint16_t ifg = SimUart_reg(uart, OFS_UCAxIFG);
+    uint16_t pending;
+
+    switch (offset) {
+    case OFS_UCAxRXBUF:
+        Sim_clearBits(ifg, UCRXIFG);
+        Sim_clearBits(SimUart_reg(uart, OFS_UCAxSTATW), UCOE);
+        break;
+    case OFS_UCAxSTATW:
+        if (uart->shifting || uart->rx_done != SIM_NEVER)
+            Sim_setBits(SimUart_reg(uart, OFS_UCAxSTATW), UCBUSY);
+        else
+            Sim_clearBits(SimUart_reg(uart, OFS_UCAxSTATW), UCBUSY);
+        break;
+    case OFS_UCAxIV:
+        // RXIFG, TXIFG, STTIFG, TXCPTIFG; reading clears the one reported
+        pending = Sim_get16(ifg) & Sim_get16(SimUart_reg(uart, OFS_UCAxIE))
+                & 0x000F;
+        if (pending == 0) {
+            Sim_set16(SimUart_reg(uart, OFS_UCAxIV), USCI_NONE);
+        } else {
+            uint8_t bit = 0;
+            while (!(pending & (1 << bit)))
+                bit++;
+            Sim_clearBits(ifg, 1 << bit);
+            Sim_set16(SimUart_reg(uart, OFS_UCAxIV), 2 * (bit + 1));
+        }
+        break;
+    }
+}
+
+static void SimUart_write(SimModel* model, uint16_t offset, uint16_t old,
+        uint8_t width)
+{
+    SimUart* uart = (SimUart*) model;
+    uint16_t value = Sim_get16(SimUart_reg(uart, offset));
+
+    (void) width;
+    switch (offset) {
+    case OFS_UCAxCTLW0:
+        if ((value & UCSWRST) && !(old & UCSWRST)) {
+            // reset: interrupts off, TXIFG up, transfers dropped
+            uart->shifting = false;
+            uart->loaded = false;
+            uart->rx_done = SIM_NEVER;
+            Sim_set16(SimUart_reg(uart, OFS_UCAxIE), 0);
+            Sim_set16(SimUart_reg(uart, OFS_UCAxIFG), UCTXIFG);
+        } else if (!(value & UCSWRST) && (old & UCSWRST)) {
+            SimUart_startReceive(uart);
+        }
+        break;
+    case OFS_UCAxTXBUF:
+        if (Sim_get16(SimUart_reg(uart, OFS_UCAxCTLW0)) & UCSWRST)
+            break;
+        if (uart->loaded)
+            uart->dropped++;
+        uart->loaded = true;
+        Sim_clearBits(SimUart_reg(uart, OFS_UCAxIFG), UCTXIFG);
+        if (!uart->shifting)
+            SimUart_load(uart);
+        break;
+    case OFS_UCAxIFG:
+        // the firmware pulses TXIFG to start DMA transfers
+        if (uart == &a3 && (value & UCTXIFG) && !(old & UCTXIFG))
+            SimDma_trigger(SIM_DMA_UCA3TXIFG);
+        break;
+    }
+    SimUart_reschedule(uart);
+}
+
+SimUart* SimUart_init(uint16_t base, const char* name, SimUartOutput output)
+{
+    SimUart* uart = base == EUSCI_A0_BASE ? &a0 : &a3;
+
+    uart->model.name = name;
+    uart->model.base = base;
+    uart->model.size = 0x20;
+    uart->model.read = SimUart_read;
+    uart->model.write = SimUart_write;
+    uart->model.event = SimUart_event;
+    uart->output = output;
+    uart->rx_done = SIM_NEVER;
+    Sim_addModel(&uart->model);
+    Sim_set16(base + OFS_UCAxCTLW0, UCSWRST);
+    Sim_set16(base + OFS_UCAxIFG, UCTXIFG);
+    return uart;
+}
+
+void SimUart_input(SimUart* uart, const uint8_t data[], uint16_t length,
+        uint64_t delay)
+{
+    uint16_t i;
+
+    if (uart->fifo_count == 0 && uart->rx_done == SIM_NEVER)
+        uart->rx_ready = Sim_now() + delay;
+    for (i = 0; i < length; i++) {
+        if (uart->fifo_count == SIM_UART_FIFO_SIZE) {
+            uart->dropped++;
+            continue;
+        }
+        uart->fifo[(uart->fifo_head + uart->fifo_count) % SIM_UART_FIFO_SIZE] =
+                data[i];
+        uart->fifo_count++;
+    }
+    SimUart_startReceive(uart);
+    SimUart_reschedule(uart);
+}
+
+void SimUart_report(SimUart* uart)
+{
+    uint64_t now = Sim_now();
+    uint64_t busy = uart->tx_busy;
+
+    if (uart->shifting)
+        busy += now - uart->tx_start;
+    printf("%s tx %lu bytes, line busy %.3f%%, %.1f bytes per 1k active"
+            " cycles\n", uart->model.name, (unsigned long) uart->tx_bytes,
+            now ? 100.0 * busy / now : 0.0,
+            Sim_stats.active ? 1000.0 * uart->tx_bytes / Sim_stats.active : 0.0);
+    printf("%s rx %lu bytes, %lu overruns, %lu dropped\n", uart->model.name,
+            (unsigned long) uart->rx_bytes, (unsigned long) uart->overruns,
+            (unsigned long) uart->dropped);
+}
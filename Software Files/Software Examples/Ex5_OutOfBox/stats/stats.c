@@ -0,0 +1,52 @@
+/*
+ * stats.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "stats.h"
+
+#define STATS_ONE ((uint32_t) 1 << STATS_FRACTION)
+
+void Stats_reset(Stats* stats) {
+	stats->count = 0;
+	stats->min = 0;
+	stats->max = 0;
+	stats->mean = 0;
+	stats->m2 = 0;
+}
+
+void Stats_add(Stats* stats, uint16_t value) {
+	int32_t x = (int32_t) value << STATS_FRACTION;
+	int32_t delta;
+
+	if (stats->count == 0xFFFF)
+		return;
+	if (stats->count == 0 || value < stats->min)
+		stats->min = value;
+	if (stats->count == 0 || value > stats->max)
+		stats->max = value;
+	stats->count++;
+
+	// mean += (x - mean) / n, m2 += (x - old mean) * (x - new mean). The
+	// new mean lies between the old one and x, so both factors have the
+	// same sign and m2 never decreases.
+	delta = x - (int32_t) stats->mean;
+	stats->mean += delta / (int32_t) stats->count;
+	stats->m2 += (uint64_t) ((int64_t) delta
+			* (x - (int32_t) stats->mean));
+}
+
+void Stats_summarize(const Stats* stats, StatsSummary* summary) {
+	uint64_t variance = 0;
+
+	summary->count = stats->count;
+	summary->min = stats->min;
+	summary->max = stats->max;
+	summary->mean = (stats->mean + STATS_ONE / 2) >> STATS_FRACTION;
+	if (stats->count > 1) {
+		variance = stats->m2 / (stats->count - 1);
+		variance = (variance + STATS_ONE * STATS_ONE / 2)
+				>> (2 * STATS_FRACTION);
+	}
+	summary->variance = (variance > 0xFFFFFFFF) ? 0xFFFFFFFF : variance;
+}
@@ -0,0 +1,47 @@
+/*
+ * stats.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include <stdint.h>
+
+#ifndef STATS_H_
+#define STATS_H_
+
+// Running statistics of raw readings over a window: count, min, max, mean
+// and variance, updated one reading at a time with Welford's method so no
+// readings are stored. Fixed point throughout: the mean keeps
+// STATS_FRACTION bits below the raw count and the sum of squared
+// deviations is 64 bits wide, so a window of 65535 readings cannot
+// overflow.
+//
+// Each step truncates the mean by less than 2^-STATS_FRACTION counts,
+// which is far below the resolution of the sensors.
+
+#define STATS_FRACTION (8)
+
+typedef struct {
+	uint16_t count;
+	uint16_t min;
+	uint16_t max;
+	uint32_t mean;		// raw counts << STATS_FRACTION
+	uint64_t m2;		// sum of squared deviations << 2 * STATS_FRACTION
+} Stats;
+
+// What goes out at the end of a window, in raw counts
+typedef struct {
+	uint16_t count;
+	uint16_t min;
+	uint16_t max;
+	uint16_t mean;		// rounded
+	uint32_t variance;	// sample variance in counts^2, rounded, saturated
+} StatsSummary;
+
+// A zeroed Stats is an empty window
+void Stats_reset(Stats* stats);
+// Further readings of a full window (65535) are dropped
+void Stats_add(Stats* stats, uint16_t value);
+// Only meaningful with count > 0. The variance of a single reading is 0.
+void Stats_summarize(const Stats* stats, StatsSummary* summary);
+
+#endif /* STATS_H_ */
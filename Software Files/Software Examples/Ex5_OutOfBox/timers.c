@@ -6,63 +6,238 @@
  */
 #include "timers.h"
 
+// upper half of timer_now()
+static volatile uint16_t overflows = 0;
+#ifndef TIMER_LFXT
+static volatile uint32_t seconds = 0;
+#endif
+static uint32_t wake_time;
+static TimerCallback wake_callback = 0;
+static TimerCallback after_callback;
+
+
+#ifdef TIMER_LFXT
+// ACLK from the crystal, RTC_C as a 32 bit seconds counter:
+// ACLK / 256 / 128 = 1 Hz
+static void timer_initLFXT(void)
+{
+    CS_setExternalClockSource(TIMER_LFXT_HZ, 0);
+    // waits for the crystal to settle, clears the fault flags
+    CS_turnOnLFXT(CS_LFXT_DRIVE_0);
+    CS_initClockSignal(CS_ACLK, CS_LFXTCLK_SELECT, CS_CLOCK_DIVIDER_1);
+
+    RTC_C_holdClock(RTC_C_BASE);
+    RTC_C_initCounter(RTC_C_BASE, RTC_C_CLOCKSELECT_RT1PS,
+            RTC_C_COUNTERSIZE_32BIT);
+    RTC_C_initCounterPrescale(RTC_C_BASE, RTC_C_PRESCALE_0,
+            RTC_C_PSCLOCKSELECT_ACLK, RTC_C_PSDIVIDER_256);
+    RTC_C_initCounterPrescale(RTC_C_BASE, RTC_C_PRESCALE_1,
+            RTC_C_PSCLOCKSELECT_RT0PS, RTC_C_PSDIVIDER_128);
+    RTC_C_setCounterValue(RTC_C_BASE, 0);
+    RTC_C_startClock(RTC_C_BASE);
+}
+#endif
 
 void timer_a_init(uint16_t timer_a_base)
 {
+#ifdef TIMER_LFXT
+    timer_initLFXT();
+#endif
 
-    //Start timer in continuous mode sourced by SMCLK
+    //Start timer in continuous mode
     Timer_A_initContinuousModeParam initContParam = { 0 };
+#ifdef TIMER_LFXT
+    initContParam.clockSource = TIMER_A_CLOCKSOURCE_ACLK;
+    initContParam.clockSourceDivider = TIMER_A_CLOCKSOURCE_DIVIDER_8;
+#else
     initContParam.clockSource = TIMER_A_CLOCKSOURCE_SMCLK;
-    initContParam.clockSourceDivider = TIMER_A_CLOCKSOURCE_DIVIDER_16;
-    initContParam.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE;
+    initContParam.clockSourceDivider = TIMER_A_CLOCKSOURCE_DIVIDER_64;
+#endif
+    initContParam.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_ENABLE;
     initContParam.timerClear = TIMER_A_DO_CLEAR;
     initContParam.startTimer = false;
     Timer_A_initContinuousMode(timer_a_base, &initContParam);
 
-    //Initiaze compare mode
+    //Initiaze compare mode, CCR0 is enabled by timer_wakeAt
     Timer_A_clearCaptureCompareInterrupt(timer_a_base,
     TIMER_A_CAPTURECOMPARE_REGISTER_0);
 
     Timer_A_initCompareModeParam initCompParam = { 0 };
     initCompParam.compareRegister = TIMER_A_CAPTURECOMPARE_REGISTER_0;
     initCompParam.compareInterruptEnable =
-            TIMER_A_CAPTURECOMPARE_INTERRUPT_ENABLE;
+            TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE;
     initCompParam.compareOutputMode = TIMER_A_OUTPUTMODE_OUTBITVALUE;
-    initCompParam.compareValue = COMPARE_VALUE;
+    initCompParam.compareValue = 0;
     Timer_A_initCompareMode(timer_a_base, &initCompParam);
 
     Timer_A_startCounter( timer_a_base,
     TIMER_A_CONTINUOUS_MODE);
 }
 
+uint32_t timer_now(void)
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+    uint16_t high = overflows;
+    uint16_t low = Timer_A_getCounterValue(TIMER_A0_BASE);
+    // wrapped but the overflow interrupt has not run yet
+    if (Timer_A_getInterruptStatus(TIMER_A0_BASE) == TIMER_A_INTERRUPT_PENDING
+            && low < 0x8000)
+        high++;
+    __set_interrupt_state(state);
+    return ((uint32_t)high << 16) | low;
+}
 
+// CCR0 only compares the low 16 bits, so it is armed once the wake time is
+// less than one wrap away. Returns false if the time has already passed.
+static bool timer_armWake(void)
+{
+    int32_t remaining = (int32_t)(wake_time - timer_now());
 
+    if (remaining <= 0) {
+        Timer_A_disableCaptureCompareInterrupt(TIMER_A0_BASE,
+            TIMER_A_CAPTURECOMPARE_REGISTER_0);
+        return false;
+    }
+    if (remaining < 0x10000) {
+        Timer_A_setCompareValue(TIMER_A0_BASE,
+            TIMER_A_CAPTURECOMPARE_REGISTER_0,
+            (uint16_t)wake_time
+            );
+        Timer_A_clearCaptureCompareInterrupt(TIMER_A0_BASE,
+            TIMER_A_CAPTURECOMPARE_REGISTER_0);
+        Timer_A_enableCaptureCompareInterrupt(TIMER_A0_BASE,
+            TIMER_A_CAPTURECOMPARE_REGISTER_0);
+        // the compare may have gone by while it was being written
+        if ((int32_t)(wake_time - timer_now()) <= 0) {
+            Timer_A_disableCaptureCompareInterrupt(TIMER_A0_BASE,
+                TIMER_A_CAPTURECOMPARE_REGISTER_0);
+            return false;
+        }
+    } else {
+        Timer_A_disableCaptureCompareInterrupt(TIMER_A0_BASE,
+            TIMER_A_CAPTURECOMPARE_REGISTER_0);
+    }
+    return true;
+}
+
+bool timer_wakeAt(uint32_t time, TimerCallback callback)
+{
+    wake_time = time;
+    wake_callback = callback;
+    if (!timer_armWake()) {
+        wake_callback = 0;
+        return false;
+    }
+    return true;
+}
 
 //******************************************************************************
 //
-//This is the TIMER1_A0 interrupt vector service routine.
+//This is the TIMER0_A0 interrupt vector service routine, the wake time.
 //
 //******************************************************************************
 #if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
 #pragma vector=TIMER0_A0_VECTOR
 __interrupt
 #elif defined(__GNUC__)
-__attribute__((interrupt(TIMER1_A0_VECTOR)))
+__attribute__((interrupt(TIMER0_A0_VECTOR)))
 #endif
-void TIMER1_A0_ISR (void)
+void TIMER0_A0_ISR (void)
+{
+    TimerCallback callback = wake_callback;
+
+    TRACE_ISR_BEGIN(TRACE_ISR_TIMER0_A0);
+    Timer_A_disableCaptureCompareInterrupt(TIMER_A0_BASE,
+        TIMER_A_CAPTURECOMPARE_REGISTER_0);
+    wake_callback = 0;
+    if (callback && callback())
+        __bic_SR_register_on_exit(TIMER_SLEEP);
+    TRACE_ISR_END(TRACE_ISR_TIMER0_A0);
+}
+
+void timer_after(uint16_t ms, TimerCallback callback)
 {
-	static int i = 0;
-    uint16_t compVal = Timer_A_getCaptureCompareCount(TIMER_A1_BASE,
-            TIMER_A_CAPTURECOMPARE_REGISTER_0)
-            + COMPARE_VALUE;
-
-    // wake up for capture and send
-    if((++i % 20) == 0)
-    	__bic_SR_register_on_exit(LPM1_bits);
-
-    //Add Offset to CCR0
-    Timer_A_setCompareValue(TIMER_A1_BASE,
-        TIMER_A_CAPTURECOMPARE_REGISTER_0,
-        compVal
+    after_callback = callback;
+    Timer_A_setCompareValue(TIMER_A0_BASE,
+        TIMER_A_CAPTURECOMPARE_REGISTER_1,
+        Timer_A_getCounterValue(TIMER_A0_BASE) + (uint16_t)TIMER_MS(ms)
         );
+    Timer_A_clearCaptureCompareInterrupt(TIMER_A0_BASE,
+        TIMER_A_CAPTURECOMPARE_REGISTER_1);
+    Timer_A_enableCaptureCompareInterrupt(TIMER_A0_BASE,
+        TIMER_A_CAPTURECOMPARE_REGISTER_1);
+}
+
+//******************************************************************************
+//
+//This is the TIMER0_A1 interrupt vector service routine, CCR1 one shots and
+//the overflow.
+//
+//******************************************************************************
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER0_A1_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(TIMER0_A1_VECTOR)))
+#endif
+void TIMER0_A1_ISR (void)
+{
+#ifndef TIMER_LFXT
+    static uint32_t counts = 0;
+#endif
+
+    TRACE_ISR_BEGIN(TRACE_ISR_TIMER0_A1);
+    switch (__even_in_range(TA0IV, TAIV__TAIFG))
+    {
+    case TAIV__TACCR1:
+        Timer_A_disableCaptureCompareInterrupt(TIMER_A0_BASE,
+            TIMER_A_CAPTURECOMPARE_REGISTER_1);
+        if (after_callback && after_callback())
+            __bic_SR_register_on_exit(LPM0_bits);
+        break;
+    case TAIV__TAIFG:
+        overflows++;
+#ifndef TIMER_LFXT
+        // time since reset, used to timestamp logged samples
+        counts += 0x10000;
+        while (counts >= TIMER_HZ) {
+            counts -= TIMER_HZ;
+            seconds++;
+        }
+#endif
+        // a far wake time may now be within one wrap
+        if (wake_callback && !timer_armWake()) {
+            TimerCallback callback = wake_callback;
+            wake_callback = 0;
+            if (callback())
+                __bic_SR_register_on_exit(TIMER_SLEEP);
+        }
+        break;
+    default:
+        break;
+    }
+    TRACE_ISR_END(TRACE_ISR_TIMER0_A1);
+}
+
+uint32_t timer_getSeconds(void)
+{
+#ifdef TIMER_LFXT
+    // RTC_C keeps counting in every sleep mode
+    uint32_t now;
+    uint32_t again = RTC_C_getCounterValue(RTC_C_BASE);
+    // two 16 bit reads, repeat if the counter moved in between
+    do {
+        now = again;
+        again = RTC_C_getCounterValue(RTC_C_BASE);
+    } while (now != again);
+    return now;
+#else
+    // 32 bit read is two instructions, keep the ISR out
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+    uint32_t now = seconds;
+    __set_interrupt_state(state);
+    return now;
+#endif
 }
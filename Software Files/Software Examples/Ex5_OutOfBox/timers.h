@@ -5,12 +5,60 @@
  *      Author: Caleb
  */
 #include "driverlib.h"
+#include "trace/trace.h"
 
 #ifndef TIMERS_H_
 #define TIMERS_H_
-#define COMPARE_VALUE (30000)
+// Time base on the 32 kHz crystal (PJ.4/PJ.5): TA0 runs from ACLK / 8 and
+// keeps counting in LPM3, RTC_C counts seconds. Without it TA0 runs from
+// SMCLK / 64 and the CPU can only sleep in LPM1.
+#define TIMER_LFXT
+
+// TA0 runs continuously, the overflow interrupt extends it to 32 bits.
+// CCR0 wakes the scheduler at its next deadline, CCR1 runs one shots.
+#ifdef TIMER_LFXT
+#define TIMER_LFXT_HZ (32768)
+#define TIMER_HZ (4096)             // wraps every 16 s
+#define TIMER_SLEEP (LPM3_bits)
+#else
+#define TIMER_HZ (125000)           // wraps every 524 ms
+#define TIMER_SLEEP (LPM1_bits)
+#endif
+// rounded up so one shots never fire early. ms * TIMER_HZ would overflow
+// 32 bits from 34 s on at 125 kHz, so the whole counts per ms are taken
+// apart from the rest; exact up to 71 minutes at either rate.
+#define TIMER_MS(ms) ((uint32_t)(ms) * (TIMER_HZ / 1000) \
+		+ ((uint32_t)(ms) * (TIMER_HZ % 1000) + 999) / 1000)
+
+// How often readings are sent, and how often each sensor group is sampled.
+// With STATS (main.c) the sensors are sampled every STATS_SAMPLE_MS and one
+// summary per channel goes out every STATS_WINDOW_MS.
+#ifdef STATS
+#define STATS_SAMPLE_MS (1000)
+#define STATS_WINDOW_MS (60000)
+#define REPORT_INTERVAL_MS (STATS_WINDOW_MS)
+#define I2C_INTERVAL_MS (STATS_SAMPLE_MS)
+#define ADC_INTERVAL_MS (STATS_SAMPLE_MS)
+#else
+#define REPORT_INTERVAL_MS (1200)
+#define I2C_INTERVAL_MS (REPORT_INTERVAL_MS)
+#define ADC_INTERVAL_MS (REPORT_INTERVAL_MS)
+#endif
+
+// Runs from the timer ISR, return true to wake main from TIMER_SLEEP
+typedef bool (*TimerCallback)(void);
 
 void timer_a_init(uint16_t timer_a_base);
+uint32_t timer_getSeconds(void);
+// Counts since reset, wraps every 12 days at 4096 Hz, 9.5 hours at 125 kHz
+uint32_t timer_now(void);
+// Runs callback from the CCR0 interrupt once timer_now() reaches time.
+// Returns false without arming if time has already passed. Replaces any
+// pending wake; call with interrupts disabled.
+bool timer_wakeAt(uint32_t time, TimerCallback callback);
+// One shot on TA0 CCR1: callback runs ms from now, less than one wrap.
+// Replaces any pending one.
+void timer_after(uint16_t ms, TimerCallback callback);
 
 
 #endif /* TIMERS_H_ */
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""Turns trace dumps from the out-of-box firmware into per-stage latency
+histograms.
+
+Build with TRACE_ENABLE defined in trace/trace.h, then send '~' on the
+backchannel UART (115200 8N1) and capture what comes back, or let this
+script do it with --port (needs pyserial):
+
+    python3 trace_decode.py capture.txt
+    python3 trace_decode.py --port /dev/ttyACM1
+
+Stage names and the timestamp rate are read from trace/trace.h. Several
+dumps in one capture are added up. Runs that may have lost whole 2 s
+timestamp wraps are counted as "may have wrapped".
+"""
+
+import argparse
+import os
+import re
+import sys
+
+END_BIT = 0x80
+# wraps byte and TB0R
+TIME_MASK = 0xFFFFFF
+HERE = os.path.dirname(os.path.abspath(__file__))
+TRACE_H = os.path.join(HERE, "..", "trace", "trace.h")
+
+
+def read_header(path):
+    names = {}
+    hz = None
+    for line in open(path):
+        m = re.match(r"#define\s+TRACE_(\w+)\s+\(?(0x[0-9A-Fa-f]+|\d+)\)?", line)
+        if not m:
+            continue
+        name, value = m.group(1), int(m.group(2), 0)
+        if name == "HZ":
+            hz = value
+        elif name not in ("SIZE", "END_BIT", "DUMP_COMMAND"):
+            names[value] = name
+    return names, hz
+
+
+def read_records(lines):
+    """Yields the (event, time) records of every dump in lines, and None
+    where a dump begins."""
+    inside = False
+    for line in lines:
+        line = line.strip()
+        if line == "TRACE BEGIN":
+            inside = True
+            yield None
+        elif line == "TRACE END":
+            inside = False
+        elif inside:
+            m = re.fullmatch(r"([0-9A-F]{2}) ([0-9A-F]{6})", line)
+            if m:
+                yield int(m.group(1), 16), int(m.group(2), 16)
+
+
+def durations(records):
+    """Pairs each end with the latest open begin of the same stage. Time
+    is added up from record to record, so a stage may be longer than one
+    wrap of the 24 bit timestamp as long as every gap between records in
+    it is shorter. Runs over a gap of half a wrap or more may be short by
+    whole wraps; they are counted per stage in the second result."""
+    result = {}
+    wrapped = {}
+    for record in records:
+        if record is None:
+            # a new dump, its times do not follow on from the last one
+            open_stages = {}
+            now = 0
+            last = None
+            doubtful = -1
+            continue
+        event, time = record
+        if last is not None:
+            gap = (time - last) & TIME_MASK
+            now += gap
+            if gap > TIME_MASK // 2:
+                doubtful = now
+        last = time
+        stage = event & ~END_BIT
+        if event & END_BIT:
+            begins = open_stages.get(stage)
+            if begins:
+                begin = begins.pop()
+                result.setdefault(stage, []).append(now - begin)
+                if begin < doubtful:
+                    wrapped[stage] = wrapped.get(stage, 0) + 1
+        else:
+            open_stages.setdefault(stage, []).append(now)
+    return result, wrapped
+
+
+def histogram(cycles, hz, width=40):
+    """Power of two buckets in cycles, labelled in microseconds."""
+    buckets = {}
+    for c in cycles:
+        buckets[max(c, 1).bit_length()] = buckets.get(max(c, 1).bit_length(), 0) + 1
+    peak = max(buckets.values())
+    lines = []
+    for bits in range(min(buckets), max(buckets) + 1):
+        count = buckets.get(bits, 0)
+        low = (1 << (bits - 1)) * 1e6 / hz
+        high = (1 << bits) * 1e6 / hz
+        bar = "#" * max(1 if count else 0, count * width // peak)
+        lines.append("  %9.1f - %9.1f us %6d %s" % (low, high, count, bar))
+    return lines
+
+
+def capture(port):
+    import serial
+    with serial.Serial(port, 115200, timeout=2) as s:
+        s.reset_input_buffer()
+        s.write(b"~")
+        lines = []
+        while True:
+            line = s.readline().decode("ascii", "replace")
+            if not line:
+                break
+            lines.append(line)
+            if line.strip() == "TRACE END":
+                break
+        return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("capture", nargs="?", help="captured dump, - for stdin")
+    parser.add_argument("--port", help="serial port to request a dump from")
+    parser.add_argument("--header", default=TRACE_H, help="trace.h to take the names from")
+    args = parser.parse_args()
+
+    names, hz = read_header(args.header)
+    if args.port:
+        lines = capture(args.port)
+    elif args.capture and args.capture != "-":
+        lines = open(args.capture, errors="replace")
+    else:
+        lines = sys.stdin
+
+    stages, wrapped = durations(read_records(lines))
+    if not stages:
+        sys.exit("no complete stages in the capture")
+    for stage in sorted(stages):
+        cycles = sorted(stages[stage])
+        name = names.get(stage, "0x%02X" % stage)
+        print("%s: %d runs, min %d, median %d, max %d cycles (max %.1f us)%s" % (
+            name, len(cycles), cycles[0], cycles[len(cycles) // 2], cycles[-1],
+            cycles[-1] * 1e6 / hz,
+            ", %d may have wrapped" % wrapped[stage] if stage in wrapped else ""))
+        for line in histogram(cycles, hz):
+            print(line)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,117 @@
+/*
+ * trace.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "trace.h"
+
+#ifdef TRACE_ENABLE
+
+#include "scheduler/scheduler.h"
+#include "uart/uart.h"
+
+// unused slots, skipped by the dump
+#define TRACE_NONE (0)
+
+TraceRecord Trace_buffer[TRACE_SIZE];
+uint16_t Trace_index = 0;
+volatile bool Trace_paused = false;
+volatile uint8_t Trace_wraps = 0;
+
+static Task dump_task;
+
+static const uint8_t hex[16] = "0123456789ABCDEF";
+
+static void Trace_clear(void)
+{
+    uint16_t i;
+
+    for (i = 0; i < TRACE_SIZE; i++)
+        Trace_buffer[i].event = TRACE_NONE;
+    Trace_index = 0;
+}
+
+// One "EE WWTTTT" line per record in hex, oldest first, between begin and
+// end markers
+static void Trace_dump(void)
+{
+    static const uint8_t begin[] = "TRACE BEGIN\r\n";
+    static const uint8_t end[] = "TRACE END\r\n";
+    uint8_t line[11];
+    uint16_t i;
+
+    // records from the transmit ISR would overwrite what is being sent
+    Trace_paused = true;
+    UART_transmitStringAsync(EUSCI_A0_BASE, begin);
+    for (i = 0; i < TRACE_SIZE; i++) {
+        const TraceRecord* record =
+                &Trace_buffer[(Trace_index + i) & (TRACE_SIZE - 1)];
+
+        if (record->event == TRACE_NONE)
+            continue;
+        line[0] = hex[(record->event >> 4) & 0xF];
+        line[1] = hex[record->event & 0xF];
+        line[2] = ' ';
+        line[3] = hex[record->wraps >> 4];
+        line[4] = hex[record->wraps & 0xF];
+        line[5] = hex[record->time >> 12];
+        line[6] = hex[(record->time >> 8) & 0xF];
+        line[7] = hex[(record->time >> 4) & 0xF];
+        line[8] = hex[record->time & 0xF];
+        line[9] = '\r';
+        line[10] = '\n';
+        UART_transmitArrayAsync(EUSCI_A0_BASE, line, sizeof(line));
+    }
+    UART_transmitStringAsync(EUSCI_A0_BASE, end);
+
+    __disable_interrupt();
+    Trace_clear();
+    Trace_paused = false;
+    __enable_interrupt();
+}
+
+void Trace_init(void)
+{
+    Timer_B_initContinuousModeParam param = { 0 };
+    param.clockSource = TIMER_B_CLOCKSOURCE_SMCLK;
+    param.clockSourceDivider = TIMER_B_CLOCKSOURCE_DIVIDER_1;
+    param.timerInterruptEnable_TBIE = TIMER_B_TBIE_INTERRUPT_ENABLE;
+    param.timerClear = TIMER_B_DO_CLEAR;
+    param.startTimer = true;
+    Timer_B_initContinuousMode(TIMER_B0_BASE, &param);
+
+    Trace_clear();
+    dump_task.run = Trace_dump;
+}
+
+bool Trace_requestDump(void)
+{
+    return Scheduler_post(&dump_task);
+}
+
+//******************************************************************************
+//
+//This is the TIMER0_B1 interrupt vector service routine, counts the TB0 wraps
+//for the trace timestamps.
+//
+//******************************************************************************
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER0_B1_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(TIMER0_B1_VECTOR)))
+#endif
+void TIMER0_B1_ISR (void)
+{
+    switch (__even_in_range(TB0IV, TBIV__TBIFG))
+    {
+    case TBIV__TBIFG:
+        Trace_wraps++;
+        break;
+    default:
+        break;
+    }
+}
+
+#endif
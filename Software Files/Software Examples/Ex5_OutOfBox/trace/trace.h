@@ -0,0 +1,100 @@
+/*
+ * trace.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "driverlib.h"
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+// Uncomment to record trace events. Disabled, every macro below is empty
+// and nothing is linked in.
+//#define TRACE_ENABLE
+
+// Stage ids, TRACE_END sets TRACE_END_BIT on the id of its TRACE_BEGIN.
+// tools/trace_decode.py reads the names from here.
+#define TRACE_ISR_TIMER0_A0     (0x01)
+#define TRACE_ISR_TIMER0_A1     (0x02)
+#define TRACE_ISR_USCI_A0       (0x03)
+#define TRACE_ISR_USCI_A3       (0x04)
+#define TRACE_ISR_USCI_B2       (0x05)
+#define TRACE_ISR_ADC12         (0x06)
+#define TRACE_ISR_DMA           (0x07)
+#define TRACE_ISR_AES256        (0x08)
+#define TRACE_TASK_I2C          (0x10)
+#define TRACE_TASK_ADC          (0x11)
+#define TRACE_TASK_REPORT       (0x12)
+#define TRACE_I2C_WAIT          (0x13)
+#define TRACE_ADC_WAIT          (0x14)
+#define TRACE_UART_TRANSMIT     (0x15)
+#define TRACE_FORMAT            (0x16)
+#define TRACE_END_BIT           (0x80)
+
+// Records are (id, wraps, TB0R). TB0 counts SMCLK cycles, which are MCLK
+// cycles here, and wraps every 8 ms; its overflow ISR counts the wraps,
+// whose low byte makes the timestamp 24 bits, 2 s. SMCLK keeps running in
+// LPM0, so the I2C and ESP32 waits there are counted, at the cost of a
+// wake every 8 ms. TB0 stops with SMCLK in LPM3.
+#define TRACE_HZ (8000000)
+// power of two
+#define TRACE_SIZE (128)
+// received on the backchannel (UCA0), dumps and clears the buffer
+#define TRACE_DUMP_COMMAND ('~')
+
+#ifdef TRACE_ENABLE
+
+typedef struct {
+    uint8_t event;
+    uint8_t wraps;
+    uint16_t time;
+} TraceRecord;
+
+extern TraceRecord Trace_buffer[TRACE_SIZE];
+extern uint16_t Trace_index;
+extern volatile bool Trace_paused;
+extern volatile uint8_t Trace_wraps;
+
+// Interrupts must be disabled, as they are in an ISR. TBIFG still set with
+// a small count is a wrap the overflow ISR has not counted yet.
+#define TRACE_RECORD(id) do { \
+        uint16_t trace_time = TB0R; \
+        uint8_t trace_wraps = Trace_wraps; \
+        if ((TB0CTL & TBIFG) && trace_time < 0x8000) \
+            trace_wraps++; \
+        if (!Trace_paused) { \
+            TraceRecord* trace_record = \
+                    &Trace_buffer[Trace_index++ & (TRACE_SIZE - 1)]; \
+            trace_record->event = (id); \
+            trace_record->wraps = trace_wraps; \
+            trace_record->time = trace_time; \
+        } \
+    } while (0)
+
+#define TRACE_ISR_BEGIN(id) TRACE_RECORD(id)
+#define TRACE_ISR_END(id) TRACE_RECORD((id) | TRACE_END_BIT)
+
+// From main, keeps interrupts out while the record is written
+#define TRACE_BEGIN(id) do { \
+        uint16_t trace_state = __get_interrupt_state(); \
+        __disable_interrupt(); \
+        TRACE_RECORD(id); \
+        __set_interrupt_state(trace_state); \
+    } while (0)
+#define TRACE_END(id) TRACE_BEGIN((id) | TRACE_END_BIT)
+
+// Starts TB0 from SMCLK with its overflow interrupt
+void Trace_init(void);
+// Called from the UCA0 ISR, returns true to wake main
+bool Trace_requestDump(void);
+
+#else
+
+#define TRACE_ISR_BEGIN(id)
+#define TRACE_ISR_END(id)
+#define TRACE_BEGIN(id)
+#define TRACE_END(id)
+
+#endif
+
+#endif /* TRACE_H_ */
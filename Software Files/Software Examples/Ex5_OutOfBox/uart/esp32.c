@@ -7,42 +7,553 @@
 #include "esp32.h"
 #include "i2c/sht35.h"
 #include "adc/adc.h"
+#include "aes/aes_ctr.h"
+#include "scheduler/scheduler.h"
+#include "timers.h"
 #include <string.h>
 
 extern uint8_t UART_buffer[];
-extern uint8_t RXDATA[];
 extern uint16_t ADC_A4_value;
 
+// The ESP32 answers "ERR: No wifi" / "ERR: Device not connected" to
+// telemetry it could not forward. link_errors counts those answers and the
+// frames given up on, so the sender can tell whether anything failed since
+// a given point.
+static volatile bool link_down = false;
+static volatile uint16_t link_errors = 0;
+// Last configuration line ("CFG+...") from the ESP32, NUL terminated. The
+// ISR only overwrites it once main has taken it and cleared config_ready.
+static uint8_t config_line[UART_LINE_SIZE];
+static volatile bool config_ready = false;
+// AT commands sent and not answered yet
+static volatile uint8_t at_pending = 0;
+
+// Binary frames sent and not answered yet. A slot keeps the frame as it
+// went out, encrypted if AES_CTR, so sending it again uses no keystream.
+// SEQ tells the slots apart: it wraps at 256, far more than ESP32_WINDOW.
+#define ESP32_SLOT_SIZE     (FRAME_BLOCK_MAX_SIZE + FRAME_ENCRYPTED_SIZE)
+#define ESP32_SLOT_FREE     (0)
+#define ESP32_SLOT_BUILDING (1)     // taken, the frame is being built
+#define ESP32_SLOT_SENT     (2)     // waiting for the answer
+#define ESP32_SLOT_RESEND   (3)     // answered "Bad frame", to be sent again
+
+typedef struct {
+	uint8_t data[ESP32_SLOT_SIZE];
+	uint8_t length;
+	uint8_t seq;
+	uint8_t tries;
+	volatile uint8_t state;
+	uint32_t sent;		// timer_now() when it last went out
+} ESP32_Slot;
+
+static ESP32_Slot window[ESP32_WINDOW];
+#ifdef ESP32_TX_DMA
+// The slot the DMA sent from last. It may still be streaming out after an
+// answer to an earlier copy of the frame freed the slot.
+static ESP32_Slot* dma_slot = 0;
+#endif
+// an answer arrived since main last looked, main sleeps waiting for one
+static volatile bool answered = false;
+static volatile bool waiting = false;
+
+static void ESP32_retransmit(void);
+static Task retry_task = { .run = ESP32_retransmit };
+
+// A bit per SEQ for the frames given up on or refused, see
+// ESP32_frameFailed. The ISR sets bits, main clears one when it sends its
+// SEQ again.
+static uint8_t failed[256 / 8];
+
+static uint8_t frame_seq = 0;
+static FrameBlock block;
+static ESP32_Slot* block_slot = 0;
+
+#ifdef ESP32_TX_DMA
+static uint8_t frame[ESP32_FRAME_SIZE];
+
+// Append string to frame at length, truncating at the end of the buffer.
+static uint16_t ESP32_append(uint16_t length, const uint8_t* string) {
+	while (*string != '\0' && length < ESP32_FRAME_SIZE) {
+		frame[length++] = *string++;
+	}
+	return length;
+}
+#endif
+
+// Called with interrupts disabled or from the ISR
+static void ESP32_fail(uint8_t seq) {
+	failed[seq >> 3] |= 1 << (seq & 7);
+}
+
+static void ESP32_clearFailed(uint8_t seq) {
+	uint16_t state = __get_interrupt_state();
+	__disable_interrupt();
+	failed[seq >> 3] &= ~(1 << (seq & 7));
+	__set_interrupt_state(state);
+}
+
+// One more AT command to be answered
+static void ESP32_expectAnswer(void) {
+	uint16_t state = __get_interrupt_state();
+	__disable_interrupt();
+	at_pending++;
+	__set_interrupt_state(state);
+}
+
+// Earliest time a frame is due to be sent again, false if no frame is
+// waiting for its answer
+static bool ESP32_due(uint32_t* due) {
+	bool any = false;
+	uint32_t time;
+	uint8_t i;
+
+	for (i = 0; i < ESP32_WINDOW; i++) {
+		if (window[i].state == ESP32_SLOT_SENT)
+			time = window[i].sent + TIMER_MS(ESP32_ACK_TIMEOUT_MS);
+		else if (window[i].state == ESP32_SLOT_RESEND)
+			time = timer_now();
+		else
+			continue;
+		if (!any || (int32_t) (time - *due) < 0)
+			*due = time;
+		any = true;
+	}
+	return any;
+}
+
+// Releases the retry task when the next frame is due
+static void ESP32_armRetry(void) {
+	uint32_t now = timer_now();
+	uint32_t due;
+
+	if (!ESP32_due(&due)) {
+		Scheduler_cancel(&retry_task);
+		return;
+	}
+	Scheduler_after(&retry_task, (int32_t) (due - now) > 0 ? due - now : 0,
+			TIMER_MS(ESP32_ACK_TIMEOUT_MS));
+}
+
+// Sends the bytes of a slot already marked ESP32_SLOT_SENT. An answer may
+// free it meanwhile; the copy then goes out for nothing and is answered
+// again.
+static void ESP32_transmit(ESP32_Slot* slot) {
+#ifdef ESP32_TX_DMA
+	UART_waitDMA();
+	slot->sent = timer_now();
+	dma_slot = slot;
+	UART_transmitAsyncDMA(EUSCI_A3_BASE, slot->data, slot->length, 0);
+#else
+	slot->sent = timer_now();
+	UART_transmitArrayAsync(EUSCI_A3_BASE, slot->data, slot->length);
+#endif
+}
+
+// Sends the frames that are due again. One sent ESP32_TRIES times is given
+// up on; the ESP32 is taken to be down, as when it has no WiFi.
+static void ESP32_retransmit(void) {
+	uint32_t now = timer_now();
+	uint16_t state = __get_interrupt_state();
+	ESP32_Slot* slot;
+	bool due;
+	uint8_t i;
+
+	for (i = 0; i < ESP32_WINDOW; i++) {
+		slot = &window[i];
+		__disable_interrupt();
+		due = slot->state == ESP32_SLOT_RESEND
+				|| (slot->state == ESP32_SLOT_SENT
+						&& (int32_t) (now - slot->sent)
+								>= (int32_t) TIMER_MS(ESP32_ACK_TIMEOUT_MS));
+		if (due && slot->tries >= ESP32_TRIES) {
+			slot->state = ESP32_SLOT_FREE;
+			ESP32_fail(slot->seq);
+			link_down = true;
+			link_errors++;
+			due = false;
+		}
+		// in the same critical section, or an answer that comes before the
+		// copy goes out would be overwritten
+		if (due) {
+			slot->tries++;
+			slot->state = ESP32_SLOT_SENT;
+		}
+		__set_interrupt_state(state);
+		if (due)
+			ESP32_transmit(slot);
+	}
+	ESP32_armRetry();
+}
+
+// CCR0 reached the time ESP32_sleep waits for
+static bool ESP32_wake(void) {
+	return waiting;
+}
+
+// Sleeps until an answer arrives or until time, returns at once if one
+// arrived since the last call
+static void ESP32_sleep(uint32_t time) {
+	uint16_t state = __get_interrupt_state();
+	__disable_interrupt();
+	// replaces the scheduler's wake, which it arms again before it sleeps
+	if (!answered && timer_wakeAt(time, ESP32_wake)) {
+		waiting = true;
+		__bis_SR_register(LPM0_bits + GIE);
+		__disable_interrupt();
+		waiting = false;
+	}
+	answered = false;
+	__set_interrupt_state(state);
+}
+
+// Takes a free slot for the next frame. While the window is full it waits
+// for answers and sends again what is due.
+static ESP32_Slot* ESP32_takeSlot(void) {
+	uint32_t due;
+	uint8_t i;
+
+	while (1) {
+		for (i = 0; i < ESP32_WINDOW; i++) {
+			if (window[i].state == ESP32_SLOT_FREE) {
+				window[i].state = ESP32_SLOT_BUILDING;
+#ifdef ESP32_TX_DMA
+				// the next frame is built where the DMA may still read
+				if (&window[i] == dma_slot)
+					UART_waitDMA();
+#endif
+				return &window[i];
+			}
+		}
+		if (ESP32_due(&due))
+			ESP32_sleep(due);
+		ESP32_retransmit();
+	}
+}
+
+// Sends a finished binary frame, encrypted first with AES_CTR. It stays in
+// its slot until answered. Returns its SEQ.
+static uint8_t ESP32_sendSlot(ESP32_Slot* slot) {
+#ifdef AES_CTR
+	slot->length = Frame_encrypt(slot->data, slot->length, AesCtr_apply);
+#endif
+	slot->seq = slot->data[3];
+	slot->tries = 1;
+	ESP32_clearFailed(slot->seq);
+	// the ISR does not look at a slot being built
+	slot->state = ESP32_SLOT_SENT;
+	ESP32_transmit(slot);
+	ESP32_armRetry();
+	return slot->seq;
+}
+
+void ESP32_flush(void) {
+	uint32_t due;
+
+	while (ESP32_due(&due)) {
+		ESP32_sleep(due);
+		ESP32_retransmit();
+	}
+}
+
 void ESP32_ssid(uint8_t* ssid) {
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "AT+ssid=");
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, ssid);
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "\r");
+	ESP32_expectAnswer();
+	UART_transmitStringAsync(EUSCI_A3_BASE, "AT+ssid=");
+	UART_transmitStringAsync(EUSCI_A3_BASE, ssid);
+	UART_transmitStringAsync(EUSCI_A3_BASE, "\r");
 }
 
 void ESP32_pass(uint8_t* pass) {
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "AT+pass=");
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, pass);
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "\r");
+	ESP32_expectAnswer();
+	UART_transmitStringAsync(EUSCI_A3_BASE, "AT+pass=");
+	UART_transmitStringAsync(EUSCI_A3_BASE, pass);
+	UART_transmitStringAsync(EUSCI_A3_BASE, "\r");
 }
 void ESP32_connString(uint8_t* connString) {
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "AT+connString=");
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, connString);
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "\r");
+	ESP32_expectAnswer();
+	UART_transmitStringAsync(EUSCI_A3_BASE, "AT+connString=");
+	UART_transmitStringAsync(EUSCI_A3_BASE, connString);
+	UART_transmitStringAsync(EUSCI_A3_BASE, "\r");
+}
+#ifdef ESP32_TX_DMA
+// Terminates the command in frame and starts the DMA transfer. A command
+// that filled frame may have been truncated and leaves no room for the
+// terminator: it is not sent, the ESP32 would act on what arrived.
+static bool ESP32_sendFrame(uint16_t length) {
+	if (length >= ESP32_FRAME_SIZE)
+		return false;
+	frame[length++] = '\r';
+	ESP32_expectAnswer();
+	UART_transmitAsyncDMA(EUSCI_A3_BASE, frame, length, 0);
+	return true;
+}
+#endif
+
+bool ESP32_telemetry(uint8_t* telemetry, uint8_t* value) {
+#ifdef ESP32_TX_DMA
+	// the previous frame may still be streaming out of the buffer
+	UART_waitDMA();
+	uint16_t length = ESP32_append(0, "AT+telemetry=");
+	length = ESP32_append(length, telemetry);
+	length = ESP32_append(length, ",");
+	length = ESP32_append(length, value);
+	return ESP32_sendFrame(length);
+#else
+	ESP32_expectAnswer();
+	UART_transmitStringAsync(EUSCI_A3_BASE, "AT+telemetry=");
+	UART_transmitStringAsync(EUSCI_A3_BASE, telemetry);
+	UART_transmitByteAsync(EUSCI_A3_BASE, ',');
+	UART_transmitStringAsync(EUSCI_A3_BASE, value);
+	UART_transmitStringAsync(EUSCI_A3_BASE, "\r");
+	return true;
+#endif
+}
+
+// All readings of one cycle in one command, published as one message
+bool ESP32_telemetryBatch(uint8_t* telemetry[], uint8_t* value[],
+		uint8_t count) {
+	uint8_t i;
+	if (count > ESP32_BATCH_MAX) {
+		count = ESP32_BATCH_MAX;
+	}
+#ifdef ESP32_TX_DMA
+	UART_waitDMA();
+	uint16_t length = ESP32_append(0, "AT+batch=");
+	for (i = 0; i < count; i++) {
+		if (i > 0) {
+			length = ESP32_append(length, ";");
+		}
+		length = ESP32_append(length, telemetry[i]);
+		length = ESP32_append(length, ",");
+		length = ESP32_append(length, value[i]);
+	}
+	return ESP32_sendFrame(length);
+#else
+	ESP32_expectAnswer();
+	UART_transmitStringAsync(EUSCI_A3_BASE, "AT+batch=");
+	for (i = 0; i < count; i++) {
+		if (i > 0) {
+			UART_transmitByteAsync(EUSCI_A3_BASE, ';');
+		}
+		UART_transmitStringAsync(EUSCI_A3_BASE, telemetry[i]);
+		UART_transmitByteAsync(EUSCI_A3_BASE, ',');
+		UART_transmitStringAsync(EUSCI_A3_BASE, value[i]);
+	}
+	UART_transmitStringAsync(EUSCI_A3_BASE, "\r");
+	return true;
+#endif
+}
+
+uint8_t ESP32_telemetryFrame(uint8_t channel, uint16_t value) {
+	ESP32_Slot* slot = ESP32_takeSlot();
+	slot->length = Frame_encode(slot->data, channel, frame_seq++, value);
+	return ESP32_sendSlot(slot);
+}
+
+uint8_t ESP32_telemetryFrameAged(uint8_t channel, uint16_t value,
+		uint32_t age) {
+	ESP32_Slot* slot = ESP32_takeSlot();
+	slot->length = Frame_encodeAged(slot->data, channel, frame_seq++, value,
+			age);
+	return ESP32_sendSlot(slot);
+}
+
+uint8_t ESP32_blockBegin(void) {
+	block_slot = ESP32_takeSlot();
+	Frame_blockBegin(&block, block_slot->data, frame_seq);
+	return frame_seq;
+}
+
+bool ESP32_blockAdd(uint8_t channel, uint16_t value, uint32_t age) {
+	return Frame_blockAdd(&block, channel, value, age);
+}
+
+void ESP32_blockSend(void) {
+	if (block_slot == 0)
+		return;
+	// an empty block uses up its SEQ as well, which then never fails
+	if (Frame_blockCount(&block) == 0) {
+		block_slot->state = ESP32_SLOT_FREE;
+		ESP32_clearFailed(frame_seq);
+	} else {
+		block_slot->length = Frame_blockEnd(&block);
+		ESP32_sendSlot(block_slot);
+	}
+	frame_seq++;
+	block_slot = 0;
 }
-void ESP32_telemetry(uint8_t* telemetry, uint8_t* value) {
 
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "AT+telemetry=");
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, telemetry);
-	EUSCI_A_UART_transmitData(EUSCI_A3_BASE, ',');
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, value);
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "\r");
+uint8_t ESP32_telemetrySummary(uint8_t channel, const StatsSummary* summary) {
+	ESP32_Slot* slot = ESP32_takeSlot();
+	slot->length = Frame_encodeSummary(slot->data, channel, frame_seq++,
+			summary);
+	return ESP32_sendSlot(slot);
+}
+
+bool ESP32_frameFailed(uint8_t seq) {
+	return (failed[seq >> 3] & (1 << (seq & 7))) != 0;
+}
+
+bool ESP32_isLinkDown(void) {
+	return link_down;
+}
 
+uint16_t ESP32_linkErrors(void) {
+	return link_errors;
+}
+
+bool ESP32_getConfig(uint8_t line[]) {
+	if (!config_ready)
+		return false;
+	memcpy(line, config_line, UART_LINE_SIZE);
+	config_ready = false;
+	return true;
 }
 
 void ESP32_mode(uint8_t mode) {
-	EUSCI_A_UART_transmitString(EUSCI_A3_BASE, "AT+mode=");
-	EUSCI_A_UART_transmitData(EUSCI_A3_BASE, mode);
-	EUSCI_A_UART_transmitData(EUSCI_A3_BASE, '\r');
+	ESP32_expectAnswer();
+	UART_transmitStringAsync(EUSCI_A3_BASE, "AT+mode=");
+	UART_transmitByteAsync(EUSCI_A3_BASE, mode);
+	UART_transmitByteAsync(EUSCI_A3_BASE, '\r');
+
+}
+
+bool ESP32_waitForOK(void) {
+	uint32_t end = timer_now() + TIMER_MS(ESP32_AT_TIMEOUT_MS);
+	uint16_t state;
+
+	while (at_pending > 0) {
+		if ((int32_t) (timer_now() - end) >= 0) {
+			state = __get_interrupt_state();
+			__disable_interrupt();
+			at_pending = 0;
+			__set_interrupt_state(state);
+			return false;
+		}
+		ESP32_sleep(end);
+	}
+	return true;
+}
+
+// true if line[0..length) starts with prefix
+static bool ESP32_startsWith(const uint8_t line[], uint8_t length,
+		const char* prefix) {
+	uint8_t i;
+	for (i = 0; prefix[i] != '\0'; i++) {
+		if (i >= length || line[i] != (uint8_t) prefix[i])
+			return false;
+	}
+	return true;
+}
+
+// Parses "<prefix><seq>" at the start of line. Returns its length, 0 if
+// line does not start that way.
+static uint8_t ESP32_parseSeq(const uint8_t line[], uint8_t length,
+		const char* prefix, uint8_t* seq) {
+	uint8_t start = strlen(prefix);
+	uint8_t i = start;
+	uint16_t value = 0;
 
+	if (!ESP32_startsWith(line, length, prefix))
+		return 0;
+	while (i < length && i - start < 3 && line[i] >= '0' && line[i] <= '9')
+		value = value * 10 + (line[i++] - '0');
+	if (i == start || value > 0xFF)
+		return 0;
+	*seq = value;
+	return i;
 }
 
+// Lines the ESP32 sends on its own. They may come while an AT command
+// waits for its answer and are no answer to it.
+static const char* const notices[] = { "ERR: Could not connect", "WiFi",
+		"Batch too long" };
+
+static bool ESP32_isNotice(const uint8_t line[], uint8_t length) {
+	uint8_t i;
+	for (i = 0; i < sizeof(notices) / sizeof(notices[0]); i++) {
+		if (ESP32_startsWith(line, length, notices[i]))
+			return true;
+	}
+	return false;
+}
+
+// The answer to frame seq, reason is 0 for "OK" or the rest of an "ERR"
+// line from the colon on. An answer to a frame given up on is ignored.
+static bool ESP32_answer(uint8_t seq, const uint8_t reason[],
+		uint8_t length) {
+	ESP32_Slot* slot = 0;
+	bool wake = false;
+	uint8_t i;
+
+	for (i = 0; i < ESP32_WINDOW; i++) {
+		if ((window[i].state == ESP32_SLOT_SENT
+				|| window[i].state == ESP32_SLOT_RESEND)
+				&& window[i].seq == seq)
+			slot = &window[i];
+	}
+	if (slot == 0)
+		return false;
+	if (reason == 0) {
+		slot->state = ESP32_SLOT_FREE;
+		link_down = false;
+	} else if (ESP32_startsWith(reason, length, ": Bad frame")) {
+		// garbled on the wire, send it again
+		slot->state = ESP32_SLOT_RESEND;
+		wake = Scheduler_post(&retry_task);
+	} else {
+		slot->state = ESP32_SLOT_FREE;
+		// sending an unknown channel again would not help either
+		if (!ESP32_startsWith(reason, length, ": Unknown")) {
+			ESP32_fail(seq);
+			link_errors++;
+		}
+		if (ESP32_startsWith(reason, length, ": No wifi")
+				|| ESP32_startsWith(reason, length, ": Device"))
+			link_down = true;
+	}
+	answered = true;
+	return wake || waiting;
+}
+
+bool ESP32_receiveLine(const uint8_t line[], uint8_t length) {
+	uint8_t seq;
+	uint8_t n;
+
+	n = ESP32_parseSeq(line, length, "OK ", &seq);
+	if (n != 0 && n == length)
+		return ESP32_answer(seq, 0, 0);
+	n = ESP32_parseSeq(line, length, "ERR ", &seq);
+	if (n != 0 && n < length && line[n] == ':')
+		return ESP32_answer(seq, line + n, length - n);
+
+	if (ESP32_startsWith(line, length, "CFG+")) {
+		// a full buffer may be a truncated line
+		if (!config_ready && length < UART_LINE_SIZE) {
+			memcpy(config_line, line, length);
+			config_line[length] = '\0';
+			config_ready = true;
+		}
+		return false;
+	}
+	if (ESP32_isNotice(line, length))
+		return false;
+	if (length == 2 && line[0] == 'O' && line[1] == 'K') {
+		link_down = false;
+	} else if (ESP32_startsWith(line, length, "ERR")) {
+		if (ESP32_startsWith(line, length, "ERR: No wifi")
+				|| ESP32_startsWith(line, length, "ERR: Device")) {
+			link_down = true;
+			link_errors++;
+		}
+	} else if (!(length == 1 && line[0] == '?')) {
+		// echo or the value of a query, the answer follows
+		return false;
+	}
+	// an AT command answered, unless none is waiting: then the answer came
+	// after ESP32_waitForOK gave up on it
+	if (at_pending == 0)
+		return false;
+	at_pending--;
+	answered = true;
+	return waiting;
+}
@@ -5,10 +5,38 @@
  *      Author: Caleb
  */
 #include "uart.h"
+#include "frame.h"
 
 #ifndef ESP32_H_
 #define ESP32_H_
 
+// Stream telemetry frames to the ESP32 with DMA instead of the TX ring
+#define ESP32_TX_DMA
+// also holds a block frame, FRAME_BLOCK_MAX_SIZE, encrypted
+#define ESP32_FRAME_SIZE (128)
+
+// Most readings sent in one AT+batch command. The ESP32 publishes the whole
+// batch as one cloud message.
+#define ESP32_BATCH_MAX (8)
+
+// Send readings as binary frames (frame.h). The AT commands are then only
+// used for provisioning.
+#define ESP32_BINARY
+
+// Binary frames are answered by SEQ: "OK <seq>", or "ERR <seq>: <reason>"
+// if the ESP32 could not forward the frame. Up to ESP32_WINDOW frames are
+// sent without waiting for their answers and kept until answered. A frame
+// answered "ERR <seq>: Bad frame", or not at all within
+// ESP32_ACK_TIMEOUT_MS, is sent again, ESP32_TRIES times in all. The ESP32
+// answers a frame it already forwarded "OK <seq>" again without
+// forwarding it twice.
+#define ESP32_WINDOW (8)
+#define ESP32_ACK_TIMEOUT_MS (500)
+#define ESP32_TRIES (3)
+// Longest wait for the answer to an AT command, connecting to the access
+// point or the IoT hub takes seconds
+#define ESP32_AT_TIMEOUT_MS (10000)
+
 void init_ESP32(void);
 void ESP32_transmit_4byte_Array(uint8_t data[4]);
 void ESP32_sendData(void);
@@ -19,15 +47,61 @@ void ESP32_sendData(void);
 // AT+pass="password"
 // AT+connString="connection_string"
 // AT+telemetry="telemetry","value"
+// AT+batch="telemetry","value";"telemetry","value"...
+// AT+batchSize="readings per message"
+// AT+batchDeadline="ms before a partial batch is published"
+// AT+queue (answers "queued,rejected" for the offline replay queue)
+// AT+replayInterval="ms between replay messages"
+// AT+latency (longest ESP32 loop pass in us, AT+latency=0 resets it)
 // AT+addTelemetry="telemetry"
 // AT+removeTelemetry="telemetry"
 // AT+clearTelemetry
 void ESP32_ssid(uint8_t* ssid);
 void ESP32_pass(uint8_t* pass);
 void ESP32_connString(uint8_t* connString);
-void ESP32_telemetry(uint8_t* telemetry, uint8_t* value);
+// The telemetry commands return false, and send nothing, if the command
+// does not fit ESP32_FRAME_SIZE with its terminator
+bool ESP32_telemetry(uint8_t* telemetry, uint8_t* value);
+bool ESP32_telemetryBatch(uint8_t* telemetry[], uint8_t* value[],
+		uint8_t count);
 void ESP32_mode(uint8_t mode);
-void ESP32_waitForOK(void);
+// Binary telemetry, see frame.h. Raw sensor value, no string formatting.
+// The frame functions return the SEQ of the frame, for ESP32_frameFailed.
+uint8_t ESP32_telemetryFrame(uint8_t channel, uint16_t value);
+// Replayed reading taken age seconds ago
+uint8_t ESP32_telemetryFrameAged(uint8_t channel, uint16_t value,
+		uint32_t age);
+// Replayed readings packed into one block frame (frame.h): begin, add
+// readings until ESP32_blockAdd returns false because the block is full,
+// then send. An empty block is not sent, its SEQ never fails.
+uint8_t ESP32_blockBegin(void);
+bool ESP32_blockAdd(uint8_t channel, uint16_t value, uint32_t age);
+void ESP32_blockSend(void);
+// Statistics of one channel over a window, see stats.h
+uint8_t ESP32_telemetrySummary(uint8_t channel, const StatsSummary* summary);
+// true if the frame with SEQ seq was given up on or refused with an
+// "ERR <seq>" other than "Unknown channel" (sending it again would not
+// help). Known once ESP32_flush returns, and until 256 more frames are
+// sent.
+bool ESP32_frameFailed(uint8_t seq);
+// Waits until every frame sent is answered or has failed ESP32_TRIES times.
+// Must not be called from an ISR.
+void ESP32_flush(void);
+// Link state from the ESP32 replies. ESP32_linkErrors is a running count of
+// failed telemetry, frames given up on included; compare two reads to see
+// if anything failed in between.
+bool ESP32_isLinkDown(void);
+uint16_t ESP32_linkErrors(void);
+// Configuration line sent by the ESP32 ("CFG+..."), copied NUL terminated
+// into line, which holds UART_LINE_SIZE bytes. Returns false if there is
+// none since the last call.
+bool ESP32_getConfig(uint8_t line[]);
+// Waits for the answers to the AT commands sent so far. Returns false if
+// one took longer than ESP32_AT_TIMEOUT_MS; it is not waited for again.
+bool ESP32_waitForOK(void);
+// Called by the USCI_A3 ISR with every line the ESP32 sends, without its
+// terminator. Returns true if main is to be woken.
+bool ESP32_receiveLine(const uint8_t line[], uint8_t length);
 
 
 
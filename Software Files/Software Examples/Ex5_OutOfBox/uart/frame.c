@@ -0,0 +1,129 @@
+/*
+ * frame.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "frame.h"
+#include "crc/crc_hw.h"
+#include <string.h>
+
+// Fills in SYNC, LEN and the CRC around payload bytes already written at
+// frame[FRAME_HEADER_SIZE], returns the total length.
+static uint8_t Frame_seal(uint8_t frame[], uint8_t payload) {
+	frame[0] = FRAME_SYNC;
+	frame[1] = payload + FRAME_CRC_SIZE;
+	uint16_t crc = Crc_crc16(frame, FRAME_HEADER_SIZE + payload);
+	frame[FRAME_HEADER_SIZE + payload] = crc & 0xFF;
+	frame[FRAME_HEADER_SIZE + payload + 1] = crc >> 8;
+	return FRAME_HEADER_SIZE + payload + FRAME_CRC_SIZE;
+}
+
+// Writes one frame into frame[FRAME_SIZE] and returns its length.
+uint8_t Frame_encode(uint8_t frame[], uint8_t channel, uint8_t seq,
+		uint16_t value) {
+	frame[2] = channel;
+	frame[3] = seq;
+	frame[4] = value & 0xFF;
+	frame[5] = value >> 8;
+	return Frame_seal(frame, FRAME_PAYLOAD_SIZE);
+}
+
+// Same as Frame_encode plus the age of the reading in seconds.
+// frame[] must hold FRAME_MAX_SIZE bytes.
+uint8_t Frame_encodeAged(uint8_t frame[], uint8_t channel, uint8_t seq,
+		uint16_t value, uint32_t age) {
+	frame[2] = channel;
+	frame[3] = seq;
+	frame[4] = value & 0xFF;
+	frame[5] = value >> 8;
+	frame[6] = age & 0xFF;
+	frame[7] = (age >> 8) & 0xFF;
+	frame[8] = (age >> 16) & 0xFF;
+	frame[9] = age >> 24;
+	return Frame_seal(frame, FRAME_PAYLOAD_SIZE + FRAME_AGE_SIZE);
+}
+
+// Summary of a window, the mean takes the place of the value.
+// frame[] must hold FRAME_MAX_SIZE bytes.
+uint8_t Frame_encodeSummary(uint8_t frame[], uint8_t channel, uint8_t seq,
+		const StatsSummary* summary) {
+	frame[2] = channel;
+	frame[3] = seq;
+	frame[4] = summary->mean & 0xFF;
+	frame[5] = summary->mean >> 8;
+	frame[6] = summary->min & 0xFF;
+	frame[7] = summary->min >> 8;
+	frame[8] = summary->max & 0xFF;
+	frame[9] = summary->max >> 8;
+	frame[10] = summary->count & 0xFF;
+	frame[11] = summary->count >> 8;
+	frame[12] = summary->variance & 0xFF;
+	frame[13] = (summary->variance >> 8) & 0xFF;
+	frame[14] = (summary->variance >> 16) & 0xFF;
+	frame[15] = summary->variance >> 24;
+	return Frame_seal(frame, FRAME_PAYLOAD_SIZE + FRAME_SUMMARY_SIZE);
+}
+
+void Frame_blockBegin(FrameBlock* block, uint8_t frame[], uint8_t seq) {
+	uint8_t i;
+	block->frame = frame;
+	block->length = FRAME_HEADER_SIZE + FRAME_BLOCK_HEADER;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		Delta_init(&block->value[i]);
+	}
+	Delta_init(&block->age);
+	frame[2] = FRAME_BLOCK;
+	frame[3] = seq;
+	frame[4] = 0;
+}
+
+bool Frame_blockAdd(FrameBlock* block, uint8_t channel, uint16_t value,
+		uint32_t age) {
+	uint16_t size = FRAME_HEADER_SIZE + FRAME_BLOCK_HEADER
+			+ FRAME_BLOCK_RECORDS;
+	uint16_t length = block->length;
+	DeltaState value_state;
+	DeltaState age_state;
+
+	if (channel >= CHANNEL_COUNT)
+		return true;
+	if (length >= size)
+		return false;
+	// on a partial record the block keeps its old state
+	value_state = block->value[channel];
+	age_state = block->age;
+	block->frame[length++] = channel;
+	if (!Delta_put(&value_state, value, block->frame, &length, size)
+			|| !Delta_put(&age_state, age, block->frame, &length, size))
+		return false;
+	block->value[channel] = value_state;
+	block->age = age_state;
+	block->length = length;
+	block->frame[4]++;
+	return true;
+}
+
+uint8_t Frame_blockCount(const FrameBlock* block) {
+	return block->frame[4];
+}
+
+uint8_t Frame_blockEnd(FrameBlock* block) {
+	return Frame_seal(block->frame, block->length - FRAME_HEADER_SIZE);
+}
+
+uint8_t Frame_encrypt(uint8_t frame[], uint8_t length, FrameCipher cipher) {
+	// payload bytes after SEQ
+	uint8_t rest = length - FRAME_HEADER_SIZE - 2 - FRAME_CRC_SIZE;
+	uint32_t position;
+
+	memmove(&frame[9], &frame[4], rest);
+	frame[8] = frame[2];
+	frame[2] = FRAME_ENCRYPTED;
+	position = cipher(&frame[8], rest + 1);
+	frame[4] = position & 0xFF;
+	frame[5] = (position >> 8) & 0xFF;
+	frame[6] = (position >> 16) & 0xFF;
+	frame[7] = position >> 24;
+	return Frame_seal(frame, length - FRAME_HEADER_SIZE - FRAME_CRC_SIZE
+			+ FRAME_ENCRYPTED_SIZE);
+}
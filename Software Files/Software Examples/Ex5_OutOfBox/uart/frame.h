@@ -0,0 +1,108 @@
+/*
+ * frame.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "driverlib.h"
+#include "stats/stats.h"
+#include "codec/delta.h"
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+// Binary telemetry frame sent to the ESP32 instead of AT+telemetry.
+// The ESP32 firmware has a matching decoder in frame.h/frame.cpp.
+//
+//   [SYNC][LEN][CHANNEL][SEQ][VALUE_L][VALUE_H][CRC_L][CRC_H]
+//
+// LEN counts the bytes from CHANNEL up to the CRC. VALUE is the raw sensor
+// reading, little endian; the ESP32 converts it to engineering units.
+// CRC is CRC-16/CCITT-FALSE (poly 0x1021, seed 0xFFFF) over SYNC..VALUE_H,
+// see crc/crc_hw.h.
+// SYNC is not printable, so it cannot start an AT command line.
+//
+// Readings replayed from the FRAM sample log add a 4 byte AGE after VALUE,
+// the seconds between the measurement and sending it (LEN = 10):
+//
+//   [SYNC][LEN][CHANNEL][SEQ][VALUE_L][VALUE_H][AGE0..AGE3][CRC_L][CRC_H]
+//
+// A window summary (stats.h) has the rounded mean as VALUE, followed by
+// MIN, MAX, COUNT and the 4 byte VARIANCE in counts^2 (LEN = 16):
+//
+//   [SYNC][LEN][CHANNEL][SEQ][MEAN][MIN][MAX][COUNT][VARIANCE][CRC_L][CRC_H]
+#define FRAME_SYNC          (0xA5)
+#define FRAME_HEADER_SIZE   (2)
+#define FRAME_PAYLOAD_SIZE  (4)
+#define FRAME_AGE_SIZE      (4)
+#define FRAME_SUMMARY_SIZE  (10)
+#define FRAME_CRC_SIZE      (2)
+#define FRAME_SIZE          (FRAME_HEADER_SIZE + FRAME_PAYLOAD_SIZE + FRAME_CRC_SIZE)
+#define FRAME_MAX_SIZE      (FRAME_SIZE + FRAME_SUMMARY_SIZE)
+
+// Readings replayed from the sample log are packed into block frames
+// instead. CHANNEL is FRAME_BLOCK and COUNT the number of readings:
+//
+//   [SYNC][LEN][FRAME_BLOCK][SEQ][COUNT][RECORDS...][CRC_L][CRC_H]
+//
+// Each record is the channel byte followed by the value and the age, coded
+// with codec/delta.h. Every channel is its own value series and the ages
+// of all records are one series, so a record of a slowly changing channel
+// takes about three bytes instead of a 12 byte aged frame.
+#define FRAME_BLOCK         (0x80)
+#define FRAME_BLOCK_HEADER  (3)
+#define FRAME_BLOCK_RECORDS (96)
+#define FRAME_BLOCK_MAX_SIZE \
+	(FRAME_HEADER_SIZE + FRAME_BLOCK_HEADER + FRAME_BLOCK_RECORDS + FRAME_CRC_SIZE)
+
+// With AES_CTR (aes/aes_ctr.h) every frame above goes out encrypted.
+// CHANNEL moves behind POSITION, the keystream position of the first
+// encrypted byte, and everything from CHANNEL up to the CRC is encrypted.
+// SEQ stays readable so answers can still be matched to frames, and the
+// CRC covers the encrypted bytes:
+//
+//   [SYNC][LEN][FRAME_ENCRYPTED][SEQ][POSITION0..3][CHANNEL][...][CRC_L][CRC_H]
+//
+// The ESP32 forwards the frame from FRAME_ENCRYPTED up to the CRC as is,
+// only the cloud side has the key. LEN tells the frame types apart again
+// after decryption.
+#define FRAME_ENCRYPTED       (0x40)
+#define FRAME_ENCRYPTED_SIZE  (5)
+
+// Channel ids, must match the channel table in the ESP32 firmware
+#define CHANNEL_TEMPERATURE (0)
+#define CHANNEL_HUMIDITY    (1)
+#define CHANNEL_MOISTURE    (2)
+#define CHANNEL_LIGHT       (3)
+#define CHANNEL_COUNT       (4)
+
+// XORs length bytes of data with keystream, returns the position of the
+// first keystream byte (AesCtr_apply)
+typedef uint32_t (*FrameCipher)(uint8_t data[], uint8_t length);
+
+typedef struct {
+	uint8_t* frame;
+	uint16_t length;	// bytes of the frame written so far
+	DeltaState value[CHANNEL_COUNT];
+	DeltaState age;
+} FrameBlock;
+
+uint8_t Frame_encode(uint8_t frame[], uint8_t channel, uint8_t seq,
+		uint16_t value);
+uint8_t Frame_encodeAged(uint8_t frame[], uint8_t channel, uint8_t seq,
+		uint16_t value, uint32_t age);
+uint8_t Frame_encodeSummary(uint8_t frame[], uint8_t channel, uint8_t seq,
+		const StatsSummary* summary);
+// Block frames: begin, add readings until Frame_blockAdd returns false
+// because the block is full, then seal it with Frame_blockEnd, which returns
+// the total length. frame[] must hold FRAME_BLOCK_MAX_SIZE bytes. Readings
+// of unknown channels are left out.
+void Frame_blockBegin(FrameBlock* block, uint8_t frame[], uint8_t seq);
+bool Frame_blockAdd(FrameBlock* block, uint8_t channel, uint16_t value,
+		uint32_t age);
+uint8_t Frame_blockCount(const FrameBlock* block);
+uint8_t Frame_blockEnd(FrameBlock* block);
+// Encrypts a finished frame of length bytes in place and returns the new
+// length. frame[] must hold FRAME_ENCRYPTED_SIZE bytes more.
+uint8_t Frame_encrypt(uint8_t frame[], uint8_t length, FrameCipher cipher);
+
+#endif /* FRAME_H_ */
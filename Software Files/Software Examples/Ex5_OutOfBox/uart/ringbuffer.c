@@ -0,0 +1,40 @@
+/*
+ * ringbuffer.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include "ringbuffer.h"
+
+void RingBuffer_init(RingBuffer* ring) {
+	ring->head = 0;
+	ring->tail = 0;
+}
+
+bool RingBuffer_put(RingBuffer* ring, uint8_t byte) {
+	uint16_t head = ring->head;
+	if ((uint16_t) (head - ring->tail) >= RINGBUFFER_SIZE) {
+		return false;
+	}
+	ring->data[head & RINGBUFFER_MASK] = byte;
+	// publish the byte only after it has been written
+	ring->head = head + 1;
+	return true;
+}
+
+bool RingBuffer_get(RingBuffer* ring, uint8_t* byte) {
+	uint16_t tail = ring->tail;
+	if (tail == ring->head) {
+		return false;
+	}
+	*byte = ring->data[tail & RINGBUFFER_MASK];
+	ring->tail = tail + 1;
+	return true;
+}
+
+uint16_t RingBuffer_count(const RingBuffer* ring) {
+	return (uint16_t) (ring->head - ring->tail);
+}
+
+uint16_t RingBuffer_space(const RingBuffer* ring) {
+	return RINGBUFFER_SIZE - RingBuffer_count(ring);
+}
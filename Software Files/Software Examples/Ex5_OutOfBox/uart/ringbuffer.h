@@ -0,0 +1,31 @@
+/*
+ * ringbuffer.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef RINGBUFFER_H_
+#define RINGBUFFER_H_
+
+// must be a power of two so the indexes can be masked instead of divided
+#define RINGBUFFER_SIZE (128)
+#define RINGBUFFER_MASK (RINGBUFFER_SIZE - 1)
+
+// Single producer / single consumer byte queue. The producer only writes
+// head and the consumer only writes tail, so one side may run in an ISR
+// without a lock. Both indexes free-run and are masked on access.
+typedef struct {
+	volatile uint16_t head;
+	volatile uint16_t tail;
+	uint8_t data[RINGBUFFER_SIZE];
+} RingBuffer;
+
+void RingBuffer_init(RingBuffer* ring);
+bool RingBuffer_put(RingBuffer* ring, uint8_t byte);
+bool RingBuffer_get(RingBuffer* ring, uint8_t* byte);
+uint16_t RingBuffer_count(const RingBuffer* ring);
+uint16_t RingBuffer_space(const RingBuffer* ring);
+
+#endif /* RINGBUFFER_H_ */
@@ -6,10 +6,48 @@
  */
 
 #include "uart.h"
+#include "esp32.h"
+#include "scheduler/scheduler.h"
 
 uint8_t UART_buffer[3];
 bool client_connected;
-bool ok = false;
+
+typedef struct {
+	RingBuffer ring;
+	volatile bool waiting;  // main is asleep waiting for queue space
+} UART_TxQueue;
+
+static UART_TxQueue tx_a0;
+static UART_TxQueue tx_a3;
+
+static volatile bool dma_busy = false;
+static volatile bool dma_waiting = false;
+static UART_DMACallback dma_callback;
+
+static UART_TxQueue* UART_txQueue(uint16_t base) {
+	return (base == EUSCI_A0_BASE) ? &tx_a0 : &tx_a3;
+}
+
+// Send the next queued byte. Returns true if main was waiting for space and
+// should be woken by the calling ISR.
+static bool UART_serviceTransmit(uint16_t base) {
+	UART_TxQueue* queue = UART_txQueue(base);
+	uint8_t data;
+	if (RingBuffer_get(&queue->ring, &data)) {
+		// TXIE is set, so this writes TXBUF without polling
+		EUSCI_A_UART_transmitData(base, data);
+	} else {
+		// Queue drained. Reading UCAxIV cleared TXIFG although TXBUF is
+		// empty, so set it again: the next put only has to re-enable TXIE.
+		EUSCI_A_UART_disableInterrupt(base, EUSCI_A_UART_TRANSMIT_INTERRUPT);
+		HWREG16(base + OFS_UCAxIFG) |= UCTXIFG;
+	}
+	if (queue->waiting) {
+		queue->waiting = false;
+		return true;
+	}
+	return false;
+}
 
 void UART_initPorts(void) {
 	// Configure UART pins
@@ -53,6 +91,9 @@ void UART_init(uint16_t base) {
 		return;
 	}
 
+	RingBuffer_init(&UART_txQueue(base)->ring);
+	UART_txQueue(base)->waiting = false;
+
 	EUSCI_A_UART_enable(base);
 
 	EUSCI_A_UART_clearInterrupt(base,
@@ -77,6 +118,7 @@ __attribute__((interrupt(USCI_A0_VECTOR)))
 #endif
 void USCI_A0_ISR(void) {
 	uint8_t RXData;
+	TRACE_ISR_BEGIN(TRACE_ISR_USCI_A0);
 	switch (__even_in_range(UCA0IV, USCI_UART_UCTXCPTIFG)) {
 	case USCI_NONE:
 		break;
@@ -84,15 +126,25 @@ void USCI_A0_ISR(void) {
 		RXData = EUSCI_A_UART_receiveData(EUSCI_A0_BASE);
 		// echo back to UCA0
 		//EUSCI_A_UART_transmitData(EUSCI_A0_BASE, RXData);
-		EUSCI_A_UART_transmitData(EUSCI_A3_BASE, RXData);
+#ifdef TRACE_ENABLE
+		if (RXData == TRACE_DUMP_COMMAND) {
+			if (Trace_requestDump())
+				__bic_SR_register_on_exit(SCHEDULER_SLEEP);
+			break;
+		}
+#endif
+		UART_putByte(EUSCI_A3_BASE, RXData);
 		break;
 	case USCI_UART_UCTXIFG:
+		if (UART_serviceTransmit(EUSCI_A0_BASE))
+			__bic_SR_register_on_exit(LPM0_bits);
 		break;
 	case USCI_UART_UCSTTIFG:
 		break;
 	case USCI_UART_UCTXCPTIFG:
 		break;
 	}
+	TRACE_ISR_END(TRACE_ISR_USCI_A0);
 }
 
 //******************************************************************************
@@ -104,36 +156,40 @@ void USCI_A0_ISR(void) {
 #pragma vector=USCI_A3_VECTOR
 __interrupt
 #elif defined(__GNUC__)
-__attribute__((interrupt(USCI_A0_VECTOR)))
+__attribute__((interrupt(USCI_A3_VECTOR)))
 #endif
 void USCI_A3_ISR(void) {
 	uint8_t RXData;
+	// start of the current response line, long enough to tell the answers
+	// apart, see ESP32_receiveLine
+	static uint8_t line[UART_LINE_SIZE];
 	static uint8_t count = 0;
+	TRACE_ISR_BEGIN(TRACE_ISR_USCI_A3);
 	switch (__even_in_range(UCA3IV, USCI_UART_UCTXCPTIFG)) {
 	case USCI_NONE:
 		break;
 	case USCI_UART_UCRXIFG:
 		RXData = EUSCI_A_UART_receiveData(EUSCI_A3_BASE);
-		EUSCI_A_UART_transmitData(EUSCI_A0_BASE, RXData);
-		if (RXData == 'O' && count == 0) {
-			count++;
-		} else if (RXData == 'K' && count == 1) {
-			count++;
-		} else if (RXData == '\r' && count == 2) {
-			count = 0;
-			ok = true;
-		} else {
-			ok = false;
+		UART_putByte(EUSCI_A0_BASE, RXData);
+		if (RXData == '\r' || RXData == '\n') {
+			// count is 0 at the second half of \r\n
+			if (count > 0 && ESP32_receiveLine(line, count))
+				__bic_SR_register_on_exit(SCHEDULER_SLEEP);
 			count = 0;
+		} else if (count < UART_LINE_SIZE) {
+			line[count++] = RXData;
 		}
 		break;
 	case USCI_UART_UCTXIFG:
+		if (UART_serviceTransmit(EUSCI_A3_BASE))
+			__bic_SR_register_on_exit(LPM0_bits);
 		break;
 	case USCI_UART_UCSTTIFG:
 		break;
 	case USCI_UART_UCTXCPTIFG:
 		break;
 	}
+	TRACE_ISR_END(TRACE_ISR_USCI_A3);
 }
 
 void EUSCI_A_UART_transmitString(uint16_t base, uint8_t string[]) {
@@ -150,3 +206,176 @@ void EUSCI_A_UART_transmitArray(uint16_t base, uint8_t data[], int length) {
 	}
 }
 
+// Queue one byte without blocking, returns false if the queue is full.
+// Safe to call from an ISR.
+bool UART_putByte(uint16_t base, uint8_t data) {
+	UART_TxQueue* queue = UART_txQueue(base);
+	// both main and the other port's RX ISR may produce into a queue
+	uint16_t state = __get_interrupt_state();
+	__disable_interrupt();
+	bool queued = RingBuffer_put(&queue->ring, data);
+	// TXIFG is set whenever TXBUF is empty, so this fires right away if idle.
+	// While a DMA transfer owns UCA3 the byte waits, the DMA ISR restarts it.
+	if (!(dma_busy && base == EUSCI_A3_BASE)) {
+		EUSCI_A_UART_enableInterrupt(base, EUSCI_A_UART_TRANSMIT_INTERRUPT);
+	}
+	__set_interrupt_state(state);
+	return queued;
+}
+
+void UART_transmitByteAsync(uint16_t base, uint8_t data) {
+	UART_TxQueue* queue = UART_txQueue(base);
+	uint16_t state = __get_interrupt_state();
+	__disable_interrupt();
+	while (!UART_putByte(base, data)) {
+		// queue full, sleep until the TX ISR frees a slot
+		queue->waiting = true;
+		__bis_SR_register(LPM0_bits + GIE);
+		__disable_interrupt();
+	}
+	__set_interrupt_state(state);
+}
+
+void UART_transmitArrayAsync(uint16_t base, const uint8_t data[],
+		uint16_t length) {
+	uint16_t i;
+	TRACE_BEGIN(TRACE_UART_TRANSMIT);
+	for (i = 0; i < length; i++) {
+		UART_transmitByteAsync(base, data[i]);
+	}
+	TRACE_END(TRACE_UART_TRANSMIT);
+}
+
+void UART_transmitStringAsync(uint16_t base, const uint8_t string[]) {
+	while (*string != '\0') {
+		UART_transmitByteAsync(base, *string++);
+	}
+}
+
+bool UART_isTransmitting(uint16_t base) {
+	return RingBuffer_count(&UART_txQueue(base)->ring) != 0
+			|| (HWREG16(base + OFS_UCAxIE) & UCTXIE)
+			|| EUSCI_A_UART_queryStatusFlags(base, EUSCI_A_UART_BUSY);
+}
+
+bool UART_transmitAsyncDMA(uint16_t base, const uint8_t buffer[],
+		uint16_t length, UART_DMACallback callback) {
+	if (base != EUSCI_A3_BASE || length == 0) {
+		return false;
+	}
+
+	uint16_t state = __get_interrupt_state();
+	__disable_interrupt();
+	if (dma_busy) {
+		__set_interrupt_state(state);
+		return false;
+	}
+	// let the ring buffer finish first, TXIFG can only have one owner
+	while (RingBuffer_count(&tx_a3.ring) != 0
+			|| (HWREG16(base + OFS_UCAxIE) & UCTXIE)) {
+		tx_a3.waiting = true;
+		__bis_SR_register(LPM0_bits + GIE);
+		__disable_interrupt();
+	}
+	dma_busy = true;
+	dma_callback = callback;
+
+	//Initialize DMA channel
+	/*
+	 * Single transfer per trigger, byte to byte
+	 * Triggered on the rising edge of UCA3TXIFG
+	 */
+	DMA_initParam param = { 0 };
+	param.channelSelect = UART_DMA_CHANNEL;
+	param.transferModeSelect = DMA_TRANSFER_SINGLE;
+	param.transferSize = length;
+	param.triggerSourceSelect = UART_DMA_TRIGGER;
+	param.transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE;
+	param.triggerTypeSelect = DMA_TRIGGER_RISINGEDGE;
+	DMA_init(&param);
+
+	DMA_setSrcAddress(UART_DMA_CHANNEL, (uint32_t) (uintptr_t) buffer,
+	DMA_DIRECTION_INCREMENT);
+	DMA_setDstAddress(UART_DMA_CHANNEL,
+			EUSCI_A_UART_getTransmitBufferAddress(base),
+			DMA_DIRECTION_UNCHANGED);
+
+	DMA_clearInterrupt(UART_DMA_CHANNEL);
+	DMA_enableInterrupt(UART_DMA_CHANNEL);
+	DMA_enableTransfers(UART_DMA_CHANNEL);
+
+	// With TXBUF empty TXIFG is already high; pulse it to give the edge
+	// triggered channel its first request. The previous transfer may still
+	// have its last byte in TXBUF (TXIFG low): a pulse now would overwrite
+	// it, and TXIFG rises by itself once that byte moves to the shifter.
+	if (HWREG16(base + OFS_UCAxIFG) & UCTXIFG) {
+		HWREG16(base + OFS_UCAxIFG) &= ~UCTXIFG;
+		HWREG16(base + OFS_UCAxIFG) |= UCTXIFG;
+	}
+
+	__set_interrupt_state(state);
+	return true;
+}
+
+bool UART_isDMABusy(void) {
+	return dma_busy;
+}
+
+void UART_waitDMA(void) {
+	uint16_t state = __get_interrupt_state();
+	__disable_interrupt();
+	while (dma_busy) {
+		dma_waiting = true;
+		__bis_SR_register(LPM0_bits + GIE);
+		__disable_interrupt();
+	}
+	__set_interrupt_state(state);
+}
+
+//******************************************************************************
+//
+//This is the DMA interrupt vector service routine.
+//
+//******************************************************************************
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=DMA_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(DMA_VECTOR)))
+#endif
+void DMA_ISR(void) {
+	TRACE_ISR_BEGIN(TRACE_ISR_DMA);
+	switch (__even_in_range(DMAIV, 16)) {
+	case 0:
+		break;                         // Vector  0:  No interrupt
+	case 2:
+		break;                         // Vector  2:  DMA0IFG
+	case 4:
+		break;                         // Vector  4:  DMA1IFG
+	case 6:
+		break;                         // Vector  6:  DMA2IFG
+	case 8:                            // Vector  8:  DMA3IFG
+		// last byte is in TXBUF, channel disabled itself at size 0
+		dma_busy = false;
+		if (RingBuffer_count(&tx_a3.ring) != 0) {
+			// bytes queued meanwhile, TXIFG hands them to the ring ISR
+			EUSCI_A_UART_enableInterrupt(EUSCI_A3_BASE,
+			EUSCI_A_UART_TRANSMIT_INTERRUPT);
+		}
+		if (dma_callback) {
+			dma_callback();
+		}
+		if (dma_waiting) {
+			dma_waiting = false;
+			__bic_SR_register_on_exit(LPM0_bits);
+		}
+		break;
+	case 10:
+		break;                         // Vector 10:  DMA4IFG
+	case 12:
+		break;                         // Vector 12:  DMA5IFG
+	default:
+		break;
+	}
+	TRACE_ISR_END(TRACE_ISR_DMA);
+}
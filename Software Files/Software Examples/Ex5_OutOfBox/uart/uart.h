@@ -6,15 +6,45 @@
  */
 
 #include "driverlib.h"
+#include "ringbuffer.h"
+#include "trace/trace.h"
 
 #ifndef UART_H_
 #define UART_H_
 
 #define BUFFER_SIZE (16)
+// characters of an ESP32 response line kept for matching, also the longest
+// configuration line plus its NUL
+#define UART_LINE_SIZE (40)
 
 void UART_initPorts(void);
 void UART_init(uint16_t base);
 void EUSCI_A_UART_transmitArray(uint16_t base, uint8_t data[], int length);
 void EUSCI_A_UART_transmitString(uint16_t base, uint8_t string[]);
 
+// Interrupt driven transmit. Bytes are queued in a per-port ring buffer and
+// drained by the TXIFG case of the port ISR, so the caller can go straight
+// back into LPM. The *Async calls only sleep (LPM0) if the queue is full.
+bool UART_putByte(uint16_t base, uint8_t data);
+void UART_transmitByteAsync(uint16_t base, uint8_t data);
+void UART_transmitArrayAsync(uint16_t base, const uint8_t data[], uint16_t length);
+void UART_transmitStringAsync(uint16_t base, const uint8_t string[]);
+bool UART_isTransmitting(uint16_t base);
+
+// DMA driven transmit, UCA3 only. The whole buffer is streamed to UCA3TXBUF
+// by a DMA channel triggered on UCA3TXIFG; the CPU is not involved until the
+// completion interrupt, which calls callback (may be NULL) from the ISR.
+// buffer must stay untouched until then. Returns false if the channel is
+// busy or base is not UCA3.
+#define UART_DMA_CHANNEL (DMA_CHANNEL_3)
+// on the FR5994, trigger 17 of DMA channels 3-5 is UCA3TXIFG
+#define UART_DMA_TRIGGER (DMA_TRIGGERSOURCE_17)
+
+typedef void (*UART_DMACallback)(void);
+
+bool UART_transmitAsyncDMA(uint16_t base, const uint8_t buffer[],
+		uint16_t length, UART_DMACallback callback);
+bool UART_isDMABusy(void);
+void UART_waitDMA(void);
+
 #endif /* UART_H_ */